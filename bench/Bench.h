@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Vault.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A tiny benchmark harness. Each bench/*.cpp file registers its cases with
+// BENCH_CASE; BenchMain.cpp runs all of them, or the ones named on the command
+// line. Numbers passed to report() are also written to --json / --csv files,
+// so runs can be compared over time.
+namespace Bench {
+
+    struct Case {
+        std::string name;
+        std::string description;
+        void (*run)();
+    };
+
+    std::vector<Case>& registry();
+
+    struct Registrar {
+        Registrar(const char* name, const char* description, void (*run)());
+    };
+
+    /**
+     * @brief Runs fn `repeats` times and returns the fastest wall time in milliseconds.
+     */
+    double measureMs(const std::function<void()>& fn, int repeats = 3);
+
+    /**
+     * @brief Builds `count` entries with realistic field lengths and unique ids.
+     */
+    std::vector<PasswordEntry> makeEntries(size_t count);
+
+    /**
+     * @brief The shape of a synthetic vault, set from the command line
+     * (--entries, --seed, --title-len, ...). Lengths are averages; each field
+     * varies by up to a quarter either way.
+     */
+    struct VaultSpec {
+        size_t entries = 10000;
+        uint64_t seed = 42;
+        size_t titleLength = 24;
+        size_t usernameLength = 20;
+        size_t passwordLength = 20;
+        size_t urlLength = 40;
+        size_t notesLength = 80;
+    };
+
+    VaultSpec& vaultSpec();
+
+    /**
+     * @brief Builds a vault's worth of entries from a spec. Deterministic: the
+     * same spec gives byte-identical entries on every platform and compiler
+     * (own PRNG, no std distributions), so results stay comparable across runs.
+     */
+    std::vector<PasswordEntry> generateEntries(const VaultSpec& spec);
+
+    /**
+     * @brief Prints one result line and records it, under the running case,
+     * for the machine-readable output.
+     */
+    void report(const std::string& metric, double value, const std::string& unit);
+
+    /**
+     * @brief Heap high-water mark tracking. The bench executable counts every
+     * operator new/delete; heapPeakBytes() is the most that was live at once
+     * since resetHeapPeak(), minus what was live at the reset. Unlike the
+     * process RSS peak, it can be measured per phase.
+     */
+    void resetHeapPeak();
+    size_t heapPeakBytes();
+
+    /**
+     * @brief A path in the system temp directory for scratch vault files.
+     */
+    std::string tempPath(const std::string& name);
+
+} // namespace Bench
+
+#define BENCH_CASE(name, description) \
+    static void bench_##name(); \
+    static Bench::Registrar registrar_##name(#name, description, &bench_##name); \
+    static void bench_##name()
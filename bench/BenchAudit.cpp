@@ -0,0 +1,94 @@
+#include "Bench.h"
+#include "BreachAudit.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// A stand-in for the Pwned Passwords download: SHA1:COUNT lines sorted by
+// hash, from the SHA-1s of "pw-<i>". The audited vault reuses 1% of them.
+BENCH_CASE(breach_audit, "Offline breach audit of a 100k-entry vault against a 2M-hash mapped corpus: by thread count, text vs packed, interpolation vs binary search, with and without a Bloom filter") {
+    const size_t corpusHashes = 2000000;
+    const size_t breachedEvery = 100;
+
+    // --- The corpus, in both formats ---
+    std::string textPath = Bench::tempPath("breach.txt");
+    std::string binaryPath = Bench::tempPath("breach.bin");
+    std::string bloomPath = Bench::tempPath("breach.bloom");
+    {
+        std::vector<BreachAudit::Sha1> hashes(corpusHashes);
+        for (size_t i = 0; i < corpusHashes; ++i) hashes[i] = BreachAudit::sha1("pw-" + std::to_string(i));
+        std::sort(hashes.begin(), hashes.end());
+
+        std::string text;
+        text.reserve(corpusHashes * 48);
+        char line[64];
+        for (size_t i = 0; i < corpusHashes; ++i) {
+            for (size_t b = 0; b < hashes[i].size(); ++b) std::snprintf(line + 2 * b, 3, "%02X", hashes[i][b]);
+            text.append(line, 40);
+            text += ":" + std::to_string(1 + i % 9973) + "\r\n";
+        }
+        std::ofstream(textPath, std::ios::binary | std::ios::trunc).write(text.data(), text.size());
+        std::ofstream(binaryPath, std::ios::binary | std::ios::trunc).write((const char*)hashes.data(), hashes.size() * sizeof(BreachAudit::Sha1));
+        std::printf("corpus: %zu hashes, %.1f MB as text, %.1f MB packed\n", corpusHashes,
+            text.size() / (1024.0 * 1024.0), std::filesystem::file_size(binaryPath) / (1024.0 * 1024.0));
+    }
+
+    // --- The vault ---
+    Bench::VaultSpec spec = Bench::vaultSpec();
+    spec.entries = 100000;
+    std::vector<PasswordEntry> generated = Bench::generateEntries(spec);
+    for (size_t i = 0; i < generated.size(); i += breachedEvery) {
+        generated[i].password = "pw-" + std::to_string(i * 7 % corpusHashes);
+    }
+    EntryStore entries;
+    entries.reserve(generated.size());
+    for (const auto& entry : generated) entries.append(entry);
+    auto perSec = [&](double ms) { return entries.size() / (ms / 1000.0); };
+
+    std::vector<unsigned int> threadCounts = { 1, 2, 4, 8 };
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    if (std::find(threadCounts.begin(), threadCounts.end(), cores) == threadCounts.end()) {
+        threadCounts.push_back(cores);
+    }
+
+    // --- Whole audits, by search and thread count ---
+    // The corpus stays in the page cache after the first run, so these are
+    // warm-cache numbers; the Bloom filter matters most when it isn't.
+    std::printf("%-26s %6s %14s %10s %10s\n", "audit", "thr", "passwords/s", "ms", "found");
+    for (const char* path : { textPath.c_str(), binaryPath.c_str() }) {
+        for (BreachAudit::Search search : { BreachAudit::Search::Binary, BreachAudit::Search::Interpolation }) {
+            BreachAudit audit;
+            if (!audit.open(path)) return;
+            audit.setSearch(search);
+            std::string label = std::string(path == textPath ? "text" : "packed") +
+                (search == BreachAudit::Search::Binary ? ", binary search" : ", interpolation");
+            for (unsigned int threads : threadCounts) {
+                ThreadPool pool(threads - 1);
+                BreachAudit::Report report;
+                double ms = Bench::measureMs([&] { report = audit.audit(entries, pool); });
+                std::printf("%-26s %6u %14.0f %10.1f %10zu\n", label.c_str(), threads, perSec(ms), ms, report.findings.size());
+            }
+        }
+    }
+
+    // --- Bloom filter ---
+    ThreadPool pool(cores - 1);
+    double buildMs = Bench::measureMs([&] { BreachAudit::buildBloomFilter(textPath, bloomPath, pool); }, 1);
+    std::printf("bloom filter: built in %.1f ms, %.1f MB\n", buildMs, std::filesystem::file_size(bloomPath) / (1024.0 * 1024.0));
+
+    BreachAudit audit;
+    if (!audit.open(textPath) || !audit.openBloomFilter(bloomPath)) return;
+    BreachAudit::Report report;
+    double bloomMs = Bench::measureMs([&] { report = audit.audit(entries, pool); });
+    std::printf("text + bloom, %u thr: %.0f passwords/s, %.1f ms; %zu of %zu went to the corpus, %zu found\n",
+        cores, perSec(bloomMs), bloomMs, report.corpusLookups, report.checked, report.findings.size());
+
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+    std::remove(bloomPath.c_str());
+}
@@ -0,0 +1,188 @@
+#include "AttachmentStore.h"
+#include "Bench.h"
+#include "Crypto.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <thread>
+
+BENCH_CASE(save_key_cache, "Per-save cost: re-deriving the key with Argon2id vs the cached session key") {
+    const std::string password = "correct horse battery staple";
+    const std::string path = Bench::tempPath("keycache.db");
+
+    Vault vault;
+    vault.setMasterPassword(password);
+    std::vector<PasswordEntry> entries = Bench::makeEntries(1000);
+    for (const auto& entry : entries) vault.addEntry(entry);
+    vault.save(path);
+
+    uint64_t id = entries.front().id;
+    int edit = 0;
+    auto editOne = [&] { vault.editEntry(id, [&](PasswordEntry& entry) { entry.notes = "edit " + std::to_string(edit++); }); };
+
+    // What every save cost before: derive the key from the password, then write
+    double derivedMs = Bench::measureMs([&] {
+        editOne();
+        Crypto::KeyHandle::derive(password, Crypto::generateSalt());
+        vault.save(path);
+    });
+
+    // With the session key: symmetric encryption and I/O only
+    double cachedMs = Bench::measureMs([&] {
+        editOne();
+        vault.save(path);
+    }, 10);
+
+    std::printf("save with key derivation: %10.2f ms\n", derivedMs);
+    std::printf("save with session key:    %10.2f ms\n", cachedMs);
+    std::printf("saved per save:           %10.2f ms\n", derivedMs - cachedMs);
+
+    std::remove(path.c_str());
+}
+
+BENCH_CASE(chunked_crypto, "Encrypt/decrypt throughput on large buffers: one secretbox vs parallel chunks by thread count") {
+    Crypto::KeyHandle key = Crypto::KeyHandle::derive("bench", Crypto::generateSalt());
+
+    std::vector<unsigned int> threadCounts = { 1, 2, 4, 8 };
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    if (std::find(threadCounts.begin(), threadCounts.end(), cores) == threadCounts.end()) {
+        threadCounts.push_back(cores);
+    }
+
+    for (size_t megabytes : { 64, 256 }) {
+        size_t size = megabytes * 1024 * 1024;
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; ++i) data[i] = (unsigned char)(i * 131);
+        auto mbPerSec = [&](double ms) { return megabytes / (ms / 1000.0); };
+
+        // --- Before: the whole buffer as one secretbox ---
+        std::vector<unsigned char> box;
+        double sealMs = Bench::measureMs([&] { box = Crypto::seal(data.data(), size, key); });
+        double openMs = Bench::measureMs([&] { Crypto::open(box.data(), box.size(), key); });
+        std::printf("%zu MB\n", megabytes);
+        std::printf("  %-16s %12s %12s\n", "", "seal MB/s", "open MB/s");
+        std::printf("  %-16s %12.0f %12.0f\n", "single box", mbPerSec(sealMs), mbPerSec(openMs));
+
+        // --- After: chunked, on 1..N threads (the caller counts as one) ---
+        for (unsigned int threads : threadCounts) {
+            ThreadPool pool(threads - 1);
+            std::vector<unsigned char> sealed;
+            double chunkSealMs = Bench::measureMs([&] { sealed = Crypto::sealChunked(data.data(), size, key, pool); });
+            double chunkOpenMs = Bench::measureMs([&] { Crypto::openChunked(sealed.data(), sealed.size(), key, pool); });
+            std::printf("  chunked, %2u thr %12.0f %12.0f\n", threads, mbPerSec(chunkSealMs), mbPerSec(chunkOpenMs));
+        }
+    }
+}
+
+BENCH_CASE(attachment_stream, "Attachment import/export throughput and heap peak: whole-file secretbox vs secretstream chunks") {
+    Crypto::KeyHandle key = Crypto::KeyHandle::derive("bench", Crypto::generateSalt());
+    const std::string vaultPath = Bench::tempPath("attach.db");
+    const std::string source = Bench::tempPath("attach.src");
+    const std::string dest = Bench::tempPath("attach.out");
+    AttachmentStore store(vaultPath);
+
+    std::printf("%-8s %-22s %12s %12s %14s\n", "size", "", "import MB/s", "export MB/s", "heap peak MB");
+    for (size_t megabytes : { 16, 128 }) {
+        {
+            std::ofstream out(source, std::ios::binary | std::ios::trunc);
+            std::string block(1024 * 1024, '\0');
+            for (size_t i = 0; i < block.size(); ++i) block[i] = (char)(i * 131);
+            for (size_t i = 0; i < megabytes; ++i) out.write(block.data(), block.size());
+        }
+        auto mbPerSec = [&](double ms) { return megabytes / (ms / 1000.0); };
+        auto mb = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+
+        // --- Before: read the whole file and seal it as one secretbox ---
+        size_t wholePeak = 0;
+        std::vector<unsigned char> box;
+        double wholeSealMs = Bench::measureMs([&] {
+            Bench::resetHeapPeak();
+            std::ifstream in(source, std::ios::binary);
+            std::vector<unsigned char> plain((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            box = Crypto::seal(plain.data(), plain.size(), key);
+            wholePeak = std::max(wholePeak, Bench::heapPeakBytes());
+        }, 1);
+        double wholeOpenMs = Bench::measureMs([&] {
+            auto plain = Crypto::open(box.data(), box.size(), key);
+            std::ofstream(dest, std::ios::binary | std::ios::trunc).write((const char*)plain->data(), plain->size());
+        }, 1);
+        std::vector<unsigned char>().swap(box);
+        std::printf("%5zu MB  %-22s %12.0f %12.0f %14.1f\n", megabytes, "whole file", mbPerSec(wholeSealMs), mbPerSec(wholeOpenMs), mb(wholePeak));
+
+        // --- After: AttachmentStore streams a chunk at a time ---
+        std::optional<Attachment> attachment;
+        Bench::resetHeapPeak();
+        double importMs = Bench::measureMs([&] {
+            if (attachment) store.remove(attachment->id);
+            attachment = store.import(source, key);
+        }, 1);
+        double exportMs = Bench::measureMs([&] { store.exportTo(*attachment, dest, key); }, 1);
+        size_t streamPeak = Bench::heapPeakBytes();
+        std::printf("%5zu MB  %-22s %12.0f %12.0f %14.1f\n", megabytes, "AttachmentStore stream", mbPerSec(importMs), mbPerSec(exportMs), mb(streamPeak));
+        store.remove(attachment->id);
+    }
+
+    std::remove(source.c_str());
+    std::remove(dest.c_str());
+    std::error_code ec;
+    std::filesystem::remove(store.directory(), ec);
+}
+
+BENCH_CASE(diagnostics_overhead, "Cost of the Diagnostics timers on small seal/open calls: recording off, on, and on with a log file") {
+    const int rounds = 200000;
+    const std::string logPath = Bench::tempPath("diagnostics.log");
+    Crypto::KeyHandle key = Crypto::KeyHandle::derive("correct horse battery staple", Crypto::generateSalt());
+    unsigned char record[64] = { 0 }; // About one small Put record
+    unsigned char plain[sizeof(record)];
+
+    auto run = [&] {
+        return Bench::measureMs([&] {
+            for (int i = 0; i < rounds; ++i) {
+                std::vector<unsigned char> sealed = Crypto::seal(record, sizeof(record), key);
+                Crypto::openTo(plain, sealed.data(), sealed.size(), key);
+            }
+        });
+    };
+
+    double offMs = run();
+    Diagnostics::setEnabled(true);
+    double onMs = run();
+    Diagnostics::openLog(logPath);
+    double loggedMs = Bench::measureMs([&] {
+        for (int i = 0; i < rounds / 10; ++i) {
+            std::vector<unsigned char> sealed = Crypto::seal(record, sizeof(record), key);
+            Crypto::openTo(plain, sealed.data(), sealed.size(), key);
+        }
+    }) * 10;
+    Diagnostics::closeLog();
+    Diagnostics::setEnabled(false);
+    Diagnostics::reset();
+    std::filesystem::remove(logPath);
+
+    std::printf("%d seal+open pairs of %zu bytes\n", rounds, sizeof(record));
+    std::printf("%-28s %10.1f ns/pair\n", "recording off", offMs * 1e6 / rounds);
+    std::printf("%-28s %10.1f ns/pair\n", "recording on", onMs * 1e6 / rounds);
+    std::printf("%-28s %10.1f ns/pair\n", "recording on, with log", loggedMs * 1e6 / rounds);
+}
+
+BENCH_CASE(kdf_calibration, "Key derivation costs picked by Crypto::calibrateKdf for several unlock-time targets, and the unlock time they give") {
+    std::printf("%10s %14s %10s %12s %14s\n", "target ms", "calibrate ms", "passes", "memory MiB", "derive ms");
+    for (double target : { 250.0, 500.0, 1000.0 }) {
+        Crypto::KdfParams kdf;
+        double calibrateMs = Bench::measureMs([&] { kdf = Crypto::calibrateKdf(target); }, 1);
+        double deriveMs = Bench::measureMs([&] { Crypto::KeyHandle::derive("bench", Crypto::generateSalt(), kdf); });
+        std::printf("%10.0f %14.1f %10llu %12llu %14.1f\n", target, calibrateMs,
+            (unsigned long long)kdf.opsLimit, (unsigned long long)(kdf.memLimit >> 20), deriveMs);
+    }
+    double interactiveMs = Bench::measureMs([&] { Crypto::KeyHandle::derive("bench", Crypto::generateSalt()); });
+    std::printf("interactive preset (%llu passes, %llu MiB): %.1f ms\n",
+        (unsigned long long)Crypto::KdfParams::interactive().opsLimit,
+        (unsigned long long)(Crypto::KdfParams::interactive().memLimit >> 20), interactiveMs);
+}
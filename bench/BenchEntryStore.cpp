@@ -0,0 +1,106 @@
+#include "Bench.h"
+#include "SecurePool.h"
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <fstream>
+#endif
+
+namespace {
+    // Resident set size from /proc; 0 where that isn't available
+    size_t residentBytes() {
+#ifdef __linux__
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0, resident = 0;
+        statm >> pages >> resident;
+        return resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+        return 0;
+#endif
+    }
+
+    bool containsNoCase(std::string_view text, std::string_view lowerNeedle) {
+        if (lowerNeedle.size() > text.size()) return false;
+        for (size_t i = 0; i + lowerNeedle.size() <= text.size(); ++i) {
+            size_t j = 0;
+            while (j < lowerNeedle.size() && std::tolower((unsigned char)text[i + j]) == lowerNeedle[j]) ++j;
+            if (j == lowerNeedle.size()) return true;
+        }
+        return false;
+    }
+}
+
+BENCH_CASE(entry_store, "500k entries as a vector of PasswordEntry vs the columnar EntryStore: heap, RSS and scan speed") {
+    const size_t count = 500000;
+
+    // Real vaults reuse a handful of logins and many entries per site
+    Bench::VaultSpec spec = Bench::vaultSpec();
+    spec.entries = count;
+    std::vector<PasswordEntry> generated = Bench::generateEntries(spec);
+    for (size_t i = 0; i < generated.size(); ++i) {
+        generated[i].username = generated[i % 40].username;
+        generated[i].url = generated[i % 5000].url;
+    }
+
+    // --- Building each, new layout first so its RSS isn't hidden by pages
+    // the vector leaves in the allocator ---
+    size_t rssBefore = residentBytes();
+    auto poolBytes = [] {
+        SecurePool::Stats stats = SecurePool::shared().stats();
+        return stats.bytesInUse + stats.largeBytes;
+    };
+    size_t poolBefore = poolBytes();
+    Bench::resetHeapPeak();
+    EntryStore store;
+    store.reserve(count); // As loading a snapshot does
+    for (const auto& entry : generated) store.append(entry);
+    // The arenas live in SecurePool, which the heap counter doesn't see;
+    // add what they hold at the end
+    size_t storeHeap = Bench::heapPeakBytes() + poolBytes() - poolBefore;
+    size_t storeRss = residentBytes() - rssBefore;
+
+    rssBefore = residentBytes();
+    Bench::resetHeapPeak();
+    std::vector<PasswordEntry> entries(generated.begin(), generated.end());
+    size_t vectorHeap = Bench::heapPeakBytes();
+    size_t vectorRss = residentBytes() - rssBefore;
+
+    auto mb = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+    std::printf("%-10s %12s %12s %12s\n", "layout", "heap peak", "RSS grew", "bytes/entry");
+    std::printf("%-10s %9.1f MB %9.1f MB %12.0f\n", "vector", mb(vectorHeap), mb(vectorRss), (double)vectorHeap / count);
+    std::printf("%-10s %9.1f MB %9.1f MB %12.0f\n", "columns", mb(storeHeap), mb(storeRss), (double)storeHeap / count);
+    std::printf("EntryStore::memoryBytes(): %.1f MB\n", mb(store.memoryBytes()));
+
+    // --- Scans: the UI's title filter, and a pass over one short field ---
+    const std::string_view needle = "portal";
+    size_t vectorHits = 0, storeHits = 0;
+    double vectorFilterMs = Bench::measureMs([&] {
+        vectorHits = 0;
+        for (const auto& entry : entries) vectorHits += containsNoCase(entry.title, needle);
+    });
+    double storeFilterMs = Bench::measureMs([&] {
+        storeHits = 0;
+        for (EntryRef entry : store) storeHits += containsNoCase(entry.title(), needle);
+    });
+
+    size_t vectorSum = 0, storeSum = 0;
+    double vectorSumMs = Bench::measureMs([&] {
+        vectorSum = 0;
+        for (const auto& entry : entries) vectorSum += entry.username.size() + entry.modified;
+    });
+    double storeSumMs = Bench::measureMs([&] {
+        storeSum = 0;
+        for (EntryRef entry : store) storeSum += entry.username().size() + entry.modified();
+    });
+
+    std::printf("%-10s %14s %14s\n", "layout", "title filter", "username scan");
+    std::printf("%-10s %11.2f ms %11.2f ms\n", "vector", vectorFilterMs, vectorSumMs);
+    std::printf("%-10s %11.2f ms %11.2f ms\n", "columns", storeFilterMs, storeSumMs);
+    if (vectorHits != storeHits || vectorSum != storeSum) std::printf("(results differ!)\n");
+}
@@ -0,0 +1,60 @@
+#include "Bench.h"
+#include "EntryView.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+BENCH_CASE(entry_view, "Per-frame entry list cost at 250k entries: full walk vs cached view") {
+    const size_t count = 250000;
+    const int frames = 60;
+    const size_t visibleRows = 40; // Roughly what fits in the list pane
+
+    Vault vault;
+    for (const auto& entry : Bench::makeEntries(count)) vault.addEntry(entry);
+
+    // --- Before: walk every entry each frame, lowercasing filter and title ---
+    const std::string filter = "service";
+    size_t sink = 0;
+    double walkMs = Bench::measureMs([&] {
+        for (int frame = 0; frame < frames; ++frame) {
+            for (EntryRef entry : vault.entries()) {
+                std::string filterLower = filter;
+                std::transform(filterLower.begin(), filterLower.end(), filterLower.begin(), ::tolower);
+                std::string titleLower(entry.title());
+                std::transform(titleLower.begin(), titleLower.end(), titleLower.begin(), ::tolower);
+                if (titleLower.find(filterLower) != std::string::npos) sink += entry.title().size();
+            }
+        }
+    }, 1);
+
+    // --- After: an unchanged view costs a comparison plus the visible rows ---
+    EntryView view;
+    view.update(vault, filter, EntryView::SortOrder::Title);
+    double viewMs = Bench::measureMs([&] {
+        for (int frame = 0; frame < frames; ++frame) {
+            view.update(vault, filter, EntryView::SortOrder::Title);
+            for (size_t row = 0; row < visibleRows && row < view.size(); ++row) {
+                sink += vault.getEntry(view.rows()[row]).title().size();
+            }
+        }
+    }, 1);
+
+    // --- Recomputing, which happens only when something changed ---
+    auto recompute = [&](const std::string& text, EntryView::SortOrder order) {
+        return Bench::measureMs([&] {
+            view.invalidate();
+            view.update(vault, text, order);
+        });
+    };
+
+    std::printf("%zu entries, %d frames\n", count, frames);
+    std::printf("%-34s %10.3f ms/frame\n", "full walk", walkMs / frames);
+    std::printf("%-34s %10.3f ms/frame\n", "cached view", viewMs / frames);
+    std::printf("%-34s %10.3f ms\n", "recompute: all, by title", recompute("", EntryView::SortOrder::Title));
+    std::printf("%-34s %10.3f ms\n", "recompute: all, by modified", recompute("", EntryView::SortOrder::RecentlyModified));
+    std::printf("%-34s %10.3f ms\n", "recompute: \"account 12\", by title", recompute("account 12", EntryView::SortOrder::Title));
+    if (sink == 0) std::printf("(unreachable)\n");
+}
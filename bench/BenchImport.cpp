@@ -0,0 +1,86 @@
+#include "Bench.h"
+#include "Importer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// A browser-style CSV export: Chrome's columns, with a share of quoted
+// fields holding commas, doubled quotes and line breaks.
+static std::string makeCsv(size_t rows) {
+    std::string csv = "name,url,username,password,note\n";
+    csv.reserve(rows * 110);
+    for (size_t i = 0; i < rows; ++i) {
+        std::string n = std::to_string(i);
+        csv += "Service account " + n + ",https://service" + n + ".example.com/login,user" + n + "@example.com,";
+        csv += (i % 10 == 0) ? "\"pw,\"\"" + n + "\"\"-Xk9!\"" : "pw-" + n + "-Xk9!qLm2#Rt7$vB";
+        csv += (i % 20 == 0) ? ",\"Rotated quarterly.\nOwner: team " + std::to_string(i % 17) + "\"\n" : ",\n";
+    }
+    return csv;
+}
+
+static std::string makeJson(size_t rows) {
+    std::string out = "[";
+    out.reserve(rows * 150);
+    for (size_t i = 0; i < rows; ++i) {
+        std::string n = std::to_string(i);
+        out += (i ? ",\n" : "\n");
+        out += "{\"title\":\"Service account " + n + "\",\"username\":\"user" + n + "@example.com\",\"password\":\"pw-" + n +
+               "-Xk9!\\\"qLm2\",\"url\":\"https://service" + n + ".example.com/login\",\"notes\":\"Owner: team " + std::to_string(i % 17) + "\"}";
+    }
+    return out + "\n]\n";
+}
+
+BENCH_CASE(import, "Bulk import rows/s: CSV and JSON parsing by thread count, and one-at-a-time addEntry vs Vault::importEntries") {
+    const size_t rows = 500000;
+    auto rowsPerSec = [&](double ms) { return rows / (ms / 1000.0); };
+
+    std::vector<unsigned int> threadCounts = { 1, 2, 4, 8 };
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    if (std::find(threadCounts.begin(), threadCounts.end(), cores) == threadCounts.end()) {
+        threadCounts.push_back(cores);
+    }
+
+    // --- Parsing, from a mapped file ---
+    for (const char* format : { "csv", "json" }) {
+        std::string path = Bench::tempPath(std::string("import.") + format);
+        {
+            std::string text = std::string(format) == "csv" ? makeCsv(rows) : makeJson(rows);
+            std::ofstream(path, std::ios::binary | std::ios::trunc).write(text.data(), text.size());
+            std::printf("%s, %zu rows, %.1f MB\n", format, rows, text.size() / (1024.0 * 1024.0));
+        }
+        for (unsigned int threads : threadCounts) {
+            ThreadPool pool(threads - 1);
+            double ms = Bench::measureMs([&] { Importer::parseFile(path, pool); });
+            std::printf("  parse, %2u thr %14.0f rows/s %10.1f ms\n", threads, rowsPerSec(ms), ms);
+        }
+        std::remove(path.c_str());
+    }
+
+    // --- Inserting into the vault ---
+    ThreadPool pool(cores - 1);
+    auto parsed = Importer::parseCsv(makeCsv(rows), pool);
+
+    // Before: what adding rows through the Add/Edit modal amounts to
+    double oneByOneMs = Bench::measureMs([&] {
+        Vault vault;
+        for (const auto& entry : parsed->entries) {
+            PasswordEntry copy = entry;
+            copy.id = vault.newEntryId();
+            vault.addEntry(copy);
+        }
+    }, 1);
+
+    double bulkMs = Bench::measureMs([&] {
+        Vault vault;
+        std::vector<PasswordEntry> entries = parsed->entries;
+        vault.importEntries(std::move(entries));
+    }, 1);
+
+    std::printf("insert %zu rows\n", rows);
+    std::printf("  addEntry one by one %14.0f rows/s %10.1f ms\n", rowsPerSec(oneByOneMs), oneByOneMs);
+    std::printf("  importEntries       %14.0f rows/s %10.1f ms\n", rowsPerSec(bulkMs), bulkMs);
+}
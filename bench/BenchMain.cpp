@@ -0,0 +1,361 @@
+#include "Bench.h"
+#include "Crypto.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+using json = nlohmann::json;
+
+// --- Heap tracking ---
+// Each allocation carries its size in a header so delete can subtract it.
+
+namespace {
+    std::atomic<size_t> g_heapLive{ 0 };
+    std::atomic<size_t> g_heapPeak{ 0 };
+    std::atomic<size_t> g_heapBase{ 0 };
+
+    const size_t HEADER = alignof(std::max_align_t);
+
+    void* trackedAlloc(size_t size) {
+        void* block = std::malloc(size + HEADER);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        *(size_t*)block = size;
+
+        size_t live = g_heapLive += size;
+        size_t peak = g_heapPeak.load();
+        while (live > peak && !g_heapPeak.compare_exchange_weak(peak, live)) {}
+        return (char*)block + HEADER;
+    }
+
+    void trackedFree(void* p) {
+        if (p == nullptr) return;
+        void* block = (char*)p - HEADER;
+        g_heapLive -= *(size_t*)block;
+        std::free(block);
+    }
+}
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { trackedFree(p); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return trackedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return trackedAlloc(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+
+void Bench::resetHeapPeak() {
+    g_heapBase = g_heapLive.load();
+    g_heapPeak = g_heapLive.load();
+}
+
+size_t Bench::heapPeakBytes() {
+    return g_heapPeak.load() - g_heapBase.load();
+}
+
+std::vector<Bench::Case>& Bench::registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+Bench::Registrar::Registrar(const char* name, const char* description, void (*run)()) {
+    registry().push_back(Case{ name, description, run });
+}
+
+double Bench::measureMs(const std::function<void()>& fn, int repeats) {
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+std::vector<PasswordEntry> Bench::makeEntries(size_t count) {
+    std::vector<PasswordEntry> entries;
+    entries.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string n = std::to_string(i);
+        PasswordEntry entry;
+        entry.id = 1000000 + i;
+        entry.title = "Service account " + n;
+        entry.username = "user" + n + "@example.com";
+        entry.password = "pw-" + n + "-Xk9!qLm2#Rt7$vB";
+        entry.url = "https://service" + n + ".example.com/login";
+        entry.notes = "Rotated quarterly. Owner: team " + std::to_string(i % 17) + ".";
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+std::string Bench::tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("cppvault-bench-" + name)).string();
+}
+
+// --- Synthetic vaults ---
+
+namespace {
+    // splitmix64: tiny, fast, and fully specified, unlike std::mt19937 + distributions
+    struct Rng {
+        uint64_t state;
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        size_t below(size_t n) { return n == 0 ? 0 : (size_t)(next() % n); }
+
+        // An average length give or take a quarter, at least 1
+        size_t length(size_t average) {
+            size_t spread = average / 4;
+            size_t n = average - spread + below(2 * spread + 1);
+            return std::max<size_t>(n, 1);
+        }
+    };
+
+    const char* const WORDS[] = {
+        "account", "admin", "alpha", "bank", "blue", "cloud", "mail", "code",
+        "data", "delta", "dev", "forum", "game", "home", "login", "media",
+        "music", "news", "office", "portal", "prod", "router", "server", "shop",
+        "social", "staging", "store", "team", "travel", "vpn", "wiki", "work"
+    };
+    const size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+    // Words joined by `separator` until `length` characters, cut to fit
+    std::string words(Rng& rng, size_t length, char separator) {
+        std::string text;
+        text.reserve(length + 16);
+        while (text.size() < length) {
+            if (!text.empty()) text += separator;
+            text += WORDS[rng.below(WORD_COUNT)];
+        }
+        text.resize(length);
+        return text;
+    }
+
+    std::string printable(Rng& rng, size_t length) {
+        std::string text(length, ' ');
+        for (char& c : text) c = (char)(33 + rng.below(94)); // '!'..'~'
+        return text;
+    }
+}
+
+Bench::VaultSpec& Bench::vaultSpec() {
+    static VaultSpec spec;
+    return spec;
+}
+
+std::vector<PasswordEntry> Bench::generateEntries(const VaultSpec& spec) {
+    Rng rng{ spec.seed };
+    std::vector<PasswordEntry> entries;
+    entries.reserve(spec.entries);
+    for (size_t i = 0; i < spec.entries; ++i) {
+        PasswordEntry entry;
+        entry.id = 1000000 + i;
+        entry.modified = 1700000000000ull + i;
+        entry.title = words(rng, rng.length(spec.titleLength), ' ');
+        entry.username = words(rng, rng.length(spec.usernameLength), '.');
+        entry.password = printable(rng, rng.length(spec.passwordLength));
+        entry.url = "https://" + words(rng, rng.length(spec.urlLength), '.');
+        entry.notes = words(rng, rng.length(spec.notesLength), ' ');
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+// --- Results ---
+
+namespace {
+    struct Result {
+        std::string caseName;
+        std::string metric;
+        double value;
+        std::string unit;
+    };
+
+    std::string g_currentCase;
+    std::vector<Result> g_results;
+}
+
+void Bench::report(const std::string& metric, double value, const std::string& unit) {
+    std::printf("%-40s %12.3f %s\n", metric.c_str(), value, unit.c_str());
+    g_results.push_back(Result{ g_currentCase, metric, value, unit });
+}
+
+static json SpecToJson(const Bench::VaultSpec& spec) {
+    return json{
+        { "entries", spec.entries },
+        { "seed", spec.seed },
+        { "title_length", spec.titleLength },
+        { "username_length", spec.usernameLength },
+        { "password_length", spec.passwordLength },
+        { "url_length", spec.urlLength },
+        { "notes_length", spec.notesLength }
+    };
+}
+
+static bool WriteJson(const std::string& path) {
+    json results = json::array();
+    for (const auto& r : g_results) {
+        results.push_back({ { "case", r.caseName }, { "metric", r.metric }, { "value", r.value }, { "unit", r.unit } });
+    }
+    json doc = { { "schema", 1 }, { "config", SpecToJson(Bench::vaultSpec()) }, { "results", results } };
+
+    std::ofstream file(path);
+    file << doc.dump(2) << std::endl;
+    return (bool)file;
+}
+
+// RFC 4180 quoting, for metric names with commas or quotes
+static std::string CsvField(const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) return text;
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static bool WriteCsv(const std::string& path) {
+    std::ofstream file(path);
+    file << "case,metric,value,unit\n";
+    char value[64];
+    for (const auto& r : g_results) {
+        std::snprintf(value, sizeof(value), "%.6g", r.value);
+        file << CsvField(r.caseName) << ',' << CsvField(r.metric) << ',' << value << ',' << CsvField(r.unit) << '\n';
+    }
+    return (bool)file;
+}
+
+static void PrintUsage() {
+    std::cout <<
+        "Usage: cppvault-bench [options] [case...]\n"
+        "\n"
+        "Runs every benchmark, or only the named cases.\n"
+        "\n"
+        "Options:\n"
+        "  --list               List the cases and exit\n"
+        "  --json FILE          Also write the results as JSON\n"
+        "  --csv FILE           Also write the results as CSV\n"
+        "\n"
+        "Synthetic vault (cases that use Bench::generateEntries):\n"
+        "  --entries N          Number of entries (default 10000)\n"
+        "  --seed N             Generator seed (default 42)\n"
+        "  --title-len N        Average field lengths (defaults 24, 20, 20, 40, 80)\n"
+        "  --username-len N\n"
+        "  --password-len N\n"
+        "  --url-len N\n"
+        "  --notes-len N\n";
+}
+
+int main(int argc, char** argv) {
+    if (!Crypto::init()) {
+        std::cerr << "Failed to initialize crypto library!" << std::endl;
+        return 1;
+    }
+
+    // 1. Parse the command line
+    Bench::VaultSpec& spec = Bench::vaultSpec();
+    std::vector<std::string> selected;
+    std::string jsonPath, csvPath;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value" << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        auto number = [&]() -> uint64_t {
+            const char* text = value();
+            char* end = nullptr;
+            unsigned long long n = std::strtoull(text, &end, 10);
+            if (end == text || *end != '\0') {
+                std::cerr << arg << ": not a number: " << text << std::endl;
+                std::exit(2);
+            }
+            return n;
+        };
+
+        if (arg == "--list") list = true;
+        else if (arg == "--help" || arg == "-h") { PrintUsage(); return 0; }
+        else if (arg == "--json") jsonPath = value();
+        else if (arg == "--csv") csvPath = value();
+        else if (arg == "--entries") spec.entries = number();
+        else if (arg == "--seed") spec.seed = number();
+        else if (arg == "--title-len") spec.titleLength = number();
+        else if (arg == "--username-len") spec.usernameLength = number();
+        else if (arg == "--password-len") spec.passwordLength = number();
+        else if (arg == "--url-len") spec.urlLength = number();
+        else if (arg == "--notes-len") spec.notesLength = number();
+        else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage();
+            return 2;
+        }
+        else selected.push_back(arg);
+    }
+
+    if (list) {
+        for (const auto& c : Bench::registry()) {
+            std::cout << c.name << "\t" << c.description << std::endl;
+        }
+        return 0;
+    }
+
+    for (const auto& name : selected) {
+        bool known = std::any_of(Bench::registry().begin(), Bench::registry().end(), [&](const Bench::Case& c) { return c.name == name; });
+        if (!known) {
+            std::cerr << "Unknown benchmark: " << name << " (see --list)" << std::endl;
+            return 2;
+        }
+    }
+
+    // 2. Run the cases
+    for (const auto& c : Bench::registry()) {
+        bool run = selected.empty() || std::find(selected.begin(), selected.end(), c.name) != selected.end();
+        if (!run) continue;
+
+        std::cout << "== " << c.name << ": " << c.description << std::endl;
+        g_currentCase = c.name;
+        c.run();
+        std::cout << std::endl;
+    }
+
+    // 3. Write the machine-readable results
+    if (!jsonPath.empty() && !WriteJson(jsonPath)) {
+        std::cerr << "Failed to write " << jsonPath << std::endl;
+        return 1;
+    }
+    if (!csvPath.empty() && !WriteCsv(csvPath)) {
+        std::cerr << "Failed to write " << csvPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    // The old filter: lowercase the query and every title, then substring match
+    size_t scanTitles(const std::vector<PasswordEntry>& entries, const std::string& filter) {
+        std::string filterLower = filter;
+        std::transform(filterLower.begin(), filterLower.end(), filterLower.begin(), ::tolower);
+        size_t matches = 0;
+        for (const auto& entry : entries) {
+            std::string titleLower = entry.title;
+            std::transform(titleLower.begin(), titleLower.end(), titleLower.begin(), ::tolower);
+            if (titleLower.find(filterLower) != std::string::npos) ++matches;
+        }
+        return matches;
+    }
+}
+
+BENCH_CASE(search, "Filter 100k entries: per-frame title scan vs trigram index") {
+    const size_t count = 100000;
+    std::vector<PasswordEntry> entries = Bench::makeEntries(count);
+
+    Vault vault;
+    double buildMs = Bench::measureMs([&] {
+        vault.clear();
+        for (const auto& entry : entries) vault.addEntry(entry);
+    }, 1);
+
+    // From very selective to matching everything
+    const char* queries[] = { "account 4242", "SERVICE99", "user123 team 5", "rotated", "ex" };
+
+    std::printf("%zu entries, index built in %.1f ms\n", count, buildMs);
+    std::printf("%-18s %10s %12s %10s %12s\n", "query", "scan hits", "scan ms", "idx hits", "index ms");
+    for (const char* query : queries) {
+        size_t scanHits = 0, indexHits = 0;
+        double scanMs = Bench::measureMs([&] { scanHits = scanTitles(entries, query); });
+        double indexMs = Bench::measureMs([&] { indexHits = vault.search(query).size(); });
+        std::printf("%-18s %10zu %12.3f %10zu %12.3f\n", query, scanHits, scanMs, indexHits, indexMs);
+    }
+
+    // Editing keeps the index current without a rebuild
+    double editMs = Bench::measureMs([&] {
+        for (size_t i = 0; i < 1000; ++i) {
+            PasswordEntry entry = entries[i * 97 % count];
+            entry.notes += " edited";
+            vault.addEntry(entry);
+        }
+    }, 1);
+    std::printf("1000 edits re-indexed in %.3f ms\n", editMs);
+}
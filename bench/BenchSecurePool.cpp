@@ -0,0 +1,94 @@
+#include "Bench.h"
+#include "SecurePool.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sodium.h>
+
+namespace {
+    // Sizes like an entry's strings: 16 to 256 bytes, from a fixed LCG so
+    // every allocator sees the same sequence
+    std::vector<size_t> blockSizes(size_t count) {
+        std::vector<size_t> sizes(count);
+        uint64_t state = 42;
+        for (auto& size : sizes) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            size = 16 + (size_t)((state >> 33) % 241);
+        }
+        return sizes;
+    }
+
+    // Allocates every block, writes it, then frees every other one and
+    // allocates again into the holes, and finally frees the lot: the churn
+    // of loading a vault, editing it and locking it
+    template <typename Allocate, typename Free>
+    void churn(const std::vector<size_t>& sizes, Allocate allocate, Free free) {
+        std::vector<void*> blocks(sizes.size());
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            blocks[i] = allocate(sizes[i]);
+            std::memset(blocks[i], (int)i, sizes[i]);
+        }
+        for (size_t i = 0; i < sizes.size(); i += 2) {
+            free(blocks[i], sizes[i]);
+            blocks[i] = allocate(sizes[i]);
+        }
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            free(blocks[i], sizes[i]);
+        }
+    }
+}
+
+BENCH_CASE(secure_pool, "Small-allocation throughput: plain heap vs SecurePool slabs vs one sodium_malloc per block") {
+    const size_t count = 200000;
+    const size_t sodiumCount = 5000; // Each one is a few system calls; keep the run short
+    std::vector<size_t> sizes = blockSizes(count);
+    std::vector<size_t> sodiumSizes(sizes.begin(), sizes.begin() + sodiumCount);
+    const size_t operations = count * 3; // Allocations and frees
+
+    double heapMs = Bench::measureMs([&] {
+        churn(sizes, [](size_t size) { return (void*)new char[size]; },
+              [](void* block, size_t) { delete[] (char*)block; });
+    });
+
+    SecurePool pool;
+    double poolMs = Bench::measureMs([&] {
+        churn(sizes, [&](size_t size) { return pool.allocate(size); },
+              [&](void* block, size_t size) { pool.deallocate(block, size); });
+    });
+    SecurePool::Stats stats = pool.stats();
+    pool.trim();
+
+    double sodiumMs = Bench::measureMs([&] {
+        churn(sodiumSizes, [](size_t size) { return sodium_malloc(size); },
+              [](void* block, size_t) { sodium_free(block); });
+    }, 1);
+
+    auto nsPerOp = [](double ms, size_t ops) { return ms * 1e6 / (double)ops; };
+    std::printf("%-16s %12s %12s\n", "allocator", "total", "ns/op");
+    std::printf("%-16s %9.2f ms %12.1f\n", "new/delete", heapMs, nsPerOp(heapMs, operations));
+    std::printf("%-16s %9.2f ms %12.1f\n", "SecurePool", poolMs, nsPerOp(poolMs, operations));
+    std::printf("%-16s %9.2f ms %12.1f  (%zu blocks)\n", "sodium_malloc", sodiumMs,
+                nsPerOp(sodiumMs, sodiumCount * 3), sodiumCount);
+    std::printf("pool held %zu slabs (%.1f MB) at the end of a run\n", stats.slabs, stats.slabBytes / (1024.0 * 1024.0));
+
+    Bench::report("heap_ns_per_op", nsPerOp(heapMs, operations), "ns");
+    Bench::report("pool_ns_per_op", nsPerOp(poolMs, operations), "ns");
+    Bench::report("sodium_ns_per_op", nsPerOp(sodiumMs, sodiumCount * 3), "ns");
+
+    // --- The same through containers: building strings of entry-sized text ---
+    std::string text(256, 'x');
+    double stringMs = Bench::measureMs([&] {
+        std::vector<std::string> strings;
+        strings.reserve(count);
+        for (size_t size : sizes) strings.emplace_back(text.data(), size);
+    });
+    double secureStringMs = Bench::measureMs([&] {
+        std::vector<SecureString> strings;
+        strings.reserve(count);
+        for (size_t size : sizes) strings.emplace_back(text.data(), size);
+    });
+    std::printf("%zu strings: std::string %.2f ms, SecureString %.2f ms\n", count, stringMs, secureStringMs);
+}
@@ -0,0 +1,60 @@
+#include "Bench.h"
+#include "EntryCodec.h"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Defined in Vault.cpp
+void to_json(json& j, const PasswordEntry& p);
+void from_json(const json& j, PasswordEntry& p);
+
+BENCH_CASE(serialize, "Snapshot serialize/parse: pretty-printed JSON vs EntryCodec binary") {
+    std::printf("%8s %-7s %10s %12s %12s %12s %12s\n", "entries", "format", "bytes", "write MB/s", "read MB/s", "write peak", "read peak");
+
+    for (size_t count : { 1000, 10000, 100000 }) {
+        std::vector<PasswordEntry> entries = Bench::makeEntries(count);
+
+        // --- Before: to_json into a DOM, then dump(4); parse back through a DOM ---
+        std::string text;
+        Bench::resetHeapPeak();
+        double jsonWriteMs = Bench::measureMs([&] {
+            std::string().swap(text); // Don't count the previous run's output
+            json j = entries;
+            text = j.dump(4);
+        });
+        size_t jsonWritePeak = Bench::heapPeakBytes();
+
+        size_t parsed = 0;
+        Bench::resetHeapPeak();
+        double jsonReadMs = Bench::measureMs([&] {
+            parsed = json::parse(text).get<std::vector<PasswordEntry>>().size();
+        });
+        size_t jsonReadPeak = Bench::heapPeakBytes();
+
+        // --- After: straight into / out of one buffer ---
+        std::string binary;
+        Bench::resetHeapPeak();
+        double binWriteMs = Bench::measureMs([&] {
+            std::string().swap(binary);
+            binary = EntryCodec::encodeEntries(entries);
+        });
+        size_t binWritePeak = Bench::heapPeakBytes();
+
+        Bench::resetHeapPeak();
+        double binReadMs = Bench::measureMs([&] { parsed += EntryCodec::decodeEntries(binary)->size(); });
+        size_t binReadPeak = Bench::heapPeakBytes();
+
+        auto mbPerSec = [](size_t bytes, double ms) { return bytes / (1024.0 * 1024.0) / (ms / 1000.0); };
+        auto mb = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+        std::printf("%8zu %-7s %10zu %12.1f %12.1f %10.1f MB %9.1f MB\n", count, "json",
+                    text.size(), mbPerSec(text.size(), jsonWriteMs), mbPerSec(text.size(), jsonReadMs), mb(jsonWritePeak), mb(jsonReadPeak));
+        std::printf("%8zu %-7s %10zu %12.1f %12.1f %10.1f MB %9.1f MB\n", count, "binary",
+                    binary.size(), mbPerSec(binary.size(), binWriteMs), mbPerSec(binary.size(), binReadMs), mb(binWritePeak), mb(binReadPeak));
+        if (parsed == 0) std::printf("(unreachable)\n");
+    }
+}
@@ -0,0 +1,82 @@
+#include "Bench.h"
+#include "SecurePool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+    const size_t HISTORY_STEPS = 100;
+
+    size_t poolBytes() {
+        SecurePool::Stats stats = SecurePool::shared().stats();
+        return stats.bytesInUse + stats.largeBytes;
+    }
+}
+
+BENCH_CASE(snapshot, "Copy-on-write EntryStore: snapshot vs full copy, edits with undo history on and off, undo/redo") {
+    std::vector<PasswordEntry> entries = Bench::generateEntries(Bench::vaultSpec());
+    Vault vault;
+    vault.setMasterPassword("correct horse battery staple");
+    for (const auto& entry : entries) vault.addEntry(entry);
+    std::printf("%zu entries\n", entries.size());
+
+    // --- Copies: what a save snapshot or an undo step used to take, and takes now ---
+    double copyMs = Bench::measureMs([&] {
+        EntryStore copy;
+        copy.setKey(vault.entries().key());
+        copy.reserve(vault.entries().size());
+        for (EntryRef entry : vault.entries()) copy.append(entry); // Sealed secrets copied as they are
+    });
+    const int snapshots = 1000;
+    double snapshotMs = Bench::measureMs([&] {
+        for (int i = 0; i < snapshots; ++i) {
+            EntryStore snapshot = vault.entries();
+        }
+    });
+    Bench::report("full copy", copyMs, "ms");
+    Bench::report("snapshot (shared pages)", snapshotMs * 1000.0 / snapshots, "us");
+
+    // --- A save snapshot with one pending change, taken on the UI thread ---
+    const std::string path = Bench::tempPath("snapshot.db");
+    vault.compact(path);
+    double takeMs = 0.0;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        vault.editEntry(entries[repeat].id, [](PasswordEntry& entry) { entry.title += "!"; });
+        double ms = Bench::measureMs([&] {
+            Vault::SaveSnapshot snapshot = vault.takeSaveSnapshot(path);
+            vault.restoreSnapshot(snapshot, Vault::SaveResult::Failed); // Keep the change pending for the next repeat
+        }, 1);
+        if (repeat == 0 || ms < takeMs) takeMs = ms;
+    }
+    Bench::report("takeSaveSnapshot, 1 change", takeMs * 1000.0, "us");
+
+    // --- Edits: with history on, each first copies its page and the path above it ---
+    const size_t edits = std::min<size_t>(HISTORY_STEPS, entries.size());
+    auto editAll = [&] {
+        for (size_t i = 0; i < edits; ++i) {
+            vault.editEntry(entries[i * entries.size() / edits].id, [](PasswordEntry& entry) { entry.username += "!"; });
+        }
+    };
+    double plainMs = Bench::measureMs(editAll, 1);
+    vault.setHistoryLimit(HISTORY_STEPS);
+    size_t poolBefore = poolBytes();
+    Bench::resetHeapPeak();
+    double historyMs = Bench::measureMs(editAll, 1);
+    size_t historyBytes = Bench::heapPeakBytes() + poolBytes() - poolBefore;
+    Bench::report("edit, no history", plainMs * 1000.0 / edits, "us");
+    Bench::report("edit, with history", historyMs * 1000.0 / edits, "us");
+    Bench::report("memory for " + std::to_string(edits) + " undo steps", historyBytes / (1024.0 * 1024.0), "MB");
+    Bench::report("vault memoryBytes()", vault.entries().memoryBytes() / (1024.0 * 1024.0), "MB");
+
+    // --- Undo and redo: puts the entries back sealed, no crypto ---
+    double undoMs = Bench::measureMs([&] { while (vault.undo()) {} }, 1);
+    double redoMs = Bench::measureMs([&] { while (vault.redo()) {} }, 1);
+    Bench::report("undo", undoMs * 1000.0 / edits, "us");
+    Bench::report("redo", redoMs * 1000.0 / edits, "us");
+
+    vault.clear();
+    std::filesystem::remove(path);
+}
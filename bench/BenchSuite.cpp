@@ -0,0 +1,214 @@
+#include "Bench.h"
+#include "Crypto.h"
+#include "EntryCodec.h"
+#include "EntryView.h"
+#include "PasswordGenerator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// The regression suite: one case per hot path, each with microbenchmarks of
+// the pieces and an end-to-end run, on a synthetic vault shaped by the
+// command line (Bench::VaultSpec). Meant for CI, e.g.
+//   cppvault-bench --entries 50000 --json results.json suite_crypto suite_load ...
+
+static const std::string PASSWORD = "correct horse battery staple";
+
+static void PrintSpec() {
+    const Bench::VaultSpec& spec = Bench::vaultSpec();
+    std::printf("%zu entries, seed %llu, field lengths %zu/%zu/%zu/%zu/%zu\n",
+        spec.entries, (unsigned long long)spec.seed, spec.titleLength, spec.usernameLength,
+        spec.passwordLength, spec.urlLength, spec.notesLength);
+}
+
+static Vault MakeVault(const std::vector<PasswordEntry>& entries) {
+    Vault vault;
+    for (const auto& entry : entries) vault.addEntry(entry);
+    return vault;
+}
+
+BENCH_CASE(suite_crypto, "Crypto: key derivation, seal/open throughput by size, and Crypto::encrypt/decrypt of a whole vault") {
+    PrintSpec();
+
+    // --- Micro ---
+    double kdfMs = Bench::measureMs([&] { Crypto::KeyHandle::derive(PASSWORD, Crypto::generateSalt()); });
+    Bench::report("key derivation", kdfMs, "ms");
+
+    Crypto::KeyHandle key = Crypto::KeyHandle::derive(PASSWORD, Crypto::generateSalt());
+    for (size_t size : { (size_t)1024, (size_t)64 * 1024, (size_t)1024 * 1024 }) {
+        std::vector<unsigned char> data(size, 0x5A);
+        const int rounds = (int)std::max<size_t>(1, (16 * 1024 * 1024) / size); // ~16 MB per measurement
+        std::vector<unsigned char> sealed;
+
+        double sealMs = Bench::measureMs([&] {
+            for (int i = 0; i < rounds; ++i) sealed = Crypto::seal(data.data(), data.size(), key);
+        });
+        double openMs = Bench::measureMs([&] {
+            for (int i = 0; i < rounds; ++i) Crypto::open(sealed.data(), sealed.size(), key);
+        });
+
+        double mb = (double)size * rounds / (1024.0 * 1024.0);
+        std::string label = std::to_string(size / 1024) + " KB";
+        Bench::report("seal " + label, mb / (sealMs / 1000.0), "MB/s");
+        Bench::report("open " + label, mb / (openMs / 1000.0), "MB/s");
+    }
+
+    // --- End to end: the password-based API over a serialized vault ---
+    std::string payload = EntryCodec::encodeEntries(Bench::generateEntries(Bench::vaultSpec()));
+    std::vector<unsigned char> encrypted;
+    double encryptMs = Bench::measureMs([&] { encrypted = Crypto::encrypt(payload, PASSWORD); });
+    double decryptMs = Bench::measureMs([&] { Crypto::decrypt(encrypted, PASSWORD); });
+
+    Bench::report("vault payload", payload.size() / (1024.0 * 1024.0), "MB");
+    Bench::report("encrypt vault (incl. key derivation)", encryptMs, "ms");
+    Bench::report("decrypt vault (incl. key derivation)", decryptMs, "ms");
+}
+
+BENCH_CASE(suite_load, "Vault::load: decoding alone, then the whole unlock of a compacted vault file") {
+    PrintSpec();
+    std::vector<PasswordEntry> entries = Bench::generateEntries(Bench::vaultSpec());
+
+    // --- Micro ---
+    std::string payload = EntryCodec::encodeEntries(entries);
+    double decodeMs = Bench::measureMs([&] { EntryCodec::decodeEntries(payload); });
+    Bench::report("decode entries", decodeMs, "ms");
+
+    // --- End to end ---
+    const std::string path = Bench::tempPath("suite-load.db");
+    {
+        Vault vault = MakeVault(entries);
+        vault.setMasterPassword(PASSWORD);
+        vault.compact(path);
+    }
+
+    double kdfMs = Bench::measureMs([&] { Crypto::KeyHandle::derive(PASSWORD, Crypto::generateSalt()); });
+    bool loaded = true;
+    double loadMs = Bench::measureMs([&] {
+        Vault vault;
+        loaded = vault.load(path, PASSWORD) && loaded;
+    });
+    if (!loaded) std::printf("load failed!\n");
+
+    Bench::resetHeapPeak();
+    {
+        Vault vault;
+        vault.load(path, PASSWORD);
+    }
+    size_t heapPeak = Bench::heapPeakBytes();
+
+    Bench::report("vault file", std::filesystem::file_size(path) / (1024.0 * 1024.0), "MB");
+    Bench::report("load", loadMs, "ms");
+    Bench::report("load excl. key derivation", loadMs - kdfMs, "ms");
+    Bench::report("load heap peak", heapPeak / (1024.0 * 1024.0), "MB");
+    std::filesystem::remove(path);
+}
+
+BENCH_CASE(suite_save, "Vault::save: encoding alone, then compaction and appending small edits") {
+    PrintSpec();
+    std::vector<PasswordEntry> entries = Bench::generateEntries(Bench::vaultSpec());
+
+    // --- Micro ---
+    double encodeMs = Bench::measureMs([&] { EntryCodec::encodeEntries(entries); });
+    Bench::report("encode entries", encodeMs, "ms");
+
+    // --- End to end ---
+    const std::string path = Bench::tempPath("suite-save.db");
+    Vault vault = MakeVault(entries);
+    vault.setMasterPassword(PASSWORD);
+
+    double compactMs = Bench::measureMs([&] { vault.compact(path); });
+
+    // Each save appends only what changed; compacting between measurements
+    // keeps the log from growing across repeats.
+    auto editAndSave = [&](size_t edits) {
+        double best = 0.0;
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            vault.compact(path);
+            for (size_t i = 0; i < edits; ++i) {
+                vault.editEntry(entries[i * entries.size() / edits].id, [](PasswordEntry& entry) { entry.notes += "!"; });
+            }
+            double ms = Bench::measureMs([&] { vault.save(path); }, 1);
+            if (repeat == 0 || ms < best) best = ms;
+        }
+        return best;
+    };
+    size_t onePercent = std::max<size_t>(1, entries.size() / 100);
+
+    Bench::report("compact", compactMs, "ms");
+    Bench::report("save 1 edit", editAndSave(1), "ms");
+    Bench::report("save " + std::to_string(onePercent) + " edits (1%)", editAndSave(onePercent), "ms");
+    std::filesystem::remove(path);
+}
+
+BENCH_CASE(suite_filter, "Title filter: recomputing the entry list per query, and typing a query one key at a time") {
+    PrintSpec();
+    Vault vault = MakeVault(Bench::generateEntries(Bench::vaultSpec()));
+    EntryView view;
+
+    // --- Micro: one recompute per filter, from broad to narrow ---
+    for (const std::string filter : { "", "s", "se", "server", "server portal" }) {
+        double ms = Bench::measureMs([&] {
+            view.invalidate();
+            view.update(vault, filter, EntryView::SortOrder::Title);
+        });
+        Bench::report("filter \"" + filter + "\" (" + std::to_string(view.size()) + " rows)", ms, "ms");
+    }
+
+    // --- End to end: every keystroke of a query, as the UI sees them ---
+    const std::string query = "staging server";
+    double typingMs = Bench::measureMs([&] {
+        view.invalidate();
+        view.update(vault, "", EntryView::SortOrder::Title);
+        for (size_t length = 1; length <= query.size(); ++length) {
+            view.update(vault, query.substr(0, length), EntryView::SortOrder::Title);
+        }
+    });
+    Bench::report("type \"" + query + "\"", typingMs, "ms");
+    Bench::report("per keystroke", typingMs / query.size(), "ms");
+}
+
+BENCH_CASE(suite_generate, "Password generator: passwords/s by length, one at a time and batched, and regenerating every password in the vault") {
+    PrintSpec();
+
+    // --- Micro ---
+    const int count = 20000;
+    for (int length : { 12, 20, 64 }) {
+        size_t sink = 0;
+        double ms = Bench::measureMs([&] {
+            for (int i = 0; i < count; ++i) sink += PasswordGenerator::generate(length, true, true, true, true).size();
+        });
+        if (sink == 0) std::printf("(unreachable)\n");
+        Bench::report("length " + std::to_string(length), count / (ms / 1000.0), "passwords/s");
+
+        // The same passwords as one batch, drawn from one buffer of randomness
+        double batchMs = Bench::measureMs([&] {
+            PasswordGenerator::generateBatch(PasswordGenerator::charset(PasswordGenerator::AllClasses), length, count);
+        });
+        Bench::report("batch length " + std::to_string(length), count / (batchMs / 1000.0), "passwords/s");
+    }
+    double passphraseMs = Bench::measureMs([&] {
+        PasswordGenerator::generatePassphrases(PasswordGenerator::defaultWordlist(), 6, "-", count);
+    });
+    Bench::report("batch passphrase 6 words", count / (passphraseMs / 1000.0), "passwords/s");
+
+    // --- End to end: rotate every password, as a bulk "regenerate" would ---
+    std::vector<PasswordEntry> entries = Bench::generateEntries(Bench::vaultSpec());
+    Vault vault = MakeVault(entries);
+    const int length = (int)Bench::vaultSpec().passwordLength;
+    double rotateMs = Bench::measureMs([&] {
+        for (const auto& entry : entries) {
+            vault.editEntry(entry.id, [&](PasswordEntry& e) { e.password = PasswordGenerator::generate(length, true, true, true, true); });
+        }
+    });
+    double rotateBatchMs = Bench::measureMs([&] {
+        auto batch = PasswordGenerator::generateBatch(PasswordGenerator::charset(PasswordGenerator::AllClasses), length, entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            vault.editEntry(entries[i].id, [&](PasswordEntry& entry) { entry.password = std::move(batch->passwords[i]); });
+        }
+    });
+    Bench::report("rotate all passwords", rotateMs, "ms");
+    Bench::report("rotate all passwords (batch)", rotateBatchMs, "ms");
+}
@@ -0,0 +1,64 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+BENCH_CASE(vault_index, "Lookup/edit/delete on a 100k-entry vault: linear scan vs id index") {
+    const size_t count = 100000;
+    const size_t operations = 1000;
+    std::vector<PasswordEntry> entries = Bench::makeEntries(count);
+
+    // The same random ids for both paths
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> ids;
+    for (size_t i = 0; i < operations; ++i) {
+        ids.push_back(entries[rng() % count].id);
+    }
+
+    // --- Before: a plain vector, scanned on every lookup ---
+    double scanLookupMs = Bench::measureMs([&] {
+        for (uint64_t id : ids) {
+            auto it = std::find_if(entries.begin(), entries.end(), [id](const PasswordEntry& e) { return e.id == id; });
+            it->notes += "x";
+        }
+    }, 1);
+
+    std::vector<PasswordEntry> scanned = entries;
+    double scanDeleteMs = Bench::measureMs([&] {
+        for (uint64_t id : ids) {
+            scanned.erase(std::remove_if(scanned.begin(), scanned.end(), [id](const PasswordEntry& e) { return e.id == id; }), scanned.end());
+        }
+    }, 1);
+
+    // --- After: Vault's id -> slot index ---
+    Vault vault;
+    for (const auto& entry : entries) vault.addEntry(entry);
+
+    double indexLookupMs = Bench::measureMs([&] {
+        for (uint64_t id : ids) {
+            vault.editEntry(id, [](PasswordEntry& entry) { entry.notes += "x"; });
+        }
+    }, 1);
+
+    std::vector<EntryHandle> handles;
+    for (uint64_t id : ids) handles.push_back(vault.findEntry(id));
+    double handleResolveMs = Bench::measureMs([&] {
+        size_t live = 0;
+        for (EntryHandle handle : handles) live += (bool)vault.getEntry(handle);
+        if (live == 0) std::printf("(unreachable)\n");
+    }, 1);
+
+    double indexDeleteMs = Bench::measureMs([&] {
+        for (uint64_t id : ids) {
+            vault.deleteEntry(id);
+        }
+    }, 1);
+
+    std::printf("%zu operations on %zu entries\n", operations, count);
+    std::printf("%-24s %12s %12s\n", "", "scan ms", "index ms");
+    std::printf("%-24s %12.3f %12.3f\n", "lookup + edit", scanLookupMs, indexLookupMs);
+    std::printf("%-24s %12.3f %12.3f\n", "delete", scanDeleteMs, indexDeleteMs);
+    std::printf("%-24s %12s %12.3f\n", "resolve handle", "-", handleResolveMs);
+}
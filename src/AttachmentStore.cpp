@@ -0,0 +1,142 @@
+#include "AttachmentStore.h"
+
+#include <sodium.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+    const unsigned char MAGIC[4] = { 'C', 'V', 'A', 'T' };
+    const uint8_t VERSION = 1;
+    const size_t HEADER_BYTES = 4 + 1 + 3;
+
+    // Ids come from the (authenticated) vault, but they still become file
+    // names, so only ever accept what newId() produces.
+    bool isValidId(const std::string& id) {
+        return id.size() == 2 * Crypto::SALT_BYTES &&
+               std::all_of(id.begin(), id.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+    }
+
+    std::string newId() {
+        std::vector<unsigned char> bytes = Crypto::generateSalt(); // any random bytes will do
+        std::string hex(bytes.size() * 2 + 1, '\0');
+        sodium_bin2hex(&hex[0], hex.size(), bytes.data(), bytes.size());
+        hex.pop_back();
+        return hex;
+    }
+
+} // namespace
+
+AttachmentStore::AttachmentStore(const std::string& vaultPath)
+    : m_directory(vaultPath + ".attachments") {}
+
+std::string AttachmentStore::directory() const {
+    return m_directory;
+}
+
+std::string AttachmentStore::pathFor(const std::string& attachmentId) const {
+    return (std::filesystem::path(m_directory) / (attachmentId + ".bin")).string();
+}
+
+std::optional<Attachment> AttachmentStore::import(const std::string& sourcePath, const Crypto::KeyHandle& key) const {
+    std::error_code ec;
+
+    // 1. Open the source
+    std::ifstream in(sourcePath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open attachment source: " << sourcePath << std::endl;
+        return std::nullopt;
+    }
+    Attachment attachment;
+    attachment.id = newId();
+    attachment.name = std::filesystem::path(sourcePath).filename().string();
+    attachment.size = std::filesystem::file_size(sourcePath, ec);
+    if (ec) {
+        std::cerr << "Failed to read attachment source: " << ec.message() << std::endl;
+        return std::nullopt;
+    }
+
+    // 2. Encrypt into a temp file and rename it into place, so a crash never
+    // leaves a half-written attachment under a real id
+    std::filesystem::create_directories(m_directory, ec);
+    std::string path = pathFor(attachment.id);
+    std::string tmpPath = path + ".tmp";
+    bool ok;
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to create attachment file in " << m_directory << std::endl;
+            return std::nullopt;
+        }
+        out.write((const char*)MAGIC, sizeof(MAGIC));
+        out.put((char)VERSION);
+        out.write("\0\0\0", 3);
+        ok = Crypto::encryptStream(in, out, key, attachment.id);
+    }
+
+    if (ok) {
+        std::filesystem::rename(tmpPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::cerr << "Failed to write attachment " << attachment.name << "." << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+        return std::nullopt;
+    }
+    return attachment;
+}
+
+bool AttachmentStore::exportTo(const Attachment& attachment, const std::string& destPath, const Crypto::KeyHandle& key) const {
+    if (!isValidId(attachment.id)) {
+        return false;
+    }
+
+    // 1. Check the header
+    std::ifstream in(pathFor(attachment.id), std::ios::binary);
+    unsigned char header[HEADER_BYTES];
+    if (!in || !in.read((char*)header, sizeof(header))) {
+        std::cerr << "Attachment file for " << attachment.name << " is missing." << std::endl;
+        return false;
+    }
+    if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || header[4] != VERSION) {
+        std::cerr << "Attachment file for " << attachment.name << " is not a supported attachment." << std::endl;
+        return false;
+    }
+
+    // 2. Decrypt next to the destination and only rename it into place once
+    // every chunk has authenticated
+    std::string tmpPath = destPath + ".tmp";
+    bool ok;
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to open " << destPath << " for writing." << std::endl;
+            return false;
+        }
+        ok = Crypto::decryptStream(in, out, key, attachment.id);
+    }
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmpPath, destPath, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::cerr << "Failed to decrypt attachment " << attachment.name << " (corrupt or tampered with)." << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+    }
+    return ok;
+}
+
+bool AttachmentStore::remove(const std::string& attachmentId) const {
+    if (!isValidId(attachmentId)) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::remove(pathFor(attachmentId), ec);
+    return !ec;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "Crypto.h"
+#include "Vault.h"
+
+/**
+ * @brief Stores attachment contents out of line, one encrypted file per
+ * attachment, in a directory next to the vault ("vault.db.attachments/").
+ *
+ * File: [MAGIC "CVAT"][VERSION (1)][RESERVED (3)][Crypto::encryptStream stream]
+ *
+ * Files are streamed through Crypto::encryptStream/decryptStream a chunk at
+ * a time, so memory use stays constant however large the attachment is, and
+ * unlocking the vault never reads them. The attachment id is authenticated
+ * with every chunk, so one attachment's file can't be swapped for another's.
+ */
+class AttachmentStore {
+public:
+    /**
+     * @param vaultPath The vault file the attachments belong to.
+     */
+    explicit AttachmentStore(const std::string& vaultPath);
+
+    /**
+     * @brief Encrypts a file into the store under a fresh id.
+     * @return The new attachment (id, file name, size), or std::nullopt on failure.
+     */
+    std::optional<Attachment> import(const std::string& sourcePath, const Crypto::KeyHandle& key) const;
+
+    /**
+     * @brief Decrypts an attachment to a file. Nothing is left at destPath on failure.
+     * @return False if the file is missing, fails authentication or can't be written.
+     */
+    bool exportTo(const Attachment& attachment, const std::string& destPath, const Crypto::KeyHandle& key) const;
+
+    /**
+     * @brief Deletes an attachment's encrypted file. Missing files count as removed.
+     */
+    bool remove(const std::string& attachmentId) const;
+
+    std::string directory() const;
+    std::string pathFor(const std::string& attachmentId) const;
+
+private:
+    std::string m_directory;
+};
@@ -0,0 +1,188 @@
+#include "AutoSaver.h"
+
+#include <algorithm>
+
+AutoSaver::AutoSaver() : AutoSaver(Settings()) {}
+
+AutoSaver::AutoSaver(Settings settings) : m_settings(settings) {
+    m_worker = std::thread(&AutoSaver::workerLoop, this);
+}
+
+AutoSaver::~AutoSaver() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_worker.join(); // Finishes an in-flight write first
+}
+
+void AutoSaver::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this] { return m_stop || m_queued.has_value(); });
+        if (!m_queued) {
+            return; // Stopping with nothing left to write
+        }
+
+        Vault::SaveSnapshot snapshot = std::move(*m_queued);
+        m_queued.reset();
+        lock.unlock();
+
+        // Serialization, encryption and I/O all happen here, off the UI thread
+        auto start = Clock::now();
+        Vault::SaveResult result = Vault::writeSnapshot(snapshot);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        lock.lock();
+        m_completed = Completed{ std::move(snapshot), result, ms };
+        m_busy = false;
+        m_cv.notify_all();
+        if (m_notify) m_notify(); // Under the lock, so it can't change mid-call
+    }
+}
+
+void AutoSaver::collect(Vault& vault) {
+    std::optional<Completed> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        completed.swap(m_completed);
+    }
+    if (!completed) {
+        return;
+    }
+
+    m_saving = false;
+    m_inFlight = 0;
+    m_lastSaveMs = completed->ms;
+    if (completed->result == Vault::SaveResult::Saved) {
+        ++m_savesCompleted;
+        m_lastError.clear();
+        return;
+    }
+
+    // Put the changes back so they go out with the next save
+    vault.restoreSnapshot(completed->snapshot, completed->result);
+    if (completed->result == Vault::SaveResult::Failed) {
+        m_lastError = "Failed to save vault!";
+        m_retryAfter = Clock::now() + m_settings.retryDelay;
+    } else {
+        m_saveRequested = true; // The file changed under us: compact right away
+    }
+}
+
+void AutoSaver::poll(Vault& vault, const std::string& filepath) {
+    collect(vault);
+
+    auto now = Clock::now();
+    if (vault.revision() != m_seenRevision) {
+        m_seenRevision = vault.revision();
+        m_lastChange = now;
+    }
+    m_queueDepth = vault.pendingChanges() + m_inFlight;
+
+    // An explicit save goes ahead even with nothing pending
+    if (!vault.hasUnsavedChanges() && !m_saveRequested) {
+        m_firstChange.reset();
+        return;
+    }
+    if (!m_firstChange) {
+        m_firstChange = now;
+    }
+
+    // 1. Is a save due?
+    bool due = m_saveRequested ||
+        (m_enabled && now >= m_retryAfter &&
+         (now - m_lastChange >= m_settings.debounce || now - *m_firstChange >= m_settings.maxDelay));
+    if (!due) {
+        return;
+    }
+
+    // 2. Only one write at a time; whatever changes meanwhile waits for the next
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_busy) {
+        return;
+    }
+
+    // 3. Snapshot on this thread, write on the worker
+    m_queued = vault.takeSaveSnapshot(filepath);
+    m_inFlight = m_queued->changedIds.size();
+    m_saving = true;
+    m_busy = true;
+    m_saveRequested = false;
+    m_firstChange.reset();
+    m_cv.notify_all();
+}
+
+void AutoSaver::requestSave() {
+    m_saveRequested = true;
+    m_retryAfter = Clock::time_point();
+}
+
+bool AutoSaver::flush(Vault& vault, const std::string& filepath) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_busy; });
+    }
+    collect(vault);
+
+    bool saved = !vault.hasUnsavedChanges() || vault.save(filepath);
+    if (!saved) {
+        m_lastError = "Failed to save vault!";
+    }
+    m_saveRequested = false;
+    m_firstChange.reset();
+    m_queueDepth = vault.pendingChanges();
+    return saved;
+}
+
+void AutoSaver::setEnabled(bool enabled) {
+    m_enabled = enabled;
+}
+
+bool AutoSaver::enabled() const {
+    return m_enabled;
+}
+
+std::optional<AutoSaver::Clock::time_point> AutoSaver::nextPollDue() const {
+    if (m_saving) {
+        return std::nullopt;
+    }
+    if (m_saveRequested) {
+        return Clock::now();
+    }
+    if (!m_firstChange) {
+        return std::nullopt;
+    }
+    if (!m_enabled) {
+        return std::nullopt;
+    }
+    // Mirrors the test in poll()
+    Clock::time_point due = std::min(m_lastChange + m_settings.debounce, *m_firstChange + m_settings.maxDelay);
+    return std::max(due, m_retryAfter);
+}
+
+void AutoSaver::setNotifier(std::function<void()> notify) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_notify = std::move(notify);
+}
+
+size_t AutoSaver::queueDepth() const {
+    return m_queueDepth;
+}
+
+bool AutoSaver::saveInFlight() const {
+    return m_saving;
+}
+
+double AutoSaver::lastSaveMs() const {
+    return m_lastSaveMs;
+}
+
+uint64_t AutoSaver::savesCompleted() const {
+    return m_savesCompleted;
+}
+
+const std::string& AutoSaver::lastError() const {
+    return m_lastError;
+}
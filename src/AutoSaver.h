@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Vault.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Saves the vault in the background shortly after it changes.
+ *
+ * The UI thread calls poll() once per frame. Once edits have settled for the
+ * debounce interval (or have been pending for maxDelay), poll() takes a
+ * Vault::SaveSnapshot and hands it to a worker thread, which encrypts and
+ * writes it while the UI keeps running. Edits made in the meantime pile up in
+ * the vault and go out together in the next save, so a burst of changes costs
+ * one write.
+ *
+ * Compactions go to a temp file that is renamed over the vault; appends are
+ * single writes whose torn tail, if any, is dropped on the next load.
+ */
+class AutoSaver {
+public:
+    struct Settings {
+        std::chrono::milliseconds debounce{ 1500 };  // Quiet time before saving
+        std::chrono::milliseconds maxDelay{ 10000 }; // Save at least this often while edits keep coming
+        std::chrono::milliseconds retryDelay{ 5000 }; // Wait after a failed save
+    };
+
+    AutoSaver();
+    explicit AutoSaver(Settings settings);
+    ~AutoSaver();
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    /**
+     * @brief Call once per frame with the live vault. Collects a finished save
+     * and starts the next one when it's due. Never waits for I/O.
+     */
+    void poll(Vault& vault, const std::string& filepath);
+
+    /**
+     * @brief Skips the debounce: the next poll() saves right away, even when
+     * autosave is disabled. Used by the "Save Vault" button.
+     */
+    void requestSave();
+
+    /**
+     * @brief Waits for any in-flight save, then writes whatever is left on
+     * this thread. Used before locking.
+     * @return True if everything is on disk.
+     */
+    bool flush(Vault& vault, const std::string& filepath);
+
+    void setEnabled(bool enabled);
+    bool enabled() const;
+
+    /**
+     * @brief When poll() next has work to do if nothing else changes: the
+     * pending edits coming due. std::nullopt if there's nothing to save or a
+     * save is in flight (its end calls the notifier instead).
+     */
+    std::optional<std::chrono::steady_clock::time_point> nextPollDue() const;
+
+    /**
+     * @brief Called on the worker thread each time a save finishes, e.g. to
+     * wake a UI loop that is waiting for events. Set it before any save.
+     */
+    void setNotifier(std::function<void()> notify);
+
+    // --- Counters (for the UI) ---
+
+    /**
+     * @brief Changed entries not on disk yet: waiting in the vault plus in flight.
+     */
+    size_t queueDepth() const;
+
+    bool saveInFlight() const;
+
+    /**
+     * @brief How long the last completed background write took, in milliseconds.
+     */
+    double lastSaveMs() const;
+
+    /**
+     * @brief Number of writes completed, each possibly covering many edits.
+     */
+    uint64_t savesCompleted() const;
+
+    /**
+     * @brief Why the last save failed; empty once a save succeeds.
+     */
+    const std::string& lastError() const;
+
+private:
+    struct Completed {
+        Vault::SaveSnapshot snapshot;
+        Vault::SaveResult result;
+        double ms;
+    };
+
+    void workerLoop();
+    void collect(Vault& vault);
+
+    Settings m_settings;
+
+    // Shared with the worker, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::optional<Vault::SaveSnapshot> m_queued;
+    std::optional<Completed> m_completed;
+    bool m_busy = false;
+    bool m_stop = false;
+    std::thread m_worker;
+    std::function<void()> m_notify;
+
+    // UI thread only
+    using Clock = std::chrono::steady_clock;
+    bool m_enabled = true;
+    bool m_saveRequested = false;
+    uint64_t m_seenRevision = 0;
+    std::optional<Clock::time_point> m_firstChange;
+    Clock::time_point m_lastChange;
+    Clock::time_point m_retryAfter;
+    bool m_saving = false;   // A snapshot is with the worker
+    size_t m_inFlight = 0;   // Changes covered by that snapshot
+    size_t m_queueDepth = 0;
+    double m_lastSaveMs = 0.0;
+    uint64_t m_savesCompleted = 0;
+    std::string m_lastError;
+};
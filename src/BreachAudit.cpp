@@ -0,0 +1,466 @@
+#include "BreachAudit.h"
+#include "Crypto.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include <sodium.h>
+
+namespace {
+
+    const size_t SHA1_HEX = 40;
+    const size_t LINEAR_SCAN_BYTES = 512; // Below this, scanning beats another probe
+
+    // Bloom filter file: [MAGIC "CVBF"][VERSION (1)][HASHES (1)][RESERVED (2)][BITS (8, LE)][BIT ARRAY]
+    const unsigned char BLOOM_MAGIC[4] = { 'C', 'V', 'B', 'F' };
+    const uint8_t BLOOM_VERSION = 1;
+    const size_t BLOOM_HEADER_BYTES = 4 + 1 + 1 + 2 + 8;
+
+    // The HIBP text format averages a little over this per line; used to size
+    // a filter without a counting pass
+    const size_t TEXT_BYTES_PER_HASH = 44;
+
+    // Corpus chunks per thread when building a filter
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    int hexValue(unsigned char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    bool parseHex(const unsigned char* p, BreachAudit::Sha1& hash) {
+        for (size_t i = 0; i < hash.size(); ++i) {
+            int high = hexValue(p[2 * i]);
+            int low = hexValue(p[2 * i + 1]);
+            if (high < 0 || low < 0) return false;
+            hash[i] = (unsigned char)(high << 4 | low);
+        }
+        return true;
+    }
+
+    // Orders `hash` against the hex digest at p, nibble by nibble, so most
+    // records are told apart in a few characters without parsing them.
+    // Sets `ok` to false on a character that isn't hex.
+    int compareHex(const BreachAudit::Sha1& hash, const unsigned char* p, bool& ok) {
+        for (size_t i = 0; i < SHA1_HEX; ++i) {
+            int digit = hexValue(p[i]);
+            if (digit < 0) {
+                ok = false;
+                return 0;
+            }
+            int nibble = i % 2 == 0 ? hash[i / 2] >> 4 : hash[i / 2] & 0x0F;
+            if (nibble != digit) return nibble < digit ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // Big-endian, so prefixes order like the hashes
+    uint64_t prefix(const BreachAudit::Sha1& hash) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v = (v << 8) | hash[i];
+        return v;
+    }
+
+    uint64_t getU64(const unsigned char* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+        return v;
+    }
+
+    // Bloom filter probes by double hashing. The digest is already uniform,
+    // so its own bytes serve as the two hashes.
+    template <typename Fn>
+    void forEachBloomBit(const BreachAudit::Sha1& hash, uint64_t bits, unsigned hashes, Fn fn) {
+        uint64_t h1 = getU64(hash.data());
+        uint64_t h2 = getU64(hash.data() + 8) | 1;
+        for (unsigned i = 0; i < hashes; ++i) {
+            fn((h1 + i * h2) % bits);
+        }
+    }
+
+    uint32_t rotl(uint32_t v, int n) {
+        return (v << n) | (v >> (32 - n));
+    }
+
+    bool isTextCorpus(const unsigned char* data, size_t size) {
+        BreachAudit::Sha1 hash;
+        return size > SHA1_HEX && data[SHA1_HEX] == ':' && parseHex(data, hash);
+    }
+}
+
+// --- SHA-1 ---
+// libsodium has no SHA-1, and the corpus is keyed by it. It isn't used for
+// any security property here, only to find a password in the list.
+
+BreachAudit::Sha1 BreachAudit::sha1(std::string_view data) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    auto block = [&](const unsigned char* p) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            uint32_t t = rotl(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rotl(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+        sodium_memzero(w, sizeof(w));
+    };
+
+    // 1. Whole blocks straight from the input
+    const unsigned char* p = (const unsigned char*)data.data();
+    size_t full = data.size() / 64 * 64;
+    for (size_t i = 0; i < full; i += 64) block(p + i);
+
+    // 2. The tail, the 0x80 marker and the bit length, in one or two blocks
+    unsigned char tail[128] = {};
+    size_t rest = data.size() - full;
+    std::memcpy(tail, p + full, rest);
+    tail[rest] = 0x80;
+    size_t tailBytes = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bitLength = (uint64_t)data.size() * 8;
+    for (int i = 0; i < 8; ++i) tail[tailBytes - 1 - i] = (unsigned char)(bitLength >> (8 * i));
+    for (size_t i = 0; i < tailBytes; i += 64) block(tail + i);
+    sodium_memzero(tail, sizeof(tail));
+
+    Sha1 digest;
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 4; ++j) digest[4 * i + j] = (unsigned char)(h[i] >> (24 - 8 * j));
+    }
+    return digest;
+}
+
+// --- Opening ---
+
+bool BreachAudit::open(const std::string& corpusPath) {
+    m_bloom.close();
+    m_bloomBits = 0;
+    if (!m_corpus.open(corpusPath)) {
+        std::cerr << "Failed to open breach corpus " << corpusPath << "." << std::endl;
+        return false;
+    }
+
+    if (isTextCorpus(m_corpus.data(), m_corpus.size())) {
+        m_format = Format::Text;
+    } else if (m_corpus.size() > 0 && m_corpus.size() % sizeof(Sha1) == 0) {
+        m_format = Format::Binary;
+    } else {
+        std::cerr << "Breach corpus " << corpusPath << " is neither SHA1:COUNT lines nor packed SHA-1 digests." << std::endl;
+        m_corpus.close();
+        return false;
+    }
+    return true;
+}
+
+bool BreachAudit::openBloomFilter(const std::string& path) {
+    m_bloomBits = 0;
+    if (!m_bloom.open(path)) {
+        std::cerr << "Failed to open Bloom filter " << path << "." << std::endl;
+        return false;
+    }
+
+    const unsigned char* p = m_bloom.data();
+    if (m_bloom.size() < BLOOM_HEADER_BYTES || std::memcmp(p, BLOOM_MAGIC, sizeof(BLOOM_MAGIC)) != 0 || p[4] != BLOOM_VERSION) {
+        std::cerr << "Not a Bloom filter: " << path << "." << std::endl;
+        m_bloom.close();
+        return false;
+    }
+    uint64_t bits = getU64(p + 8);
+    if (bits == 0 || p[5] == 0 || m_bloom.size() != BLOOM_HEADER_BYTES + (bits + 7) / 8) {
+        std::cerr << "Bloom filter " << path << " is corrupt." << std::endl;
+        m_bloom.close();
+        return false;
+    }
+    m_bloomHashes = p[5];
+    m_bloomBits = bits;
+    return true;
+}
+
+bool BreachAudit::buildBloomFilter(const std::string& corpusPath, const std::string& bloomPath, ThreadPool& pool, double bitsPerHash) {
+    BreachAudit corpus;
+    if (!corpus.open(corpusPath)) {
+        return false;
+    }
+    const size_t size = corpus.m_corpus.size();
+
+    // 1. Size it for the corpus: bits per hash, and the number of probes
+    // that minimizes false positives at that size (ln 2 per bit)
+    uint64_t hashes = corpus.m_format == Format::Text ? size / TEXT_BYTES_PER_HASH + 1 : size / sizeof(Sha1);
+    uint64_t bits = std::max<uint64_t>(64, (uint64_t)std::ceil(hashes * std::max(bitsPerHash, 1.0)));
+    bits = (bits + 63) / 64 * 64;
+    unsigned probes = (unsigned)std::clamp(std::lround(std::max(bitsPerHash, 1.0) * std::log(2.0)), 1L, 16L);
+    std::unique_ptr<std::atomic<uint64_t>[]> words(new std::atomic<uint64_t>[bits / 64]);
+    for (uint64_t i = 0; i < bits / 64; ++i) words[i].store(0, std::memory_order_relaxed);
+
+    // 2. Set every hash's bits, in chunks cut at record boundaries
+    const size_t chunks = std::max<size_t>(1, std::min<size_t>(size / (1 << 20), pool.concurrency() * CHUNKS_PER_THREAD));
+    std::atomic<bool> malformed{ false };
+    pool.parallelFor(chunks, [&](size_t c) {
+        size_t pos = corpus.recordStart(size / chunks * c);
+        size_t end = c + 1 == chunks ? size : corpus.recordStart(size / chunks * (c + 1));
+        Sha1 hash;
+        while (pos < end) {
+            if (!corpus.readRecord(pos, hash)) {
+                malformed = true;
+                return;
+            }
+            forEachBloomBit(hash, bits, probes, [&](uint64_t bit) {
+                words[bit / 64].fetch_or(1ull << (bit % 64), std::memory_order_relaxed);
+            });
+            pos = corpus.nextRecord(pos);
+        }
+    });
+    if (malformed) {
+        std::cerr << "Breach corpus " << corpusPath << " has a malformed line." << std::endl;
+        return false;
+    }
+
+    // 3. Write it out, little-endian like the header
+    std::vector<unsigned char> out(BLOOM_MAGIC, BLOOM_MAGIC + sizeof(BLOOM_MAGIC));
+    out.push_back(BLOOM_VERSION);
+    out.push_back((unsigned char)probes);
+    out.insert(out.end(), 2, 0);
+    for (int i = 0; i < 8; ++i) out.push_back((unsigned char)(bits >> (8 * i)));
+    out.reserve(out.size() + bits / 8);
+    for (uint64_t i = 0; i < bits / 64; ++i) {
+        uint64_t word = words[i].load(std::memory_order_relaxed);
+        for (int b = 0; b < 8; ++b) out.push_back((unsigned char)(word >> (8 * b)));
+    }
+
+    std::ofstream file(bloomPath, std::ios::binary | std::ios::trunc);
+    file.write((const char*)out.data(), out.size());
+    if (!file.flush()) {
+        std::cerr << "Failed to write Bloom filter " << bloomPath << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void BreachAudit::setSearch(Search search) {
+    m_search = search;
+}
+
+bool BreachAudit::isOpen() const {
+    return m_corpus.size() > 0;
+}
+
+// --- Lookups ---
+
+bool BreachAudit::mayContain(const Sha1& hash) const {
+    if (m_bloomBits == 0) {
+        return true;
+    }
+    const unsigned char* bitArray = m_bloom.data() + BLOOM_HEADER_BYTES;
+    bool present = true;
+    forEachBloomBit(hash, m_bloomBits, m_bloomHashes, [&](uint64_t bit) {
+        present = present && (bitArray[bit / 8] >> (bit % 8) & 1);
+    });
+    return present;
+}
+
+size_t BreachAudit::recordStart(size_t pos) const {
+    const size_t size = m_corpus.size();
+    if (pos >= size) {
+        return size;
+    }
+    if (m_format == Format::Binary) {
+        return std::min(size, (pos + sizeof(Sha1) - 1) / sizeof(Sha1) * sizeof(Sha1));
+    }
+    // The first line starting at or after pos
+    if (pos == 0) {
+        return 0;
+    }
+    const void* newline = std::memchr(m_corpus.data() + pos - 1, '\n', size - pos + 1);
+    return newline ? (const unsigned char*)newline - m_corpus.data() + 1 : size;
+}
+
+size_t BreachAudit::nextRecord(size_t pos) const {
+    // A text line holds at least the digest and a ':'; skip straight past them
+    return m_format == Format::Binary ? pos + sizeof(Sha1) : recordStart(pos + SHA1_HEX + 1);
+}
+
+bool BreachAudit::readRecord(size_t pos, Sha1& hash) const {
+    if (m_format == Format::Binary) {
+        std::memcpy(hash.data(), m_corpus.data() + pos, sizeof(Sha1));
+        return true;
+    }
+    return m_corpus.size() - pos >= SHA1_HEX && parseHex(m_corpus.data() + pos, hash);
+}
+
+int BreachAudit::compareRecord(const Sha1& hash, size_t pos, bool& ok) const {
+    if (m_format == Format::Binary) {
+        return std::memcmp(hash.data(), m_corpus.data() + pos, sizeof(Sha1));
+    }
+    if (m_corpus.size() - pos < SHA1_HEX) {
+        ok = false;
+        return 0;
+    }
+    return compareHex(hash, m_corpus.data() + pos, ok);
+}
+
+uint64_t BreachAudit::readCount(size_t pos) const {
+    if (m_format == Format::Binary) {
+        return 0;
+    }
+    uint64_t count = 0;
+    const unsigned char* end = m_corpus.data() + m_corpus.size();
+    for (const unsigned char* p = m_corpus.data() + pos + SHA1_HEX + 1; p < end && *p >= '0' && *p <= '9'; ++p) {
+        count = count * 10 + (*p - '0');
+    }
+    return count;
+}
+
+std::optional<uint64_t> BreachAudit::search(const Sha1& hash) const {
+    // Invariant: if present, the hash's record starts in [lo, hi), and lo is
+    // a record start. loKey/hiKey bound the prefixes in between.
+    const uint64_t key = prefix(hash);
+    size_t lo = 0, hi = m_corpus.size();
+    uint64_t loKey = 0, hiKey = UINT64_MAX;
+    bool interpolate = m_search == Search::Interpolation;
+    Sha1 probe;
+
+    // 1. Narrow the range: interpolation guesses where the hash should be
+    // from its prefix; every other step bisects, in case the guesses are poor
+    while (hi - lo > LINEAR_SCAN_BYTES) {
+        size_t guess = lo + (hi - lo) / 2;
+        if (interpolate && hiKey > loKey && key >= loKey && key <= hiKey) {
+            long double fraction = (long double)(key - loKey) / (long double)(hiKey - loKey);
+            guess = lo + (size_t)(fraction * (long double)(hi - lo));
+        }
+        if (m_search == Search::Interpolation) interpolate = !interpolate;
+
+        size_t pos = recordStart(guess);
+        if (pos >= hi) {
+            pos = recordStart(lo + (hi - lo) / 2);
+            if (pos >= hi) break; // One record left
+        }
+        if (!readRecord(pos, probe)) {
+            return std::nullopt;
+        }
+
+        int order = std::memcmp(hash.data(), probe.data(), sizeof(Sha1));
+        if (order == 0) {
+            return readCount(pos);
+        }
+        if (order < 0) {
+            hi = pos;
+            hiKey = prefix(probe);
+        } else {
+            lo = nextRecord(pos);
+            loKey = prefix(probe);
+        }
+    }
+
+    // 2. Scan the last few records
+    for (size_t pos = lo; pos < hi; pos = nextRecord(pos)) {
+        bool ok = true;
+        int order = compareRecord(hash, pos, ok);
+        if (!ok) return std::nullopt;
+        if (order == 0) return readCount(pos);
+        if (order < 0) break;
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> BreachAudit::lookup(const Sha1& hash) const {
+    if (!isOpen() || !mayContain(hash)) {
+        return std::nullopt;
+    }
+    return search(hash);
+}
+
+BreachAudit::Report BreachAudit::audit(const EntryStore& entries, ThreadPool& pool, const Progress& progress) const {
+    Report report;
+    std::vector<size_t> indices; // Entries with a password
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].passwordSummary().hasPassword) indices.push_back(i);
+    }
+    report.checked = indices.size();
+    if (indices.empty() || !isOpen()) {
+        return report;
+    }
+
+    const size_t chunks = std::min(indices.size(), pool.concurrency() * CHUNKS_PER_THREAD);
+    auto chunkRange = [&](size_t c) {
+        return std::make_pair(indices.size() * c / chunks, indices.size() * (c + 1) / chunks);
+    };
+    const size_t steps = indices.size() * 2;
+    std::atomic<size_t> done{ 0 };
+    std::atomic<bool> stopped{ false };
+    auto reportDone = [&](size_t count) {
+        size_t total = done += count;
+        if (progress && !progress(total, steps)) stopped = true;
+    };
+
+    // 1. Hash every password, opening each entry's secrets just for that.
+    // Unsalted SHA-1s of passwords are as good as the passwords to an
+    // attacker, so they stay in locked memory. An entry that won't open
+    // gets an all-zero hash, which no corpus holds.
+    Crypto::SecureBuffer hashes(indices.size() * sizeof(Sha1));
+    {
+        Diagnostics::ScopedTimer timer("audit.hash", indices.size());
+        pool.parallelFor(chunks, [&](size_t c) {
+            if (stopped) return;
+            auto [begin, end] = chunkRange(c);
+            for (size_t i = begin; i < end; ++i) {
+                auto secrets = entries[indices[i]].secrets();
+                Sha1 hash{};
+                if (secrets) hash = sha1(secrets->password);
+                std::memcpy(hashes.data() + i * sizeof(Sha1), hash.data(), sizeof(Sha1));
+                sodium_memzero(hash.data(), hash.size());
+            }
+            reportDone(end - begin);
+        });
+    }
+    if (stopped) {
+        return report;
+    }
+
+    // 2. Look them up: the filter first, then the corpus. Page faults on the
+    // mapping overlap across threads.
+    Diagnostics::ScopedTimer timer("audit.lookup", indices.size());
+    std::vector<std::vector<Finding>> found(chunks);
+    std::atomic<size_t> corpusLookups{ 0 };
+    pool.parallelFor(chunks, [&](size_t c) {
+        if (stopped) return;
+        auto [begin, end] = chunkRange(c);
+        Sha1 hash;
+        size_t lookups = 0;
+        for (size_t i = begin; i < end; ++i) {
+            std::memcpy(hash.data(), hashes.data() + i * sizeof(Sha1), sizeof(Sha1));
+            if (!mayContain(hash)) continue;
+            ++lookups;
+            if (auto count = search(hash)) {
+                found[c].push_back(Finding{ entries[indices[i]].id(), *count });
+            }
+        }
+        sodium_memzero(hash.data(), hash.size());
+        corpusLookups += lookups;
+        reportDone(end - begin);
+    });
+
+    for (auto& chunk : found) {
+        report.findings.insert(report.findings.end(), chunk.begin(), chunk.end());
+    }
+    report.corpusLookups = corpusLookups;
+    return report;
+}
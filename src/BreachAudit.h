@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "EntryStore.h"
+
+class ThreadPool;
+
+/**
+ * @brief Offline check of the vault's passwords against a local copy of a
+ * breached-password list, such as Have I Been Pwned's Pwned Passwords.
+ *
+ * Corpus formats (told apart by the first line):
+ *   text:   one "SHA1HEX:COUNT" line per password, sorted by hash (the HIBP
+ *           SHA-1 download "ordered by hash"); LF or CRLF
+ *   binary: 20-byte SHA-1 digests back to back, sorted; no counts
+ * The corpus is memory-mapped, never read whole, so a file of tens of GB
+ * costs only the pages the lookups touch. A lookup searches the file by
+ * byte position: interpolation steps (SHA-1 is uniform, so a hash sits
+ * about prefix / 2^64 of the way through) alternate with bisection, which
+ * keeps the worst case logarithmic. Typically a handful of pages are read.
+ *
+ * An optional Bloom filter, built once from the same corpus with
+ * buildBloomFilter() and mapped too, rules out most passwords without
+ * touching the corpus at all; that matters with a cold page cache or a
+ * spinning disk.
+ *
+ * Nothing is sent anywhere. Lookups are const and thread-safe; audit()
+ * spreads hashing and lookups over a ThreadPool.
+ */
+class BreachAudit {
+public:
+    using Sha1 = std::array<unsigned char, 20>;
+
+    enum class Search {
+        Interpolation, // Alternating with bisection (the default)
+        Binary
+    };
+
+    struct Finding {
+        uint64_t entryId;
+        uint64_t count; // Times the corpus says the password was seen; 0 if it doesn't say
+    };
+
+    struct Report {
+        std::vector<Finding> findings; // In entry order
+        size_t checked = 0;       // Entries with a password
+        size_t corpusLookups = 0; // Of those, the ones the Bloom filter didn't rule out
+    };
+
+    /**
+     * @brief Called by audit() as each chunk of work finishes, with the
+     * steps done so far out of the total (each password is hashed, then
+     * looked up: two steps). Runs on the pool's threads, possibly several
+     * at once. Return false to stop the audit early.
+     */
+    using Progress = std::function<bool(size_t done, size_t total)>;
+
+    BreachAudit() = default;
+    BreachAudit(const BreachAudit&) = delete;
+    BreachAudit& operator=(const BreachAudit&) = delete;
+
+    /**
+     * @brief Maps a corpus, replacing any previous one (and its Bloom filter).
+     * @return False if it can't be mapped or isn't in either format.
+     */
+    bool open(const std::string& corpusPath);
+
+    /**
+     * @brief Maps a filter made by buildBloomFilter() for the open corpus.
+     * @return False if it can't be mapped or is malformed.
+     */
+    bool openBloomFilter(const std::string& path);
+
+    /**
+     * @brief Builds a Bloom filter over every hash of a corpus, in one
+     * parallel pass, and writes it to `bloomPath`. At 10 bits per hash about
+     * 1% of clean passwords still go on to the corpus.
+     */
+    static bool buildBloomFilter(const std::string& corpusPath, const std::string& bloomPath, ThreadPool& pool, double bitsPerHash = 10.0);
+
+    void setSearch(Search search);
+
+    /**
+     * @brief Looks one hash up (Bloom filter first, if open).
+     * @return Its count (0 for the binary format), or std::nullopt if absent.
+     */
+    std::optional<uint64_t> lookup(const Sha1& hash) const;
+
+    /**
+     * @brief Hashes every entry's password and looks each up. Empty
+     * passwords are skipped. The hashes are kept in locked memory and wiped.
+     * @param progress Optional (see Progress). If it stops the audit, the
+     * report is incomplete.
+     */
+    Report audit(const EntryStore& entries, ThreadPool& pool, const Progress& progress = nullptr) const;
+
+    static Sha1 sha1(std::string_view data);
+
+    bool isOpen() const;
+
+private:
+    enum class Format { Text, Binary };
+
+    bool mayContain(const Sha1& hash) const;
+    std::optional<uint64_t> search(const Sha1& hash) const;
+    size_t recordStart(size_t pos) const;
+    size_t nextRecord(size_t pos) const;
+    bool readRecord(size_t pos, Sha1& hash) const;
+    int compareRecord(const Sha1& hash, size_t pos, bool& ok) const;
+    uint64_t readCount(size_t pos) const;
+
+    MappedFile m_corpus;
+    Format m_format = Format::Text;
+    Search m_search = Search::Interpolation;
+    MappedFile m_bloom;
+    uint64_t m_bloomBits = 0; // 0: no filter
+    unsigned m_bloomHashes = 0;
+};
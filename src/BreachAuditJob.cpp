@@ -0,0 +1,100 @@
+#include "BreachAuditJob.h"
+#include "ThreadPool.h"
+
+BreachAuditJob::~BreachAuditJob() {
+    cancel();
+    // A cancelled worker stops at the end of its current chunk; wait for it.
+    for (auto& worker : m_workers) {
+        worker.first.join();
+    }
+}
+
+void BreachAuditJob::start(const std::string& corpusPath, const std::string& bloomPath, EntryStore entries) {
+    if (status() == Status::Running) {
+        return;
+    }
+    reapFinished();
+
+    m_state = std::make_shared<State>();
+    m_workers.emplace_back(std::thread(&BreachAuditJob::run, m_state, corpusPath, bloomPath, std::move(entries), m_notify), m_state);
+}
+
+void BreachAuditJob::setNotifier(std::function<void()> notify) {
+    m_notify = std::move(notify);
+}
+
+void BreachAuditJob::cancel() {
+    if (m_state) {
+        m_state->cancelled = true;
+        m_state.reset();
+    }
+}
+
+BreachAuditJob::Status BreachAuditJob::status() const {
+    return m_state ? m_state->status.load() : Status::Idle;
+}
+
+float BreachAuditJob::progress() const {
+    if (!m_state || m_state->total == 0) {
+        return 0.0f;
+    }
+    return (float)m_state->done / (float)m_state->total;
+}
+
+std::string BreachAuditJob::error() const {
+    return m_state && m_state->status == Status::Failed ? m_state->error : std::string();
+}
+
+BreachAudit::Report BreachAuditJob::takeReport() {
+    BreachAudit::Report report = std::move(m_state->report);
+    m_state.reset();
+    return report;
+}
+
+void BreachAuditJob::reset() {
+    if (status() != Status::Running) {
+        m_state.reset();
+    }
+}
+
+void BreachAuditJob::reapFinished() {
+    for (auto it = m_workers.begin(); it != m_workers.end();) {
+        if (it->second->status != Status::Running) {
+            it->first.join(); // Already past its last write, so this is immediate
+            it = m_workers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BreachAuditJob::run(std::shared_ptr<State> state, std::string corpusPath, std::string bloomPath, EntryStore entries,
+                         std::function<void()> notify) {
+    BreachAudit audit;
+    BreachAudit::Report report;
+    bool ok = false;
+    std::string error;
+
+    // 1. Map the corpus and the optional filter
+    if (!audit.open(corpusPath)) {
+        error = "Can't read the corpus; it must be SHA1:COUNT lines or packed digests, sorted.";
+    } else if (!bloomPath.empty() && !audit.openBloomFilter(bloomPath)) {
+        error = "Can't read the Bloom filter.";
+    } else {
+        // 2. Audit the snapshot, stopping after the current chunk if cancelled
+        report = audit.audit(entries, ThreadPool::shared(), [&state](size_t done, size_t total) {
+            // Chunks finish out of order; keep the display from stepping back
+            state->total = total;
+            size_t seen = state->done;
+            while (seen < done && !state->done.compare_exchange_weak(seen, done)) {}
+            return !state->cancelled;
+        });
+        ok = true;
+    }
+
+    // 3. Publish the result. A cancelled job's report is simply dropped with the state.
+    state->report = std::move(report);
+    state->error = state->cancelled ? "Audit cancelled." : error;
+    state->status = ok && !state->cancelled ? Status::Succeeded : Status::Failed;
+    if (notify && !state->cancelled) notify();
+}
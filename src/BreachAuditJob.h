@@ -0,0 +1,104 @@
+#pragma once
+
+#include "BreachAudit.h"
+#include "EntryStore.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs BreachAudit::audit on a background thread so the render loop
+ * keeps drawing while a large vault is hashed and looked up.
+ *
+ * The job audits a copy of the vault's entries (an O(1) snapshot; see
+ * EntryStore), so the vault can change while it runs. As with UnlockJob, the
+ * UI thread calls start(), polls status()/progress() once per frame, and
+ * collects the report with takeReport() once it has Succeeded.
+ */
+class BreachAuditJob {
+public:
+    enum class Status {
+        Idle,
+        Running,
+        Succeeded,
+        Failed
+    };
+
+    BreachAuditJob() = default;
+    ~BreachAuditJob();
+    BreachAuditJob(const BreachAuditJob&) = delete;
+    BreachAuditJob& operator=(const BreachAuditJob&) = delete;
+
+    /**
+     * @brief Opens the corpus (and Bloom filter, if `bloomPath` isn't empty)
+     * and audits `entries` in the background.
+     * Ignored while a job is already running.
+     */
+    void start(const std::string& corpusPath, const std::string& bloomPath, EntryStore entries);
+
+    /**
+     * @brief Called on the worker thread when a job started after this
+     * finishes, unless it was cancelled, e.g. to wake a UI loop that is
+     * waiting for events.
+     */
+    void setNotifier(std::function<void()> notify);
+
+    /**
+     * @brief Abandons the running job and returns to Idle immediately. The
+     * worker stops after the chunk it is on and its result is discarded.
+     */
+    void cancel();
+
+    Status status() const;
+
+    /**
+     * @brief Fraction of the audit done, 0 to 1. Only meaningful while Running.
+     */
+    float progress() const;
+
+    /**
+     * @brief Why the job failed. Only meaningful when Failed.
+     */
+    std::string error() const;
+
+    /**
+     * @brief Hands the report to the caller and returns to Idle.
+     * Only call when status() is Succeeded.
+     */
+    BreachAudit::Report takeReport();
+
+    /**
+     * @brief Acknowledges a failure and returns to Idle.
+     */
+    void reset();
+
+private:
+    // Everything the worker writes. Shared so a cancelled worker can finish
+    // on its own after the UI has moved on.
+    struct State {
+        std::atomic<Status> status{ Status::Running };
+        std::atomic<size_t> done{ 0 };
+        std::atomic<size_t> total{ 0 };
+        std::atomic<bool> cancelled{ false };
+
+        // Written by the worker before it publishes Succeeded/Failed in
+        // `status`; read by the UI thread only after seeing that.
+        BreachAudit::Report report;
+        std::string error;
+    };
+
+    static void run(std::shared_ptr<State> state, std::string corpusPath, std::string bloomPath, EntryStore entries,
+                    std::function<void()> notify);
+    void reapFinished();
+
+    std::shared_ptr<State> m_state;
+    std::function<void()> m_notify;
+
+    // Workers that were cancelled but may still be finishing a chunk.
+    // Joined once they finish, or in the destructor.
+    std::vector<std::pair<std::thread, std::shared_ptr<State>>> m_workers;
+};
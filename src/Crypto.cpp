@@ -1,10 +1,61 @@
 #include "Crypto.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
 
 // This is the main header for libsodium
 #include <sodium.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <stdexcept> // For std::runtime_error
 #include <iostream>  // For error logging
+#include <istream>
+#include <ostream>
+
+static_assert(Crypto::SALT_BYTES == crypto_pwhash_SALTBYTES, "Crypto::SALT_BYTES out of sync with libsodium");
+static_assert(Crypto::KEY_BYTES == crypto_secretbox_KEYBYTES, "Crypto::KEY_BYTES out of sync with libsodium");
+static_assert(Crypto::KdfParams::ARGON2ID13 == crypto_pwhash_ALG_ARGON2ID13, "Crypto::KdfParams::ARGON2ID13 out of sync with libsodium");
+static_assert(Crypto::KdfParams().opsLimit == crypto_pwhash_OPSLIMIT_INTERACTIVE && Crypto::KdfParams().memLimit == crypto_pwhash_MEMLIMIT_INTERACTIVE, "Crypto::KdfParams defaults out of sync with libsodium");
+static_assert(Crypto::WRAPPED_KEY_BYTES == crypto_secretbox_NONCEBYTES + crypto_secretbox_KEYBYTES + crypto_secretbox_MACBYTES, "Crypto::WRAPPED_KEY_BYTES out of sync with libsodium");
+static_assert(Crypto::SEAL_OVERHEAD_BYTES == crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES, "Crypto::SEAL_OVERHEAD_BYTES out of sync with libsodium");
+
+namespace {
+    // Bounds for parameters read from a vault header
+    const uint64_t MAX_OPSLIMIT = 256;
+    const uint64_t MAX_MEMLIMIT = 4ull << 30;
+
+    // calibrateKdf doesn't go past this many passes, whatever the target
+    const uint64_t MAX_CALIBRATED_OPSLIMIT = 64;
+
+    // Recovery keys: RFC 4648 base32, no padding
+    const char BASE32[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+    const size_t RECOVERY_KEY_BYTES = 20;
+    const size_t RECOVERY_KEY_CHARS = RECOVERY_KEY_BYTES * 8 / 5;
+    const size_t RECOVERY_KEY_GROUP = 4;
+
+    // Chunked container layout (see Crypto.h)
+    const size_t CHUNK_NONCE_PREFIX_BYTES = crypto_secretbox_NONCEBYTES - 4 - 1;
+    const size_t CHUNK_HEADER_BYTES = CHUNK_NONCE_PREFIX_BYTES + 4 + 4;
+
+    void chunkNonce(unsigned char* nonce, const unsigned char* prefix, uint32_t index, bool last) {
+        std::memcpy(nonce, prefix, CHUNK_NONCE_PREFIX_BYTES);
+        for (int i = 0; i < 4; ++i) {
+            nonce[CHUNK_NONCE_PREFIX_BYTES + i] = (unsigned char)(index >> (8 * (3 - i)));
+        }
+        nonce[crypto_secretbox_NONCEBYTES - 1] = last ? 1 : 0;
+    }
+
+    uint32_t getU32(const unsigned char* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    void putU32(unsigned char* p, uint32_t v) {
+        for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
 
 bool Crypto::init() {
     // sodium_init() initializes the library and must be called once.
@@ -18,91 +69,619 @@ bool Crypto::init() {
 
 std::vector<unsigned char> Crypto::encrypt(const std::string& data, const std::string& password) {
     // 1. Generate a random Salt for password hashing (KDF)
-    // We use Argon2id, which is the default for crypto_pwhash
-    unsigned char salt[crypto_pwhash_SALTBYTES];
-    randombytes_buf(salt, sizeof(salt));
-
     // 2. Derive a 32-byte encryption key from the password and salt
-    unsigned char key[crypto_secretbox_KEYBYTES];
+    KeyHandle key = KeyHandle::derive(password, generateSalt());
+
+    // 3. Encrypt with it; the salt goes in front so decrypt can re-derive
+    return encrypt(data, key);
+}
+
+std::optional<SecureString> Crypto::decrypt(const std::vector<unsigned char>& encrypted_data, const std::string& password) {
+
+    // 1. Check if the data is even long enough to be valid
+    if (encrypted_data.size() < crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES) {
+        return std::nullopt; // Data is corrupt or invalid
+    }
+
+    // 2. Re-derive the *same* encryption key using the *same* salt and password
+    std::vector<unsigned char> salt(encrypted_data.begin(), encrypted_data.begin() + crypto_pwhash_SALTBYTES);
+    KeyHandle key;
+    try {
+        key = KeyHandle::derive(password, salt);
+    }
+    catch (const std::runtime_error&) {
+        return std::nullopt; // "Out of memory" is a failure
+    }
+
+    // 3. Decrypt the data
+    return decrypt(encrypted_data, key);
+}
+
+void Crypto::wipe(std::string& secret) {
+    // sodium_memzero can't be optimized away like a plain memset
+    if (!secret.empty()) {
+        sodium_memzero(&secret[0], secret.size());
+    }
+    secret.clear();
+}
+
+// --- Key derivation parameters ---
+
+bool Crypto::KdfParams::valid() const {
+    return algorithm == ARGON2ID13
+        && opsLimit >= crypto_pwhash_OPSLIMIT_MIN && opsLimit <= MAX_OPSLIMIT
+        && memLimit >= crypto_pwhash_MEMLIMIT_MIN && memLimit <= MAX_MEMLIMIT;
+}
+
+Crypto::KdfParams Crypto::calibrateKdf(double targetMs, uint64_t maxMemBytes) {
+    const KdfParams floor = KdfParams::interactive();
+    const std::vector<unsigned char> salt = generateSalt();
+
+    // Wall time of one derivation; a failed one (out of memory) counts as too slow
+    auto timeMs = [&](const KdfParams& params) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            KeyHandle::derive("calibration", salt, params);
+        }
+        catch (const std::runtime_error&) {
+            return HUGE_VAL;
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // 1. Memory first, since it's what makes Argon2id expensive to attack on
+    // GPUs: halve from the cap until the minimum number of passes fits
+    KdfParams params = floor;
+    params.memLimit = std::min(std::max(maxMemBytes, floor.memLimit), MAX_MEMLIMIT);
+    double ms = timeMs(params);
+    while (ms > targetMs && params.memLimit / 2 >= floor.memLimit) {
+        params.memLimit /= 2;
+        ms = timeMs(params);
+    }
+    if (ms >= targetMs) {
+        return params; // Already at (or past) the target with the fewest passes
+    }
+
+    // 2. Then as many passes as fit; time grows linearly with them
+    uint64_t ops = (uint64_t)((double)params.opsLimit * targetMs / std::max(ms, 0.001));
+    params.opsLimit = std::min(std::max(ops, floor.opsLimit), MAX_CALIBRATED_OPSLIMIT);
+
+    // 3. Check the extrapolation, and scale back if it overshot
+    ms = timeMs(params);
+    if (ms > targetMs * 1.1) {
+        ops = (uint64_t)((double)params.opsLimit * targetMs / ms);
+        params.opsLimit = std::max(ops, floor.opsLimit);
+    }
+    return params;
+}
+
+// --- KeyHandle ---
+
+Crypto::KeyHandle::~KeyHandle() {
+    wipe();
+}
+
+Crypto::KeyHandle::KeyHandle(KeyHandle&& other) noexcept
+    : m_key(other.m_key), m_salt(std::move(other.m_salt)), m_kdf(other.m_kdf) {
+    other.m_key = nullptr;
+}
+
+Crypto::KeyHandle& Crypto::KeyHandle::operator=(KeyHandle&& other) noexcept {
+    if (this != &other) {
+        wipe();
+        m_key = other.m_key;
+        m_salt = std::move(other.m_salt);
+        m_kdf = other.m_kdf;
+        other.m_key = nullptr;
+    }
+    return *this;
+}
+
+Crypto::KeyHandle Crypto::KeyHandle::derive(const std::string& password, const std::vector<unsigned char>& salt, const KdfParams& params) {
+    if (salt.size() != crypto_pwhash_SALTBYTES) {
+        throw std::runtime_error("Invalid salt length");
+    }
+    if (!params.valid()) {
+        throw std::runtime_error("Unsupported key derivation parameters");
+    }
+
+    // sodium_malloc puts the key between guard pages and locks it into RAM;
+    // sodium_free wipes it.
+    KeyHandle handle;
+    handle.m_key = (unsigned char*)sodium_malloc(crypto_secretbox_KEYBYTES);
+    if (handle.m_key == nullptr) {
+        throw std::runtime_error("Failed to allocate secure memory for key");
+    }
+    handle.m_salt = salt;
+    handle.m_kdf = params;
+
+    Diagnostics::ScopedTimer timer("crypto.pwhash");
+    // Argon2id, with the costs the vault was created with
     if (crypto_pwhash(
-            key, sizeof(key),
+            handle.m_key, crypto_secretbox_KEYBYTES,
             password.c_str(), password.length(),
-            salt,
-            crypto_pwhash_OPSLIMIT_INTERACTIVE, // Standard strength
-            crypto_pwhash_MEMLIMIT_INTERACTIVE,
-            crypto_pwhash_ALG_DEFAULT // Argon2id
+            salt.data(),
+            params.opsLimit,
+            (size_t)params.memLimit,
+            params.algorithm
         ) != 0) {
         throw std::runtime_error("Failed to derive encryption key (out of memory?)");
     }
 
-    // 3. Generate a random Nonce (Number used once) for encryption
-    unsigned char nonce[crypto_secretbox_NONCEBYTES];
-    randombytes_buf(nonce, sizeof(nonce));
+    // Nothing writes to the key after this; catch stray writes.
+    sodium_mprotect_readonly(handle.m_key);
+    return handle;
+}
 
-    // 4. Encrypt the data
-    // The ciphertext will be slightly longer than the original data
-    std::vector<unsigned char> ciphertext(data.length() + crypto_secretbox_MACBYTES);
-    
-    crypto_secretbox_easy(
-        ciphertext.data(),
-        (const unsigned char*)data.c_str(), data.length(),
-        nonce,
-        key
-    );
+bool Crypto::KeyHandle::valid() const {
+    return m_key != nullptr;
+}
+
+void Crypto::KeyHandle::wipe() {
+    if (m_key != nullptr) {
+        sodium_free(m_key); // Zeroes the memory before releasing it
+        m_key = nullptr;
+    }
+    m_salt.clear();
+}
+
+const std::vector<unsigned char>& Crypto::KeyHandle::salt() const {
+    return m_salt;
+}
+
+Crypto::KeyHandle Crypto::KeyHandle::generate() {
+    KeyHandle handle;
+    handle.m_key = (unsigned char*)sodium_malloc(crypto_secretbox_KEYBYTES);
+    if (handle.m_key == nullptr) {
+        throw std::runtime_error("Failed to allocate secure memory for key");
+    }
+    crypto_secretbox_keygen(handle.m_key);
+    sodium_mprotect_readonly(handle.m_key);
+    return handle;
+}
+
+Crypto::Keyslot Crypto::KeyHandle::wrap(Keyslot::Kind kind, const std::string& secret, const KdfParams& kdf) const {
+    if (!valid()) {
+        throw std::runtime_error("Wrapping a wiped key");
+    }
+    KeyHandle wrapping = derive(secret, generateSalt(), kdf);
+
+    Keyslot slot;
+    slot.kind = kind;
+    slot.kdf = kdf;
+    slot.salt = wrapping.salt();
+    slot.wrappedKey = seal(m_key, crypto_secretbox_KEYBYTES, wrapping);
+    return slot;
+}
+
+std::optional<Crypto::KeyHandle> Crypto::KeyHandle::unwrap(const Keyslot& slot, const std::string& secret) {
+    if (slot.kind == Keyslot::Kind::Empty || slot.wrappedKey.size() != WRAPPED_KEY_BYTES) {
+        return std::nullopt;
+    }
+    KeyHandle wrapping = derive(secret, slot.salt, slot.kdf);
+
+    KeyHandle handle;
+    handle.m_key = (unsigned char*)sodium_malloc(crypto_secretbox_KEYBYTES);
+    if (handle.m_key == nullptr) {
+        throw std::runtime_error("Failed to allocate secure memory for key");
+    }
+    if (!openTo(handle.m_key, slot.wrappedKey.data(), slot.wrappedKey.size(), wrapping)) {
+        return std::nullopt; // Wrong secret; the handle frees (and wipes) its memory
+    }
+    sodium_mprotect_readonly(handle.m_key);
+    return handle;
+}
+
+Crypto::KeyHandle Crypto::KeyHandle::subkey(uint64_t id, const char* context) const {
+    if (!valid()) {
+        throw std::runtime_error("Deriving from a wiped key");
+    }
+    static_assert(crypto_kdf_KEYBYTES == crypto_secretbox_KEYBYTES, "subkeys are data keys");
+    KeyHandle handle;
+    handle.m_key = (unsigned char*)sodium_malloc(crypto_secretbox_KEYBYTES);
+    if (handle.m_key == nullptr) {
+        throw std::runtime_error("Failed to allocate secure memory for key");
+    }
+    crypto_kdf_derive_from_key(handle.m_key, crypto_secretbox_KEYBYTES, id, context, m_key);
+    sodium_mprotect_readonly(handle.m_key);
+    return handle;
+}
+
+const Crypto::KdfParams& Crypto::KeyHandle::kdf() const {
+    return m_kdf;
+}
+
+const unsigned char* Crypto::KeyHandle::data() const {
+    return m_key;
+}
+
+// --- SecureBuffer ---
+
+Crypto::SecureBuffer::SecureBuffer(size_t size) {
+    if (size == 0) {
+        return;
+    }
+    // sodium_malloc (under the pool) tries to mlock the pages but doesn't fail
+    // if the OS's locked-memory limit is too small; the guard pages and wipe
+    // still apply.
+    try {
+        m_data = (unsigned char*)SecurePool::shared().allocate(size);
+    }
+    catch (const std::bad_alloc&) {
+        throw std::runtime_error("Failed to allocate secure memory");
+    }
+    m_size = size;
+}
+
+Crypto::SecureBuffer::~SecureBuffer() {
+    SecurePool::shared().deallocate(m_data, m_size); // Zeroes the memory before releasing it
+}
+
+Crypto::SecureBuffer::SecureBuffer(SecureBuffer&& other) noexcept
+    : m_data(other.m_data), m_size(other.m_size) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+Crypto::SecureBuffer& Crypto::SecureBuffer::operator=(SecureBuffer&& other) noexcept {
+    if (this != &other) {
+        SecurePool::shared().deallocate(m_data, m_size);
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+unsigned char* Crypto::SecureBuffer::data() {
+    return m_data;
+}
 
-    // 5. Package the data for storage: [SALT][NONCE][CIPHERTEXT]
+const unsigned char* Crypto::SecureBuffer::data() const {
+    return m_data;
+}
+
+size_t Crypto::SecureBuffer::size() const {
+    return m_size;
+}
+
+// --- Session key operations ---
+
+std::string Crypto::generateRecoveryKey() {
+    unsigned char bytes[RECOVERY_KEY_BYTES];
+    randombytes_buf(bytes, sizeof(bytes));
+
+    // 5 bits per character, most significant first
+    std::string chars;
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (unsigned char byte : bytes) {
+        buffer = (buffer << 8) | byte;
+        bits += 8;
+        while (bits >= 5) {
+            chars += BASE32[(buffer >> (bits - 5)) & 31];
+            bits -= 5;
+        }
+    }
+    sodium_memzero(bytes, sizeof(bytes));
+
+    std::string key = *normalizeRecoveryKey(chars); // Adds the dashes
+    wipe(chars);
+    return key;
+}
+
+std::optional<std::string> Crypto::normalizeRecoveryKey(const std::string& text) {
+    std::string chars;
+    for (char c : text) {
+        if (c == '-' || c == ' ') continue;
+        if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+        if (std::strchr(BASE32, c) == nullptr || c == '\0') {
+            wipe(chars);
+            return std::nullopt;
+        }
+        chars += c;
+    }
+    if (chars.size() != RECOVERY_KEY_CHARS) {
+        return std::nullopt;
+    }
+
+    std::string key;
+    for (size_t i = 0; i < chars.size(); ++i) {
+        if (i > 0 && i % RECOVERY_KEY_GROUP == 0) key += '-';
+        key += chars[i];
+    }
+    wipe(chars);
+    return key;
+}
+
+std::vector<unsigned char> Crypto::generateSalt() {
+    std::vector<unsigned char> salt(crypto_pwhash_SALTBYTES);
+    randombytes_buf(salt.data(), salt.size());
+    return salt;
+}
+
+std::vector<unsigned char> Crypto::encrypt(const std::string& data, const KeyHandle& key) {
+    if (!key.valid()) {
+        throw std::runtime_error("Encrypting with a wiped key");
+    }
+
+    // Package the data for storage: [SALT][NONCE][CIPHERTEXT]
     // The decrypt function needs all three parts to work.
+    std::vector<unsigned char> sealed = seal((const unsigned char*)data.data(), data.length(), key);
+
     std::vector<unsigned char> encrypted_blob;
-    encrypted_blob.insert(encrypted_blob.end(), salt, salt + sizeof(salt));
-    encrypted_blob.insert(encrypted_blob.end(), nonce, nonce + sizeof(nonce));
-    encrypted_blob.insert(encrypted_blob.end(), ciphertext.begin(), ciphertext.end());
+    encrypted_blob.reserve(key.salt().size() + sealed.size());
+    encrypted_blob.insert(encrypted_blob.end(), key.salt().begin(), key.salt().end());
+    encrypted_blob.insert(encrypted_blob.end(), sealed.begin(), sealed.end());
 
     return encrypted_blob;
 }
 
-std::optional<std::string> Crypto::decrypt(const std::vector<unsigned char>& encrypted_data, const std::string& password) {
-    
-    // 1. Check if the data is even long enough to be valid
-    if (encrypted_data.size() < crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES) {
+std::optional<SecureString> Crypto::decrypt(const std::vector<unsigned char>& encrypted_data, const KeyHandle& key) {
+    if (encrypted_data.size() < crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES) {
         return std::nullopt; // Data is corrupt or invalid
     }
 
-    // 2. Extract the components in the same order we saved them
-    const unsigned char* salt = encrypted_data.data();
-    const unsigned char* nonce = encrypted_data.data() + crypto_pwhash_SALTBYTES;
-    const unsigned char* ciphertext = encrypted_data.data() + crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES;
-    
-    size_t ciphertext_len = encrypted_data.size() - crypto_pwhash_SALTBYTES - crypto_secretbox_NONCEBYTES;
+    // The blob's salt must be the one the key was derived with
+    if (key.salt().size() != crypto_pwhash_SALTBYTES ||
+        std::memcmp(encrypted_data.data(), key.salt().data(), crypto_pwhash_SALTBYTES) != 0) {
+        return std::nullopt;
+    }
 
-    // 3. Re-derive the *same* encryption key using the *same* salt and password
-    unsigned char key[crypto_secretbox_KEYBYTES];
-    if (crypto_pwhash(
-            key, sizeof(key),
-            password.c_str(), password.length(),
-            salt, // We use the salt we extracted from the file
-            crypto_pwhash_OPSLIMIT_INTERACTIVE,
-            crypto_pwhash_MEMLIMIT_INTERACTIVE,
-            crypto_pwhash_ALG_DEFAULT
-        ) != 0) {
-        return std::nullopt; // "Out of memory" is a failure
+    // Decrypt straight into the string's (guarded) buffer
+    const unsigned char* sealed = encrypted_data.data() + crypto_pwhash_SALTBYTES;
+    size_t sealedSize = encrypted_data.size() - crypto_pwhash_SALTBYTES;
+    SecureString decrypted(sealedSize - SEAL_OVERHEAD_BYTES, '\0');
+    if (!openTo((unsigned char*)&decrypted[0], sealed, sealedSize, key)) {
+        // This is the normal failure case for a wrong password
+        return std::nullopt;
     }
+    return decrypted;
+}
 
-    // 4. Decrypt the data
-    std::vector<unsigned char> decrypted_data(ciphertext_len - crypto_secretbox_MACBYTES);
-    
-    // crypto_secretbox_open_easy is the magic part.
-    // It will *only* succeed if the key, nonce, and ciphertext are all correct.
-    // If the password was wrong, the key will be wrong, and this will fail.
-    if (crypto_secretbox_open_easy(
-            decrypted_data.data(),
-            ciphertext, ciphertext_len,
+std::vector<unsigned char> Crypto::seal(const unsigned char* data, size_t len, const KeyHandle& key) {
+    if (!key.valid()) {
+        throw std::runtime_error("Encrypting with a wiped key");
+    }
+    Diagnostics::ScopedTimer timer("crypto.seal", len);
+
+    // 1. Generate a random Nonce (Number used once) for encryption
+    std::vector<unsigned char> sealed(crypto_secretbox_NONCEBYTES + len + crypto_secretbox_MACBYTES);
+    unsigned char* nonce = sealed.data();
+    randombytes_buf(nonce, crypto_secretbox_NONCEBYTES);
+
+    // 2. Encrypt the data: [NONCE][CIPHERTEXT]
+    crypto_secretbox_easy(
+        sealed.data() + crypto_secretbox_NONCEBYTES,
+        data, len,
+        nonce,
+        key.data()
+    );
+    return sealed;
+}
+
+std::optional<SecureBytes> Crypto::open(const unsigned char* sealed, size_t len, const KeyHandle& key) {
+    if (len < SEAL_OVERHEAD_BYTES) {
+        return std::nullopt;
+    }
+    SecureBytes plaintext(len - SEAL_OVERHEAD_BYTES);
+    if (!openTo(plaintext.data(), sealed, len, key)) {
+        return std::nullopt;
+    }
+    return plaintext;
+}
+
+bool Crypto::openTo(unsigned char* out, const unsigned char* sealed, size_t len, const KeyHandle& key) {
+    if (!key.valid() || len < SEAL_OVERHEAD_BYTES) {
+        return false;
+    }
+    Diagnostics::ScopedTimer timer("crypto.open", len);
+
+    const unsigned char* nonce = sealed;
+    const unsigned char* ciphertext = sealed + crypto_secretbox_NONCEBYTES;
+    size_t ciphertext_len = len - crypto_secretbox_NONCEBYTES;
+
+    // crypto_secretbox_open_easy will *only* succeed if the key, nonce,
+    // and ciphertext are all correct.
+    return crypto_secretbox_open_easy(out, ciphertext, ciphertext_len, nonce, key.data()) == 0;
+}
+
+// --- Chunked encryption ---
+
+std::vector<unsigned char> Crypto::sealChunked(const unsigned char* data, size_t len, const KeyHandle& key, ThreadPool& pool) {
+    if (!key.valid()) {
+        throw std::runtime_error("Encrypting with a wiped key");
+    }
+
+    // Always at least one chunk, so an empty buffer still has a "last" chunk
+    size_t count = len == 0 ? 1 : (len + CHUNK_BYTES - 1) / CHUNK_BYTES;
+    if (count > UINT32_MAX) {
+        throw std::runtime_error("Buffer too large to encrypt");
+    }
+    Diagnostics::ScopedTimer timer("crypto.seal_chunked", len);
+
+    // 1. Header, with a fresh random nonce prefix
+    std::vector<unsigned char> sealed(CHUNK_HEADER_BYTES + len + count * crypto_secretbox_MACBYTES);
+    unsigned char* prefix = sealed.data();
+    randombytes_buf(prefix, CHUNK_NONCE_PREFIX_BYTES);
+    putU32(sealed.data() + CHUNK_NONCE_PREFIX_BYTES, (uint32_t)CHUNK_BYTES);
+    putU32(sealed.data() + CHUNK_NONCE_PREFIX_BYTES + 4, (uint32_t)count);
+
+    // 2. Every chunk has a fixed place in the output, so they can be sealed in any order
+    pool.parallelFor(count, [&](size_t i) {
+        size_t offset = i * CHUNK_BYTES;
+        size_t chunkLen = std::min(CHUNK_BYTES, len - offset);
+        unsigned char nonce[crypto_secretbox_NONCEBYTES];
+        chunkNonce(nonce, prefix, (uint32_t)i, i == count - 1);
+        crypto_secretbox_easy(
+            sealed.data() + CHUNK_HEADER_BYTES + offset + i * crypto_secretbox_MACBYTES,
+            data + offset, chunkLen,
             nonce,
-            key
-        ) != 0) {
-        // This is the normal failure case for a wrong password
+            key.data()
+        );
+    });
+    return sealed;
+}
+
+std::optional<SecureBytes> Crypto::openChunked(const unsigned char* sealed, size_t len, const KeyHandle& key, ThreadPool& pool) {
+    SecureBytes plaintext(len);
+    auto plainLen = openChunkedTo(plaintext.data(), plaintext.size(), sealed, len, key, pool);
+    if (!plainLen) {
         return std::nullopt;
     }
+    plaintext.resize(*plainLen);
+    return plaintext;
+}
+
+std::optional<size_t> Crypto::openChunkedTo(unsigned char* out, size_t capacity, const unsigned char* sealed, size_t len, const KeyHandle& key, ThreadPool& pool) {
+    if (!key.valid() || len < CHUNK_HEADER_BYTES) {
+        return std::nullopt;
+    }
+    Diagnostics::ScopedTimer timer("crypto.open_chunked", len);
+
+    // 1. The header must describe exactly the bytes that follow
+    const unsigned char* prefix = sealed;
+    size_t chunkBytes = getU32(sealed + CHUNK_NONCE_PREFIX_BYTES);
+    size_t count = getU32(sealed + CHUNK_NONCE_PREFIX_BYTES + 4);
+    size_t body = len - CHUNK_HEADER_BYTES;
+    if (chunkBytes == 0 || count == 0 || body < count * crypto_secretbox_MACBYTES) {
+        return std::nullopt;
+    }
+    size_t plainLen = body - count * crypto_secretbox_MACBYTES;
+    size_t expectedCount = plainLen == 0 ? 1 : (plainLen + chunkBytes - 1) / chunkBytes;
+    if (count != expectedCount || plainLen > capacity) {
+        return std::nullopt;
+    }
+
+    // 2. Open every chunk; any failure fails the whole buffer
+    std::atomic<bool> ok{ true };
+    pool.parallelFor(count, [&](size_t i) {
+        if (!ok) return;
+        size_t offset = i * chunkBytes;
+        size_t chunkLen = std::min(chunkBytes, plainLen - offset);
+        unsigned char nonce[crypto_secretbox_NONCEBYTES];
+        chunkNonce(nonce, prefix, (uint32_t)i, i == count - 1);
+        if (crypto_secretbox_open_easy(
+                out + offset,
+                sealed + CHUNK_HEADER_BYTES + offset + i * crypto_secretbox_MACBYTES, chunkLen + crypto_secretbox_MACBYTES,
+                nonce,
+                key.data()
+            ) != 0) {
+            ok = false;
+        }
+    });
+
+    if (!ok) {
+        sodium_memzero(out, plainLen);
+        return std::nullopt;
+    }
+    return plainLen;
+}
+
+// --- Streaming encryption ---
+
+bool Crypto::encryptStream(std::istream& in, std::ostream& out, const KeyHandle& key, const std::string& associated) {
+    if (!key.valid()) {
+        throw std::runtime_error("Encrypting with a wiped key");
+    }
+
+    Diagnostics::ScopedTimer timer("crypto.encrypt_stream");
+
+    // 1. Start the stream; its header carries the random nonce
+    crypto_secretstream_xchacha20poly1305_state state;
+    unsigned char header[crypto_secretstream_xchacha20poly1305_HEADERBYTES];
+    crypto_secretstream_xchacha20poly1305_init_push(&state, header, key.data());
+    out.write((const char*)header, sizeof(header));
+
+    // 2. Encrypt chunk by chunk. Peeking tells us whether a chunk is the last.
+    std::vector<unsigned char> plain(STREAM_CHUNK_BYTES);
+    std::vector<unsigned char> cipher(STREAM_CHUNK_BYTES + crypto_secretstream_xchacha20poly1305_ABYTES);
+    bool ok = true;
+    for (;;) {
+        in.read((char*)plain.data(), plain.size());
+        size_t got = (size_t)in.gcount();
+        if (in.bad()) {
+            ok = false;
+            break;
+        }
+        bool last = in.eof() || in.peek() == std::char_traits<char>::eof();
+        timer.addBytes(got);
+
+        unsigned long long cipherLen = 0;
+        crypto_secretstream_xchacha20poly1305_push(
+            &state, cipher.data(), &cipherLen,
+            plain.data(), got,
+            (const unsigned char*)associated.data(), associated.size(),
+            last ? crypto_secretstream_xchacha20poly1305_TAG_FINAL : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE
+        );
 
-    // 5. Convert the decrypted bytes back to a string
-    return std::string((char*)decrypted_data.data(), decrypted_data.size());
-}
\ No newline at end of file
+        unsigned char length[4];
+        putU32(length, (uint32_t)cipherLen);
+        out.write((const char*)length, sizeof(length));
+        out.write((const char*)cipher.data(), (std::streamsize)cipherLen);
+        if (!out) {
+            ok = false;
+            break;
+        }
+        if (last) break;
+    }
+
+    sodium_memzero(plain.data(), plain.size());
+    sodium_memzero(&state, sizeof(state));
+    return ok && (bool)out.flush();
+}
+
+bool Crypto::decryptStream(std::istream& in, std::ostream& out, const KeyHandle& key, const std::string& associated) {
+    if (!key.valid()) {
+        return false;
+    }
+
+    Diagnostics::ScopedTimer timer("crypto.decrypt_stream");
+
+    // 1. Read the header
+    unsigned char header[crypto_secretstream_xchacha20poly1305_HEADERBYTES];
+    if (!in.read((char*)header, sizeof(header))) {
+        return false;
+    }
+    crypto_secretstream_xchacha20poly1305_state state;
+    if (crypto_secretstream_xchacha20poly1305_init_pull(&state, header, key.data()) != 0) {
+        return false;
+    }
+
+    // 2. Decrypt chunk by chunk until the FINAL tag. Running out of input
+    // before it means the stream was truncated.
+    std::vector<unsigned char> cipher(STREAM_CHUNK_BYTES + crypto_secretstream_xchacha20poly1305_ABYTES);
+    std::vector<unsigned char> plain(STREAM_CHUNK_BYTES);
+    bool ok = false;
+    for (;;) {
+        unsigned char length[4];
+        if (!in.read((char*)length, sizeof(length))) break;
+        uint32_t cipherLen = getU32(length);
+        if (cipherLen < crypto_secretstream_xchacha20poly1305_ABYTES || cipherLen > cipher.size()) break;
+        if (!in.read((char*)cipher.data(), cipherLen)) break;
+
+        unsigned long long plainLen = 0;
+        unsigned char tag = 0;
+        if (crypto_secretstream_xchacha20poly1305_pull(
+                &state, plain.data(), &plainLen, &tag,
+                cipher.data(), cipherLen,
+                (const unsigned char*)associated.data(), associated.size()
+            ) != 0) {
+            break;
+        }
+        out.write((const char*)plain.data(), (std::streamsize)plainLen);
+        if (!out) break;
+        timer.addBytes(plainLen);
+
+        if (tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL) {
+            // Nothing may follow the final chunk
+            ok = in.peek() == std::char_traits<char>::eof();
+            break;
+        }
+    }
+
+    sodium_memzero(plain.data(), plain.size());
+    sodium_memzero(&state, sizeof(state));
+    return ok && (bool)out.flush();
+}
@@ -3,6 +3,13 @@
 #include <string>
 #include <vector>
 #include <optional> // For C++17, to handle decryption failure
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "SecurePool.h"
+
+class ThreadPool;
 
 // We'll use a namespace since we don't need to store any member variables.
 // These are all just utility functions.
@@ -27,10 +34,311 @@ namespace Crypto {
      * @brief Decrypts an encrypted byte vector using a password.
      * * @param encrypted_data The byte vector from the encrypt function.
      * @param password The user's password.
-     * @return A std::optional<std::string>. 
-     * If decryption is successful, it contains the plaintext.
+     * @return A std::optional<SecureString>.
+     * If decryption is successful, it contains the plaintext, in SecurePool memory.
      * If it fails (wrong password/corrupt data), it's empty (std::nullopt).
      */
-    std::optional<std::string> decrypt(const std::vector<unsigned char>& encrypted_data, const std::string& password);
+    std::optional<SecureString> decrypt(const std::vector<unsigned char>& encrypted_data, const std::string& password);
+
+    /**
+     * @brief Overwrites a string holding a secret (e.g. a password copy) with zeros and empties it.
+     */
+    void wipe(std::string& secret);
+
+    // --- Session Key API ---
+    // Derive the key once at unlock and reuse it for every later encrypt/decrypt,
+    // so saves only pay for the symmetric encryption, not Argon2id.
+
+    // Sizes mirror libsodium's constants so callers don't need <sodium.h>.
+    constexpr size_t SALT_BYTES = 16;  // crypto_pwhash_SALTBYTES
+    constexpr size_t KEY_BYTES = 32;   // crypto_secretbox_KEYBYTES
+
+    /**
+     * @brief Which password hash to run, and how hard. Stored in the vault
+     * header, so each vault is unlocked with the parameters it was created
+     * with, and they can be raised later without breaking old files.
+     */
+    struct KdfParams {
+        static constexpr uint8_t ARGON2ID13 = 2; // crypto_pwhash_ALG_ARGON2ID13
+
+        uint8_t algorithm = ARGON2ID13;
+        uint64_t opsLimit = 2;          // crypto_pwhash_OPSLIMIT_INTERACTIVE
+        uint64_t memLimit = 64ull << 20; // crypto_pwhash_MEMLIMIT_INTERACTIVE, bytes
+
+        /**
+         * @brief libsodium's "interactive" preset. What every vault used before
+         * parameters were stored, so it's assumed for files that don't record any.
+         */
+        static KdfParams interactive() { return KdfParams(); }
+
+        /**
+         * @brief True if these are parameters we'd derive with: a known
+         * algorithm and limits within sane bounds. A header asking for
+         * terabytes of memory is rejected rather than attempted.
+         */
+        bool valid() const;
+
+        bool operator==(const KdfParams& other) const {
+            return algorithm == other.algorithm && opsLimit == other.opsLimit && memLimit == other.memLimit;
+        }
+        bool operator!=(const KdfParams& other) const { return !(*this == other); }
+    };
+
+    // The unlock time calibrateKdf aims for by default
+    constexpr double DEFAULT_UNLOCK_MS = 500.0;
+
+    /**
+     * @brief Benchmarks key derivation on this machine and picks the strongest
+     * parameters that still derive in about `targetMs`: as much memory as
+     * allowed (up to `maxMemBytes`), then as many passes as fit. Never weaker
+     * than KdfParams::interactive(), even on machines too slow to meet the
+     * target with it. Takes a few times `targetMs` to run.
+     */
+    KdfParams calibrateKdf(double targetMs = DEFAULT_UNLOCK_MS, uint64_t maxMemBytes = 256ull << 20);
+
+    // --- Envelope encryption ---
+    // The vault is encrypted with a random data key. Each keyslot holds that
+    // key sealed ("wrapped") under a key derived from one secret (the master
+    // password, or a recovery key), so a secret can be added, changed or
+    // removed by rewriting its slot alone.
+
+    constexpr size_t WRAPPED_KEY_BYTES = 24 + 32 + 16; // [NONCE][KEY_BYTES of ciphertext][MAC]
+
+    struct Keyslot {
+        enum class Kind : uint8_t {
+            Empty = 0,
+            Password = 1,
+            Recovery = 2
+        };
+
+        Kind kind = Kind::Empty;
+        KdfParams kdf;
+        std::vector<unsigned char> salt;       // SALT_BYTES
+        std::vector<unsigned char> wrappedKey; // WRAPPED_KEY_BYTES
+    };
+
+    /**
+     * @brief Makes a recovery key: 160 random bits as 32 base32 characters in
+     * groups of four ("ABCD-EFGH-..."), to be written down by the user.
+     */
+    std::string generateRecoveryKey();
+
+    /**
+     * @brief If `text` is a recovery key (in any case, with or without the
+     * dashes and spaces), returns it in the form generateRecoveryKey() made it.
+     */
+    std::optional<std::string> normalizeRecoveryKey(const std::string& text);
+
+    /**
+     * @brief A key held in guarded libsodium memory (sodium_malloc: guard
+     * pages, locked into RAM, wiped when freed). Either derived from a password
+     * (then it knows the salt and parameters it was derived with) or a random
+     * data key. Read-only once made. Move-only.
+     */
+    class KeyHandle {
+    public:
+        KeyHandle() = default;
+        ~KeyHandle();
+        KeyHandle(KeyHandle&& other) noexcept;
+        KeyHandle& operator=(KeyHandle&& other) noexcept;
+        KeyHandle(const KeyHandle&) = delete;
+        KeyHandle& operator=(const KeyHandle&) = delete;
+
+        /**
+         * @brief Runs Argon2id over the password and salt. This is the slow part of unlocking.
+         * @param password The user's password.
+         * @param salt SALT_BYTES bytes of salt.
+         * @param params The cost parameters (from the vault header, or calibrateKdf for a new key).
+         * Throws std::runtime_error if the KDF fails (out of memory) or the parameters aren't valid().
+         */
+        static KeyHandle derive(const std::string& password, const std::vector<unsigned char>& salt, const KdfParams& params = KdfParams::interactive());
+
+        /**
+         * @brief A fresh random data key. Its salt() is empty.
+         */
+        static KeyHandle generate();
+
+        /**
+         * @brief Seals this key under one derived from `secret` (fresh salt, `kdf` costs).
+         * Throws std::runtime_error if the KDF fails.
+         */
+        Keyslot wrap(Keyslot::Kind kind, const std::string& secret, const KdfParams& kdf) const;
+
+        /**
+         * @brief Recovers the key a slot holds, deriving with the slot's salt and costs.
+         * @return std::nullopt if `secret` isn't the slot's (or the slot is malformed).
+         * Throws std::runtime_error if the KDF fails (out of memory).
+         */
+        static std::optional<KeyHandle> unwrap(const Keyslot& slot, const std::string& secret);
+
+        /**
+         * @brief Derives an independent key for another purpose from this one
+         * (crypto_kdf), so one data key can serve, say, a MAC as well as
+         * encryption without using the same bytes for both.
+         * @param context Exactly 8 characters naming the purpose.
+         */
+        KeyHandle subkey(uint64_t id, const char* context) const;
+
+        /**
+         * @brief True if the handle holds a key (it hasn't been wiped or moved from).
+         */
+        bool valid() const;
+
+        /**
+         * @brief Wipes and frees the key. Used when locking the vault.
+         */
+        void wipe();
+
+        const std::vector<unsigned char>& salt() const;
+
+        /**
+         * @brief The parameters the key was derived with; stored next to the salt.
+         */
+        const KdfParams& kdf() const;
+
+        /**
+         * @brief The raw key bytes, for passing to libsodium. Don't copy them out.
+         */
+        const unsigned char* data() const;
+
+    private:
+        unsigned char* m_key = nullptr; // KEY_BYTES from sodium_malloc
+        std::vector<unsigned char> m_salt;
+        KdfParams m_kdf;
+    };
+
+    /**
+     * @brief A fixed-size buffer for decrypted data, from SecurePool: guard
+     * pages, locked into RAM where the OS allows it, wiped when freed. Small
+     * buffers share a slab; large ones get their own sodium_malloc, like
+     * KeyHandle. Move-only; moving doesn't move the bytes, so pointers into
+     * it stay valid.
+     */
+    class SecureBuffer {
+    public:
+        SecureBuffer() = default;
+        /**
+         * Throws std::runtime_error if the memory can't be allocated.
+         */
+        explicit SecureBuffer(size_t size);
+        ~SecureBuffer();
+        SecureBuffer(SecureBuffer&& other) noexcept;
+        SecureBuffer& operator=(SecureBuffer&& other) noexcept;
+        SecureBuffer(const SecureBuffer&) = delete;
+        SecureBuffer& operator=(const SecureBuffer&) = delete;
+
+        unsigned char* data();
+        const unsigned char* data() const;
+        size_t size() const;
+
+    private:
+        unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    /**
+     * @brief Generates a fresh random salt for KeyHandle::derive.
+     */
+    std::vector<unsigned char> generateSalt();
+
+    /**
+     * @brief Encrypts with a session key instead of a password. No KDF.
+     * @return Same format as encrypt(): [SALT (the key's salt)][NONCE][CIPHERTEXT]
+     */
+    std::vector<unsigned char> encrypt(const std::string& data, const KeyHandle& key);
+
+    /**
+     * @brief Decrypts an encrypt() blob with a session key. No KDF.
+     * The key must have been derived with the blob's salt.
+     */
+    std::optional<SecureString> decrypt(const std::vector<unsigned char>& encrypted_data, const KeyHandle& key);
+
+    /**
+     * @brief Encrypts a buffer with a session key, without the salt prefix.
+     * Used by formats that store many small records (see VaultLog).
+     * @return [NONCE (24 bytes)][CIPHERTEXT]
+     */
+    std::vector<unsigned char> seal(const unsigned char* data, size_t len, const KeyHandle& key);
+
+    /**
+     * @brief Decrypts a buffer produced by seal.
+     * @return The plaintext (in SecurePool memory), or std::nullopt if authentication fails.
+     */
+    std::optional<SecureBytes> open(const unsigned char* sealed, size_t len, const KeyHandle& key);
+
+    // What seal() adds to the plaintext: the nonce and the MAC
+    constexpr size_t SEAL_OVERHEAD_BYTES = 24 + 16; // crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES
+
+    /**
+     * @brief Like open, but decrypts into the caller's buffer (e.g. a SecureBuffer)
+     * instead of allocating. `out` must hold len - SEAL_OVERHEAD_BYTES bytes.
+     * @return False if len is too short or authentication fails.
+     */
+    bool openTo(unsigned char* out, const unsigned char* sealed, size_t len, const KeyHandle& key);
+
+    // --- Chunked encryption ---
+    // For large buffers (vault snapshots). The plaintext is split into
+    // CHUNK_BYTES chunks that are sealed independently, so they can be
+    // encrypted and decrypted on all cores at once.
+    //
+    // Format: [NONCE PREFIX (19)][CHUNK SIZE (4, LE)][CHUNK COUNT (4, LE)]
+    //         then per chunk: [MAC (16)][CIPHERTEXT]
+    //
+    // Chunk i is sealed with nonce [NONCE PREFIX][i (4, BE)][LAST (1)], where
+    // LAST is 1 only for the final chunk (the STREAM construction). Swapping
+    // or duplicating chunks breaks their index, cutting chunks off the end
+    // leaves no chunk flagged last, and a tampered header misframes the
+    // chunks; all of them fail authentication.
+
+    constexpr size_t CHUNK_BYTES = 256 * 1024;
+
+    /**
+     * @brief Seals a buffer as parallel-decryptable chunks.
+     * @param pool Threads to spread the chunks over.
+     * @return The chunked container (format above).
+     */
+    std::vector<unsigned char> sealChunked(const unsigned char* data, size_t len, const KeyHandle& key, ThreadPool& pool);
+
+    /**
+     * @brief Opens a sealChunked() container, decrypting chunks in parallel.
+     * @return The plaintext, or std::nullopt if any chunk fails authentication
+     * or the container is malformed.
+     */
+    std::optional<SecureBytes> openChunked(const unsigned char* sealed, size_t len, const KeyHandle& key, ThreadPool& pool);
+
+    /**
+     * @brief Like openChunked, but decrypts into the caller's buffer.
+     * The plaintext is never longer than `len`.
+     * @return The plaintext length, or std::nullopt on failure or if it
+     * wouldn't fit in `capacity` bytes. On failure `out` is wiped.
+     */
+    std::optional<size_t> openChunkedTo(unsigned char* out, size_t capacity, const unsigned char* sealed, size_t len, const KeyHandle& key, ThreadPool& pool);
+
+    // --- Streaming encryption ---
+    // For data too big to hold in memory (attachments). crypto_secretstream
+    // encrypts one STREAM_CHUNK_BYTES chunk at a time; the chunks are chained,
+    // so they can't be reordered or dropped, and the last one is tagged FINAL,
+    // so a truncated stream fails to decrypt.
+    //
+    // Format: [HEADER (24)] then per chunk: [LENGTH (4, LE)][CIPHERTEXT (LENGTH)]
+
+    constexpr size_t STREAM_CHUNK_BYTES = 64 * 1024;
+
+    /**
+     * @brief Encrypts everything readable from `in` into `out`.
+     * Memory use is one chunk, whatever the input size.
+     * @param associated Authenticated with every chunk but not stored (e.g. an
+     * attachment's id), so one stream can't be passed off as another.
+     * @return True on success, false on a read or write error.
+     */
+    bool encryptStream(std::istream& in, std::ostream& out, const KeyHandle& key, const std::string& associated);
+
+    /**
+     * @brief Decrypts an encryptStream() stream from `in` into `out`, chunk by chunk.
+     * @return False if any chunk fails authentication, the stream is truncated
+     * or has trailing data, or on an I/O error. Whatever was already written
+     * to `out` must then be discarded.
+     */
+    bool decryptStream(std::istream& in, std::ostream& out, const KeyHandle& key, const std::string& associated);
 
 } // namespace Crypto
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "Diagnostics.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+std::atomic<bool> Diagnostics::detail::enabled{ false };
+
+namespace {
+    std::mutex g_mutex;
+    std::vector<Diagnostics::PhaseStats> g_stats;
+    std::unordered_map<std::string, size_t> g_index; // Phase name -> position in g_stats
+    std::ofstream g_log;
+
+    uint64_t unixMillis() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+void Diagnostics::setEnabled(bool enabled) {
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Diagnostics::record(const char* phase, double ms, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    // 1. Totals
+    auto it = g_index.find(phase);
+    if (it == g_index.end()) {
+        it = g_index.emplace(phase, g_stats.size()).first;
+        g_stats.push_back(PhaseStats{ phase });
+    }
+    PhaseStats& stats = g_stats[it->second];
+    stats.calls += 1;
+    stats.bytes += bytes;
+    stats.totalMs += ms;
+    stats.lastMs = ms;
+    if (ms > stats.maxMs) stats.maxMs = ms;
+
+    // 2. The log. Phase names are our own identifiers, so need no escaping.
+    if (g_log.is_open()) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "{\"time_ms\":%llu,\"phase\":\"%s\",\"ms\":%.3f,\"bytes\":%llu,\"thread\":%zu}\n",
+            (unsigned long long)unixMillis(), phase, ms, (unsigned long long)bytes,
+            std::hash<std::thread::id>()(std::this_thread::get_id()));
+        g_log << line;
+        g_log.flush(); // So the log survives a crash mid-unlock
+    }
+}
+
+std::vector<Diagnostics::PhaseStats> Diagnostics::stats() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_stats;
+}
+
+void Diagnostics::reset() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_stats.clear();
+    g_index.clear();
+}
+
+bool Diagnostics::openLog(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_log.close();
+    g_log.clear();
+    g_log.open(path, std::ios::app);
+    if (!g_log) {
+        return false;
+    }
+    setEnabled(true);
+    return true;
+}
+
+void Diagnostics::closeLog() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_log.close();
+}
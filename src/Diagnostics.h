@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lightweight timing of the vault's hot paths (unlock, save, crypto).
+ *
+ * Code wraps each phase in a ScopedTimer naming it ("load.derive_key",
+ * "crypto.open", ...). While recording is enabled, every timer adds its wall
+ * time and byte count to per-phase totals, which the diagnostics panel and
+ * `cppvault-cli --diagnostics` display, and writes one JSON line to the log
+ * file if one is open. Disabled (the default), a timer costs one relaxed
+ * atomic load and never reads the clock.
+ *
+ * Phases nest: "load.decrypt" includes the "crypto.open" calls it makes.
+ * Thread-safe; timers may run on worker threads.
+ */
+namespace Diagnostics {
+
+    struct PhaseStats {
+        std::string name;
+        uint64_t calls = 0;
+        uint64_t bytes = 0;   // Summed over all calls
+        double totalMs = 0.0;
+        double lastMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool enabled() {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Adds one timed call to a phase's totals (and the log). ScopedTimer
+     * calls this; it's only needed directly for timings measured elsewhere.
+     */
+    void record(const char* phase, double ms, uint64_t bytes);
+
+    /**
+     * @brief The totals so far, in the order the phases were first seen.
+     */
+    std::vector<PhaseStats> stats();
+
+    /**
+     * @brief Clears the totals. Recording and the log stay as they are.
+     */
+    void reset();
+
+    /**
+     * @brief Appends one JSON object per timed call to `path`
+     * ({"time_ms", "phase", "ms", "bytes", "thread"}) and enables recording.
+     * @return False if the file can't be opened.
+     */
+    bool openLog(const std::string& path);
+
+    void closeLog();
+
+    /**
+     * @brief Times a scope as one call of `phase`, which must be a string
+     * literal (or otherwise outlive the program's use of Diagnostics).
+     */
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char* phase, uint64_t bytes = 0)
+            : m_phase(enabled() ? phase : nullptr), m_bytes(bytes) {
+            if (m_phase != nullptr) m_start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer() { stop(); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        // For sizes only known once the work is done
+        void addBytes(uint64_t bytes) { m_bytes += bytes; }
+
+        /**
+         * @brief Ends the phase early. Later calls (and the destructor) do nothing.
+         */
+        void stop() {
+            if (m_phase == nullptr) return;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+            record(m_phase, ms, m_bytes);
+            m_phase = nullptr;
+        }
+
+    private:
+        const char* m_phase;
+        uint64_t m_bytes;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+} // namespace Diagnostics
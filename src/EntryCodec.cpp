@@ -0,0 +1,381 @@
+#include "EntryCodec.h"
+#include "EntryStore.h"
+
+#include <cstring>
+
+namespace {
+
+    // The smallest possible encoded entry: two one-byte varints and five empty fields
+    const size_t MIN_ENTRY_BYTES = 2 + 5;
+
+    void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((char)((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back((char)v);
+    }
+
+    size_t varintSize(uint64_t v) {
+        size_t size = 1;
+        while (v >= 0x80) {
+            v >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    void putField(std::string& out, std::string_view field) {
+        putVarint(out, field.size());
+        out.append(field);
+    }
+
+    size_t fieldSize(std::string_view field) {
+        return varintSize(field.size()) + field.size();
+    }
+
+    size_t attachmentsSize(const std::vector<Attachment>& attachments) {
+        size_t size = varintSize(attachments.size());
+        for (const auto& a : attachments) {
+            size += fieldSize(a.id) + fieldSize(a.name) + varintSize(a.size);
+        }
+        return size;
+    }
+
+    void putAttachments(std::string& out, const std::vector<Attachment>& attachments) {
+        putVarint(out, attachments.size());
+        for (const auto& a : attachments) {
+            putField(out, a.id);
+            putField(out, a.name);
+            putVarint(out, a.size);
+        }
+    }
+
+    // A PasswordEntry is written in the plain layout (format 2)...
+    size_t entrySize(const PasswordEntry& e) {
+        size_t size = varintSize(e.id) + varintSize(e.modified);
+        for (std::string_view field : { e.title, e.username, e.password, e.url, e.notes }) {
+            size += fieldSize(field);
+        }
+        return size + attachmentsSize(e.attachments);
+    }
+
+    void putEntry(std::string& out, const PasswordEntry& e) {
+        putVarint(out, e.id);
+        putVarint(out, e.modified);
+        putField(out, e.title);
+        putField(out, e.username);
+        putField(out, e.password);
+        putField(out, e.url);
+        putField(out, e.notes);
+        putAttachments(out, e.attachments);
+    }
+
+    // ...and a row of a store in the sealed one (format 3), its secrets
+    // copied as they are
+    size_t entrySize(EntryRef e) {
+        size_t size = varintSize(e.id()) + varintSize(e.modified());
+        for (std::string_view field : { e.title(), e.username(), e.url() }) {
+            size += fieldSize(field);
+        }
+        size += 1;
+        if (e.passwordSummary().hasPassword) size += e.passwordSummary().fingerprint.size();
+        return size + fieldSize(e.sealedSecrets()) + attachmentsSize(e.attachments());
+    }
+
+    void putEntry(std::string& out, EntryRef e) {
+        putVarint(out, e.id());
+        putVarint(out, e.modified());
+        putField(out, e.title());
+        putField(out, e.username());
+        putField(out, e.url());
+        const PasswordAnalyzer::Summary& summary = e.passwordSummary();
+        if (summary.hasPassword) {
+            out.push_back((char)(1 + (uint8_t)summary.strength));
+            out.append((const char*)summary.fingerprint.data(), summary.fingerprint.size());
+        } else {
+            out.push_back(0);
+        }
+        putField(out, e.sealedSecrets());
+        putAttachments(out, e.attachments());
+    }
+
+    template <typename Entries>
+    std::string encodeAll(const Entries& entries, uint8_t format) {
+        // Size it exactly first, so the snapshot is built in one allocation
+        size_t size = 1 + varintSize(entries.size());
+        for (const auto& entry : entries) {
+            size += entrySize(entry);
+        }
+
+        std::string out;
+        out.reserve(size);
+        out.push_back((char)format);
+        putVarint(out, entries.size());
+        for (const auto& entry : entries) {
+            putEntry(out, entry);
+        }
+        return out;
+    }
+
+    // Reads from a payload, failing (and staying failed) on any overrun
+    class Reader {
+    public:
+        explicit Reader(std::string_view payload)
+            : m_pos(payload.data()), m_end(payload.data() + payload.size()) {}
+
+        bool ok() const { return m_ok; }
+        bool atEnd() const { return m_pos == m_end; }
+        size_t remaining() const { return (size_t)(m_end - m_pos); }
+
+        uint8_t byte() {
+            if (!m_ok || m_pos == m_end) return fail();
+            return (uint8_t)*m_pos++;
+        }
+
+        uint64_t varint() {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (!m_ok || m_pos == m_end) return fail();
+                uint8_t b = (uint8_t)*m_pos++;
+                v |= (uint64_t)(b & 0x7F) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            return fail(); // More than 10 bytes
+        }
+
+        void field(std::string& out) {
+            out = field();
+        }
+
+        // A view into the payload; empty once failed
+        std::string_view field() {
+            uint64_t length = varint();
+            if (!m_ok || length > remaining()) {
+                fail();
+                return {};
+            }
+            std::string_view view(m_pos, (size_t)length);
+            m_pos += length;
+            return view;
+        }
+
+        void attachments(std::vector<Attachment>& out) {
+            // Each attachment takes at least three bytes
+            uint64_t count = varint();
+            if (!m_ok || count > remaining() / 3) {
+                fail();
+                return;
+            }
+            out.resize((size_t)count);
+            for (auto& a : out) {
+                field(a.id);
+                field(a.name);
+                a.size = varint();
+            }
+        }
+
+        // Only the plain layouts (formats 1 and 2); sealed secrets need a store's key
+        void entry(PasswordEntry& e, uint8_t format) {
+            if (format >= EntryCodec::FORMAT_V3) {
+                fail();
+                return;
+            }
+            e.id = varint();
+            e.modified = varint();
+            field(e.title);
+            field(e.username);
+            field(e.password);
+            field(e.url);
+            field(e.notes);
+            if (format >= EntryCodec::FORMAT_V2) attachments(e.attachments);
+        }
+
+        // Straight into the store's columns, without a PasswordEntry in
+        // between. Plain secrets are sealed on the way in; sealed ones are
+        // copied as they are.
+        void entry(EntryStore& store, uint8_t format) {
+            uint64_t id = varint();
+            uint64_t modified = varint();
+            std::string_view title = field();
+            std::string_view username = field();
+            std::vector<Attachment> list;
+            if (format < EntryCodec::FORMAT_V3) {
+                std::string_view password = field();
+                std::string_view url = field();
+                std::string_view notes = field();
+                if (format >= EntryCodec::FORMAT_V2) attachments(list);
+                if (m_ok) {
+                    store.append(id, modified, title, username, password, url, notes, std::move(list));
+                }
+                return;
+            }
+
+            std::string_view url = field();
+            PasswordAnalyzer::Summary summary;
+            uint8_t password = byte();
+            if (password > 1 + (uint8_t)PasswordAnalyzer::Strength::VeryStrong) {
+                fail();
+                return;
+            }
+            if (password != 0) {
+                summary.hasPassword = true;
+                summary.strength = (PasswordAnalyzer::Strength)(password - 1);
+                if (remaining() < summary.fingerprint.size()) {
+                    fail();
+                    return;
+                }
+                std::memcpy(summary.fingerprint.data(), m_pos, summary.fingerprint.size());
+                m_pos += summary.fingerprint.size();
+            }
+            std::string_view sealed = field();
+            attachments(list);
+            if (m_ok) {
+                store.appendSealed(id, modified, title, username, url, summary, sealed, std::move(list));
+            }
+        }
+
+    private:
+        uint8_t fail() {
+            m_ok = false;
+            return 0;
+        }
+
+        const char* m_pos;
+        const char* m_end;
+        bool m_ok = true;
+    };
+
+} // namespace
+
+bool EntryCodec::isBinary(std::string_view payload) {
+    // JSON starts with '[', '{', a digit or whitespace; never with a control byte
+    return !payload.empty() && (uint8_t)payload[0] >= FORMAT_V1 && (uint8_t)payload[0] <= FORMAT_CURRENT;
+}
+
+std::string EntryCodec::encodeEntry(const PasswordEntry& entry) {
+    std::string out;
+    out.reserve(1 + entrySize(entry));
+    out.push_back((char)FORMAT_V2);
+    putEntry(out, entry);
+    return out;
+}
+
+std::string EntryCodec::encodeEntry(EntryRef entry) {
+    std::string out;
+    out.reserve(1 + entrySize(entry));
+    out.push_back((char)FORMAT_CURRENT);
+    putEntry(out, entry);
+    return out;
+}
+
+std::string EntryCodec::encodeEntries(const std::vector<PasswordEntry>& entries) {
+    return encodeAll(entries, FORMAT_V2);
+}
+
+std::string EntryCodec::encodeEntries(const EntryStore& entries) {
+    return encodeAll(entries, FORMAT_CURRENT);
+}
+
+std::string EntryCodec::encodeId(uint64_t id) {
+    std::string out;
+    out.push_back((char)FORMAT_CURRENT);
+    putVarint(out, id);
+    return out;
+}
+
+std::optional<PasswordEntry> EntryCodec::decodeEntry(std::string_view payload) {
+    Reader reader(payload);
+    uint8_t format = reader.byte();
+    if (format < FORMAT_V1 || format > FORMAT_CURRENT) {
+        return std::nullopt;
+    }
+    PasswordEntry entry;
+    reader.entry(entry, format);
+    if (!reader.ok() || !reader.atEnd()) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+std::optional<std::vector<PasswordEntry>> EntryCodec::decodeEntries(std::string_view payload) {
+    Reader reader(payload);
+    uint8_t format = reader.byte();
+    if (format < FORMAT_V1 || format > FORMAT_CURRENT) {
+        return std::nullopt;
+    }
+
+    // A corrupt count mustn't make us reserve gigabytes
+    uint64_t count = reader.varint();
+    if (!reader.ok() || count > reader.remaining() / MIN_ENTRY_BYTES) {
+        return std::nullopt;
+    }
+
+    std::vector<PasswordEntry> entries((size_t)count);
+    for (auto& entry : entries) {
+        reader.entry(entry, format);
+        if (!reader.ok()) {
+            return std::nullopt;
+        }
+    }
+    if (!reader.atEnd()) {
+        return std::nullopt;
+    }
+    return entries;
+}
+
+bool EntryCodec::decodeEntries(std::string_view payload, EntryStore& store) {
+    Reader reader(payload);
+    uint8_t format = reader.byte();
+    if (format < FORMAT_V1 || format > FORMAT_CURRENT) {
+        return false;
+    }
+
+    uint64_t count = reader.varint();
+    if (!reader.ok() || count > reader.remaining() / MIN_ENTRY_BYTES) {
+        return false;
+    }
+
+    store.clear();
+    store.reserve((size_t)count);
+    for (uint64_t i = 0; i < count; ++i) {
+        reader.entry(store, format);
+        if (!reader.ok()) {
+            store.clear();
+            return false;
+        }
+    }
+    if (!reader.atEnd()) {
+        store.clear();
+        return false;
+    }
+    return true;
+}
+
+bool EntryCodec::decodeEntry(std::string_view payload, EntryStore& store) {
+    Reader reader(payload);
+    uint8_t format = reader.byte();
+    if (format < FORMAT_V1 || format > FORMAT_CURRENT) {
+        return false;
+    }
+    store.clear();
+    reader.entry(store, format);
+    if (!reader.ok() || !reader.atEnd()) {
+        store.clear();
+        return false;
+    }
+    return true;
+}
+
+std::optional<uint64_t> EntryCodec::decodeId(std::string_view payload) {
+    Reader reader(payload);
+    uint8_t format = reader.byte();
+    if (format < FORMAT_V1 || format > FORMAT_CURRENT) {
+        return std::nullopt;
+    }
+    uint64_t id = reader.varint();
+    if (!reader.ok() || !reader.atEnd()) {
+        return std::nullopt;
+    }
+    return id;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PasswordEntry;
+class EntryRef;
+class EntryStore;
+
+/**
+ * @brief The binary encoding of vault record payloads (see VaultLog).
+ *
+ * Every payload starts with a format byte, then:
+ *   Entry:    [ID (varint)][MODIFIED (varint)] then title, username and url
+ *             each as [LENGTH (varint)][BYTES], then
+ *             [PASSWORD (1)]: 0 for none, else 1 + its strength, followed by
+ *             its 16-byte fingerprint (see PasswordAnalyzer::Summary), then
+ *             the sealed password and notes (see EntryStore), length-prefixed,
+ *             then [ATTACHMENT COUNT (varint)] and per attachment its id and
+ *             name (length-prefixed) and [SIZE (varint)].
+ *             Formats 1 and 2 ("plain") have title, username, password, url
+ *             and notes in the clear, each length-prefixed; format 1 has no
+ *             attachments.
+ *   Entries:  [COUNT (varint)][ENTRY]...
+ *   Id:       [ID (varint)]
+ * Varints are unsigned LEB128: 7 bits per byte, low bits first.
+ *
+ * Entries are written straight into the output string; there's no
+ * intermediate DOM as with nlohmann::json.
+ *
+ * Vaults written before this stored JSON payloads. JSON text never starts
+ * with a format byte, so isBinary() tells the two apart.
+ */
+namespace EntryCodec {
+
+    // Bump when the layout changes; decoders reject versions they don't know.
+    const uint8_t FORMAT_V1 = 1;
+    const uint8_t FORMAT_V2 = 2; // Adds attachments
+    const uint8_t FORMAT_V3 = 3; // Seals the password and notes per entry
+    const uint8_t FORMAT_CURRENT = FORMAT_V3;
+
+    /**
+     * @brief True if the payload is in this binary format (as opposed to legacy JSON).
+     */
+    bool isBinary(std::string_view payload);
+
+    /**
+     * @brief A store's rows are written in the current format, their sealed
+     * secrets copied as they are; a PasswordEntry, which has no key to seal
+     * with, in plain format 2.
+     */
+    std::string encodeEntry(const PasswordEntry& entry);
+    std::string encodeEntry(EntryRef entry);
+    std::string encodeEntries(const std::vector<PasswordEntry>& entries);
+    std::string encodeEntries(const EntryStore& entries);
+    std::string encodeId(uint64_t id);
+
+    /**
+     * @brief Decoders return std::nullopt on truncated, oversized or trailing
+     * data, or on an unknown format version. They read the payload in place
+     * (e.g. straight out of VaultLog's decrypted arena) without copying it.
+     * The PasswordEntry ones only read the plain formats.
+     */
+    std::optional<PasswordEntry> decodeEntry(std::string_view payload);
+    std::optional<std::vector<PasswordEntry>> decodeEntries(std::string_view payload);
+
+    /**
+     * @brief Decodes an Entries payload straight into a store's columns,
+     * replacing its contents, with no PasswordEntry in between. Sealed
+     * secrets are taken as they are, so the store must have the key they
+     * were sealed under (EntryStore::setKey); plain ones are sealed with it.
+     * @return False (leaving the store empty) on the same errors as above.
+     */
+    bool decodeEntries(std::string_view payload, EntryStore& store);
+
+    /**
+     * @brief Decodes an Entry payload into a store the same way, leaving it
+     * with that one row.
+     */
+    bool decodeEntry(std::string_view payload, EntryStore& store);
+    std::optional<uint64_t> decodeId(std::string_view payload);
+
+} // namespace EntryCodec
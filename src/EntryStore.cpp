@@ -0,0 +1,661 @@
+#include "EntryStore.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "SecurePool.h"
+
+namespace {
+    // Each tree node holds up to 2^BRANCH_BITS children
+    const uint32_t BRANCH_BITS = 5;
+    const size_t BRANCH_MASK = ((size_t)1 << BRANCH_BITS) - 1;
+
+    // Intern pool strings are packed into blocks of this size
+    const size_t POOL_CHUNK_BYTES = SecurePool::MAX_BLOCK_BYTES;
+    const size_t MIN_POOL_SLOTS = 64;
+
+    // Fingerprints are keyed with a subkey of the data key, not the key itself
+    const uint64_t FINGERPRINT_SUBKEY_ID = 1;
+    const char FINGERPRINT_CONTEXT[] = "cvfprint";
+
+    std::string_view bytesView(const std::vector<unsigned char>& bytes) {
+        return std::string_view((const char*)bytes.data(), bytes.size());
+    }
+
+    // Copies a node held elsewhere too, so it can be changed
+    template <typename T>
+    T& unshare(std::shared_ptr<T>& node) {
+        if (node.use_count() > 1) {
+            node = std::make_shared<T>(*node);
+        }
+        return *node;
+    }
+}
+
+// --- InternPool ---
+
+/**
+ * @brief Usernames and urls, each value stored once for a store and all
+ * its copies. Append-only: a string never moves or changes once added, so
+ * pages point straight at it and copies read it from any thread without
+ * locking; only adding a value takes the lock. Values no row uses anymore
+ * stay until the store is rebuilt (setKey, retain) or cleared.
+ */
+class InternPool {
+public:
+    InternPool() = default;
+    InternPool(const InternPool&) = delete;
+    InternPool& operator=(const InternPool&) = delete;
+    ~InternPool() {
+        for (const Chunk& chunk : m_chunks) {
+            SecurePool::shared().deallocate(chunk.data, chunk.capacity); // Wipes it
+        }
+    }
+
+    // Each value is [LENGTH (4)][TEXT][NUL]; rows hold a pointer to the text
+    static std::string_view view(const char* text) {
+        if (!text) {
+            return std::string_view("", 0);
+        }
+        uint32_t length;
+        std::memcpy(&length, text - 4, 4);
+        return std::string_view(text, length);
+    }
+
+    // nullptr for ""
+    const char* intern(std::string_view text) {
+        if (text.empty()) {
+            return nullptr;
+        }
+        if (text.size() > UINT32_MAX) {
+            throw std::length_error("EntryStore string over 4 GiB");
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_table.size() < std::max(MIN_POOL_SLOTS, (m_count + 1) * 2)) {
+            rehash(std::max(MIN_POOL_SLOTS, m_table.size() * 2));
+        }
+        size_t slot = slotOf(text, std::hash<std::string_view>()(text));
+        if (!m_table[slot]) {
+            m_table[slot] = add(text);
+            ++m_count;
+        }
+        return m_table[slot];
+    }
+
+    size_t memoryBytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t bytes = sizeof(InternPool) + m_chunks.capacity() * sizeof(Chunk) + m_table.capacity() * sizeof(const char*);
+        for (const Chunk& chunk : m_chunks) bytes += chunk.capacity;
+        return bytes;
+    }
+
+private:
+    struct Chunk {
+        char* data;
+        size_t size;
+        size_t capacity;
+    };
+
+    const char* add(std::string_view text) {
+        size_t needed = 4 + text.size() + 1;
+        if (m_chunks.empty() || m_chunks.back().size + needed > m_chunks.back().capacity) {
+            // A value too big for a chunk gets its own, kept behind the one being filled
+            size_t capacity = std::max(needed, POOL_CHUNK_BYTES);
+            m_chunks.push_back(Chunk{ (char*)SecurePool::shared().allocate(capacity), 0, capacity });
+            if (capacity > POOL_CHUNK_BYTES && m_chunks.size() > 1) {
+                std::swap(m_chunks.back(), m_chunks[m_chunks.size() - 2]);
+                Chunk& own = m_chunks[m_chunks.size() - 2];
+                own.size = needed;
+                return write(own.data, text);
+            }
+        }
+        Chunk& chunk = m_chunks.back();
+        const char* written = write(chunk.data + chunk.size, text);
+        chunk.size += needed;
+        return written;
+    }
+
+    static const char* write(char* at, std::string_view text) {
+        uint32_t length = (uint32_t)text.size();
+        std::memcpy(at, &length, 4);
+        std::memcpy(at + 4, text.data(), text.size());
+        at[4 + text.size()] = '\0';
+        return at + 4;
+    }
+
+    // Linear probing; the table is never more than half full
+    size_t slotOf(std::string_view text, size_t hash) const {
+        size_t mask = m_table.size() - 1;
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            if (!m_table[slot] || view(m_table[slot]) == text) {
+                return slot;
+            }
+        }
+    }
+
+    void rehash(size_t slots) {
+        std::vector<const char*> old(slots, nullptr);
+        old.swap(m_table);
+        for (const char* text : old) {
+            if (text) m_table[slotOf(view(text), std::hash<std::string_view>()(view(text)))] = text;
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::vector<Chunk> m_chunks;
+    std::vector<const char*> m_table;
+    size_t m_count = 0;
+};
+
+// --- EntryPage ---
+
+/**
+ * @brief Up to PAGE_ROWS rows, column by column, with titles and sealed
+ * secrets in two arenas of its own and usernames and urls in the store's
+ * intern pool. Rows are only ever appended; any other change builds a new page.
+ */
+class EntryPage {
+public:
+    struct Span {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    // Strings back to back, each followed by a NUL, in SecurePool memory
+    class Arena {
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena() { SecurePool::shared().deallocate(m_data, m_capacity); } // Wipes it
+
+        Span append(std::string_view text) {
+            if (text.empty()) {
+                return Span{}; // view() gives "" for these; nothing stored
+            }
+            size_t needed = m_size + text.size() + 1;
+            if (needed > m_capacity) {
+                reallocate(std::max(needed, m_capacity + m_capacity / 2));
+            }
+            Span span{ (uint32_t)m_size, (uint32_t)text.size() };
+            std::memcpy(m_data + m_size, text.data(), text.size());
+            m_data[m_size + text.size()] = '\0';
+            m_size = needed;
+            return span;
+        }
+
+        std::string_view view(Span span) const {
+            return span.length == 0 ? std::string_view("", 0) : std::string_view(m_data + span.offset, span.length);
+        }
+
+        void reallocate(size_t capacity) {
+            // Spans are 32-bit offsets
+            if (capacity > UINT32_MAX) {
+                throw std::length_error("EntryStore arena over 4 GiB");
+            }
+            char* data = capacity > 0 ? (char*)SecurePool::shared().allocate(capacity) : nullptr;
+            if (m_size > 0) std::memcpy(data, m_data, m_size);
+            // Copy first, then free (and wipe) the old block
+            SecurePool::shared().deallocate(m_data, m_capacity);
+            m_data = data;
+            m_capacity = capacity;
+        }
+
+        void shrinkToFit() {
+            if (m_size < m_capacity) reallocate(m_size);
+        }
+
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        char* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_capacity = 0;
+    };
+
+    template <typename T>
+    using Column = std::array<T, EntryStore::PAGE_ROWS>;
+
+    EntryPage(std::shared_ptr<const Crypto::KeyHandle> key, std::shared_ptr<InternPool> pool, size_t textBytes)
+        : key(std::move(key)), pool(std::move(pool)) {
+        if (textBytes > 0) text.reallocate(textBytes);
+    }
+
+    void append(uint64_t id, uint64_t modifiedAt, std::string_view title, std::string_view username, std::string_view url,
+                const PasswordAnalyzer::Summary& summary, std::string_view sealedSecrets, std::vector<Attachment> rowAttachments) {
+        append(id, modifiedAt, title, pool->intern(username), pool->intern(url), summary, sealedSecrets, std::move(rowAttachments));
+    }
+
+    void append(uint64_t id, uint64_t modifiedAt, std::string_view title, const char* username, const char* url,
+                const PasswordAnalyzer::Summary& summary, std::string_view sealedSecrets, std::vector<Attachment> rowAttachments) {
+        ids[count] = id;
+        modified[count] = modifiedAt;
+        titles[count] = text.append(title);
+        usernames[count] = username;
+        urls[count] = url;
+        secrets[count] = sealed.append(sealedSecrets);
+        summaries[count] = summary;
+        attachments[count] = std::move(rowAttachments);
+        if (++count == EntryStore::PAGE_ROWS) {
+            // Full: nothing more will be appended, so drop the growth slack
+            text.shrinkToFit();
+            sealed.shrinkToFit();
+        }
+    }
+
+    void copyRow(const EntryPage& from, uint32_t row) {
+        if (from.pool == pool) {
+            // Already interned here
+            append(from.ids[row], from.modified[row], from.text.view(from.titles[row]), from.usernames[row], from.urls[row],
+                   from.summaries[row], from.sealed.view(from.secrets[row]), from.attachments[row]);
+        } else {
+            append(from.ids[row], from.modified[row], from.text.view(from.titles[row]), InternPool::view(from.usernames[row]),
+                   InternPool::view(from.urls[row]), from.summaries[row], from.sealed.view(from.secrets[row]), from.attachments[row]);
+        }
+    }
+
+    std::optional<EntrySecrets> open(uint32_t row) const {
+        EntrySecrets opened;
+        std::string_view blob = sealed.view(secrets[row]);
+        if (blob.empty()) {
+            return opened;
+        }
+        if (!key) {
+            return std::nullopt;
+        }
+        std::optional<SecureBytes> plaintext = Crypto::open((const unsigned char*)blob.data(), blob.size(), *key);
+        if (!plaintext || plaintext->size() < 4) {
+            return std::nullopt;
+        }
+        uint32_t length = 0;
+        for (int i = 0; i < 4; ++i) {
+            length |= (uint32_t)(*plaintext)[i] << (8 * i);
+        }
+        if (length > plaintext->size() - 4) {
+            return std::nullopt;
+        }
+        const char* bytes = (const char*)plaintext->data() + 4;
+        opened.password.assign(bytes, length);
+        opened.notes.assign(bytes + length, plaintext->size() - 4 - length);
+        return opened;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = sizeof(EntryPage) + text.capacity() + sealed.capacity();
+        for (uint32_t row = 0; row < count; ++row) {
+            bytes += attachments[row].capacity() * sizeof(Attachment);
+        }
+        return bytes;
+    }
+
+    std::shared_ptr<const Crypto::KeyHandle> key; // What the secrets are sealed under
+    std::shared_ptr<InternPool> pool;             // What usernames and urls point into
+    uint32_t count = 0;
+    Column<uint64_t> ids;
+    Column<uint64_t> modified;
+    Column<Span> titles;             // Into `text`
+    Column<const char*> usernames;   // Into `pool`; nullptr for ""
+    Column<const char*> urls;        // Likewise
+    Column<Span> secrets;            // Into `sealed`
+    Column<PasswordAnalyzer::Summary> summaries;
+    Column<std::vector<Attachment>> attachments;
+    Arena text;
+    Arena sealed;
+};
+
+struct EntryStore::Node {
+    std::vector<std::shared_ptr<Node>> children;   // Above the lowest level
+    std::vector<std::shared_ptr<EntryPage>> pages; // At the lowest level
+};
+
+// --- EntryRef ---
+
+uint64_t EntryRef::id() const { return m_page->ids[m_row]; }
+uint64_t EntryRef::modified() const { return m_page->modified[m_row]; }
+std::string_view EntryRef::title() const { return m_page->text.view(m_page->titles[m_row]); }
+std::string_view EntryRef::username() const { return InternPool::view(m_page->usernames[m_row]); }
+std::string_view EntryRef::url() const { return InternPool::view(m_page->urls[m_row]); }
+const std::vector<Attachment>& EntryRef::attachments() const { return m_page->attachments[m_row]; }
+const PasswordAnalyzer::Summary& EntryRef::passwordSummary() const { return m_page->summaries[m_row]; }
+std::string_view EntryRef::sealedSecrets() const { return m_page->sealed.view(m_page->secrets[m_row]); }
+std::optional<EntrySecrets> EntryRef::secrets() const { return m_page->open(m_row); }
+
+PasswordEntry EntryRef::toEntry() const {
+    PasswordEntry entry;
+    entry.id = id();
+    entry.title = title();
+    entry.username = username();
+    entry.url = url();
+    if (auto opened = secrets()) {
+        entry.password.assign(opened->password.data(), opened->password.size());
+        entry.notes.assign(opened->notes.data(), opened->notes.size());
+    }
+    entry.modified = modified();
+    entry.attachments = attachments();
+    return entry;
+}
+
+// --- The tree ---
+// Page i is found by taking BRANCH_BITS of i at a time, top level first.
+// Nodes and pages held by a copy of the store are copied before they're
+// changed (path copying), so the copy never sees the change.
+
+EntryStore::EntryStore(EntryStore&& other) noexcept {
+    *this = std::move(other);
+}
+
+EntryStore& EntryStore::operator=(EntryStore&& other) noexcept {
+    if (this != &other) {
+        m_root = std::move(other.m_root);
+        m_depth = std::exchange(other.m_depth, 0);
+        m_size = std::exchange(other.m_size, 0);
+        m_textPerRow = other.m_textPerRow;
+        m_pool = std::move(other.m_pool);
+        m_key = std::move(other.m_key);
+        m_fingerprintKey = std::move(other.m_fingerprintKey);
+    }
+    return *this;
+}
+
+const EntryPage& EntryStore::page(size_t index) const {
+    const Node* node = m_root.get();
+    for (uint32_t level = m_depth; level > 1; --level) {
+        node = node->children[(index >> (BRANCH_BITS * (level - 1))) & BRANCH_MASK].get();
+    }
+    return *node->pages[index & BRANCH_MASK];
+}
+
+void EntryStore::setPage(size_t index, std::shared_ptr<EntryPage> page) {
+    Node* node = &unshare(m_root);
+    for (uint32_t level = m_depth; level > 1; --level) {
+        node = &unshare(node->children[(index >> (BRANCH_BITS * (level - 1))) & BRANCH_MASK]);
+    }
+    node->pages[index & BRANCH_MASK] = std::move(page);
+}
+
+EntryPage& EntryStore::mutablePage(size_t index) {
+    Node* node = &unshare(m_root);
+    for (uint32_t level = m_depth; level > 1; --level) {
+        node = &unshare(node->children[(index >> (BRANCH_BITS * (level - 1))) & BRANCH_MASK]);
+    }
+    std::shared_ptr<EntryPage>& slot = node->pages[index & BRANCH_MASK];
+    if (slot.use_count() > 1) {
+        std::shared_ptr<EntryPage> copy = newPage();
+        for (uint32_t row = 0; row < slot->count; ++row) {
+            copy->copyRow(*slot, row);
+        }
+        slot = std::move(copy);
+    }
+    return *slot;
+}
+
+EntryPage& EntryStore::lastPageForAppend() {
+    if (m_size % PAGE_ROWS == 0) {
+        pushPage(newPage());
+    }
+    return mutablePage(m_size / PAGE_ROWS);
+}
+
+void EntryStore::pushPage(std::shared_ptr<EntryPage> page) {
+    size_t index = pageCount();
+
+    // 1. Add a level on top when the tree is full
+    if (!m_root) {
+        m_root = std::make_shared<Node>();
+        m_depth = 1;
+    } else if (index == (size_t)1 << (BRANCH_BITS * m_depth)) {
+        auto root = std::make_shared<Node>();
+        root->children.push_back(std::move(m_root));
+        m_root = std::move(root);
+        ++m_depth;
+    }
+
+    // 2. Walk down to the page's place, adding nodes on the way
+    Node* node = &unshare(m_root);
+    for (uint32_t level = m_depth; level > 1; --level) {
+        size_t child = (index >> (BRANCH_BITS * (level - 1))) & BRANCH_MASK;
+        if (child == node->children.size()) {
+            node->children.push_back(std::make_shared<Node>());
+        }
+        node = &unshare(node->children[child]);
+    }
+    node->pages.push_back(std::move(page));
+}
+
+void EntryStore::popPage() {
+    size_t index = pageCount() - 1;
+    if (index == 0) {
+        m_root.reset();
+        m_depth = 0;
+        return;
+    }
+
+    // 1. Take the page off its node
+    std::vector<Node*> path{ &unshare(m_root) };
+    for (uint32_t level = m_depth; level > 1; --level) {
+        path.push_back(&unshare(path.back()->children[(index >> (BRANCH_BITS * (level - 1))) & BRANCH_MASK]));
+    }
+    path.back()->pages.pop_back();
+
+    // 2. Drop the nodes that left empty, then the levels no longer needed
+    for (size_t i = path.size() - 1; i > 0 && path[i]->pages.empty() && path[i]->children.empty(); --i) {
+        path[i - 1]->children.pop_back();
+    }
+    while (m_depth > 1 && m_root->children.size() == 1) {
+        std::shared_ptr<Node> child = m_root->children.front();
+        m_root = std::move(child);
+        --m_depth;
+    }
+}
+
+std::shared_ptr<EntryPage> EntryStore::newPage() {
+    if (!m_pool) {
+        m_pool = std::make_shared<InternPool>();
+    }
+    return std::make_shared<EntryPage>(m_key, m_pool, m_textPerRow * PAGE_ROWS);
+}
+
+// --- Secrets ---
+
+void EntryStore::ensureKey() {
+    if (!m_key) {
+        setKey(std::make_shared<const Crypto::KeyHandle>(Crypto::KeyHandle::generate()));
+    }
+}
+
+void EntryStore::setKey(std::shared_ptr<const Crypto::KeyHandle> key) {
+    if (key == m_key) {
+        return;
+    }
+    auto fingerprintKey = std::make_shared<const Crypto::KeyHandle>(key->subkey(FINGERPRINT_SUBKEY_ID, FINGERPRINT_CONTEXT));
+
+    // Reseal every entry into new pages: open under the old key, seal under the new one
+    EntryStore resealed;
+    resealed.m_key = key;
+    resealed.m_fingerprintKey = fingerprintKey;
+    resealed.m_textPerRow = m_textPerRow;
+    for (EntryRef entry : *this) {
+        if (entry.sealedSecrets().empty()) {
+            resealed.appendSealed(entry.id(), entry.modified(), entry.title(), entry.username(), entry.url(), entry.passwordSummary(),
+                                  std::string_view(), entry.attachments());
+            continue;
+        }
+        std::optional<EntrySecrets> secrets = entry.secrets();
+        if (!secrets) {
+            throw std::runtime_error("EntryStore: an entry's secrets don't open");
+        }
+        resealed.appendSealed(entry.id(), entry.modified(), entry.title(), entry.username(), entry.url(),
+                              PasswordAnalyzer::summarize(secrets->password, *fingerprintKey),
+                              bytesView(seal(secrets->password, secrets->notes, *key)), entry.attachments());
+    }
+    *this = std::move(resealed);
+}
+
+std::vector<unsigned char> EntryStore::seal(std::string_view password, std::string_view notes, const Crypto::KeyHandle& key) {
+    if (password.empty() && notes.empty()) {
+        return {};
+    }
+    if (password.size() > UINT32_MAX) {
+        throw std::length_error("EntryStore password over 4 GiB");
+    }
+    SecureBytes plaintext(4 + password.size() + notes.size());
+    uint32_t length = (uint32_t)password.size();
+    for (int i = 0; i < 4; ++i) {
+        plaintext[i] = (unsigned char)(length >> (8 * i));
+    }
+    std::memcpy(plaintext.data() + 4, password.data(), password.size());
+    std::memcpy(plaintext.data() + 4 + password.size(), notes.data(), notes.size());
+    return Crypto::seal(plaintext.data(), plaintext.size(), key);
+}
+
+// --- Rows ---
+
+void EntryStore::reserve(size_t rows, size_t textBytes) {
+    m_textPerRow = rows > 0 ? textBytes / rows : 0;
+}
+
+size_t EntryStore::append(const PasswordEntry& entry) {
+    return append(entry.id, entry.modified, entry.title, entry.username, entry.password, entry.url, entry.notes, entry.attachments);
+}
+
+size_t EntryStore::append(EntryRef entry) {
+    if (m_key && entry.m_page->key == m_key) {
+        return appendSealed(entry.id(), entry.modified(), entry.title(), entry.username(), entry.url(), entry.passwordSummary(),
+                            entry.sealedSecrets(), entry.attachments());
+    }
+    std::optional<EntrySecrets> secrets = entry.secrets();
+    if (!secrets) {
+        throw std::runtime_error("EntryStore: an entry's secrets don't open");
+    }
+    return append(entry.id(), entry.modified(), entry.title(), entry.username(), secrets->password, entry.url(), secrets->notes,
+                  entry.attachments());
+}
+
+size_t EntryStore::append(uint64_t id, uint64_t modified, std::string_view title, std::string_view username, std::string_view password,
+                          std::string_view url, std::string_view notes, std::vector<Attachment> attachments) {
+    ensureKey();
+    return appendSealed(id, modified, title, username, url, PasswordAnalyzer::summarize(password, *m_fingerprintKey),
+                        bytesView(seal(password, notes, *m_key)), std::move(attachments));
+}
+
+size_t EntryStore::appendSealed(uint64_t id, uint64_t modified, std::string_view title, std::string_view username, std::string_view url,
+                                const PasswordAnalyzer::Summary& summary, std::string_view sealed, std::vector<Attachment> attachments) {
+    lastPageForAppend().append(id, modified, title, username, url, summary, sealed, std::move(attachments));
+    return m_size++;
+}
+
+void EntryStore::assign(size_t row, const PasswordEntry& entry) {
+    assign(row, entry.id, entry.modified, entry.title, entry.username, entry.password, entry.url, entry.notes, entry.attachments);
+}
+
+void EntryStore::assign(size_t row, EntryRef entry) {
+    if (m_key && entry.m_page->key == m_key) {
+        assignSealed(row, entry.id(), entry.modified(), entry.title(), entry.username(), entry.url(), entry.passwordSummary(),
+                     entry.sealedSecrets(), entry.attachments());
+        return;
+    }
+    std::optional<EntrySecrets> secrets = entry.secrets();
+    if (!secrets) {
+        throw std::runtime_error("EntryStore: an entry's secrets don't open");
+    }
+    assign(row, entry.id(), entry.modified(), entry.title(), entry.username(), secrets->password, entry.url(), secrets->notes,
+           entry.attachments());
+}
+
+void EntryStore::assign(size_t row, uint64_t id, uint64_t modified, std::string_view title, std::string_view username,
+                        std::string_view password, std::string_view url, std::string_view notes, std::vector<Attachment> attachments) {
+    ensureKey();
+    assignSealed(row, id, modified, title, username, url, PasswordAnalyzer::summarize(password, *m_fingerprintKey),
+                 bytesView(seal(password, notes, *m_key)), std::move(attachments));
+}
+
+void EntryStore::assignSealed(size_t row, uint64_t id, uint64_t modified, std::string_view title, std::string_view username,
+                              std::string_view url, const PasswordAnalyzer::Summary& summary, std::string_view sealed,
+                              std::vector<Attachment> attachments) {
+    // Build the page anew around the row. The old page lives until
+    // setPage() replaces it, so the views passed in may point into it.
+    size_t index = row / PAGE_ROWS;
+    uint32_t target = (uint32_t)(row % PAGE_ROWS);
+    const EntryPage& old = page(index);
+    std::shared_ptr<EntryPage> rebuilt = newPage();
+    for (uint32_t r = 0; r < old.count; ++r) {
+        if (r == target) {
+            rebuilt->append(id, modified, title, username, url, summary, sealed, std::move(attachments));
+        } else {
+            rebuilt->copyRow(old, r);
+        }
+    }
+    setPage(index, std::move(rebuilt));
+}
+
+size_t EntryStore::remove(size_t row) {
+    size_t last = m_size - 1;
+    if (row != last) {
+        EntryRef moved = (*this)[last];
+        assignSealed(row, moved.id(), moved.modified(), moved.title(), moved.username(), moved.url(), moved.passwordSummary(),
+                     moved.sealedSecrets(), moved.attachments());
+    }
+
+    // Drop the last row; its page goes with it if that was the page's only row
+    if (last % PAGE_ROWS == 0) {
+        popPage();
+    } else {
+        const EntryPage& old = page(last / PAGE_ROWS);
+        std::shared_ptr<EntryPage> rebuilt = newPage();
+        for (uint32_t r = 0; r < last % PAGE_ROWS; ++r) {
+            rebuilt->copyRow(old, r);
+        }
+        setPage(last / PAGE_ROWS, std::move(rebuilt));
+    }
+    --m_size;
+    return last;
+}
+
+void EntryStore::retain(const std::vector<bool>& keep) {
+    EntryStore kept;
+    kept.m_key = m_key;
+    kept.m_fingerprintKey = m_fingerprintKey;
+    kept.m_textPerRow = m_textPerRow;
+    size_t row = 0;
+    for (EntryRef entry : *this) {
+        if (keep[row++]) {
+            kept.append(entry);
+        }
+    }
+    *this = std::move(kept);
+}
+
+void EntryStore::setId(size_t row, uint64_t id) {
+    mutablePage(row / PAGE_ROWS).ids[row % PAGE_ROWS] = id;
+}
+
+void EntryStore::setModified(size_t row, uint64_t modified) {
+    mutablePage(row / PAGE_ROWS).modified[row % PAGE_ROWS] = modified;
+}
+
+void EntryStore::clear() {
+    m_root.reset();
+    m_pool.reset();
+    m_depth = 0;
+    m_size = 0;
+}
+
+size_t EntryStore::memoryBytes() const {
+    size_t bytes = m_pool ? m_pool->memoryBytes() : 0;
+    std::vector<const Node*> nodes;
+    if (m_root) nodes.push_back(m_root.get());
+    while (!nodes.empty()) {
+        const Node* node = nodes.back();
+        nodes.pop_back();
+        bytes += sizeof(Node) + node->children.capacity() * sizeof(std::shared_ptr<Node>) +
+                 node->pages.capacity() * sizeof(std::shared_ptr<EntryPage>);
+        for (const auto& child : node->children) nodes.push_back(child.get());
+        for (const auto& page : node->pages) bytes += page->memoryBytes();
+    }
+    return bytes;
+}
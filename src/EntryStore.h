@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Crypto.h"
+#include "PasswordAnalyzer.h"
+
+/**
+ * @brief A file stored alongside an entry. The contents live encrypted in
+ * their own file (see AttachmentStore); the entry only holds this reference.
+ */
+struct Attachment {
+    std::string id;   // Random; names the encrypted file
+    std::string name; // Original file name, shown to the user
+    uint64_t size = 0; // Plaintext bytes
+};
+
+// Define a structure for a single password entry
+struct PasswordEntry {
+    // We use a simple timestamp as a unique ID
+    uint64_t id;
+    std::string title;
+    std::string username;
+    std::string password;
+    std::string url;
+    std::string notes;
+    uint64_t modified = 0; // Unix time in milliseconds; stamped by Vault on add/edit
+    std::vector<Attachment> attachments;
+};
+
+/**
+ * @brief An entry's password and notes, decrypted (EntryRef::secrets).
+ * Both live in SecurePool memory and are wiped when this goes.
+ */
+struct EntrySecrets {
+    SecureString password;
+    SecureString notes;
+};
+
+class EntryStore;
+class EntryPage;  // A page of rows (EntryStore.cpp)
+class InternPool; // Usernames and urls (EntryStore.cpp)
+
+/**
+ * @brief A read-only view of one entry in an EntryStore, two words wide.
+ *
+ * The string views point into the store's arenas and are each followed by
+ * a NUL, so data() can go wherever a C string is expected. Like a pointer
+ * into a vector, a view is invalidated by any change to the store (but not
+ * by changes to a copy of it).
+ * The password and notes stay sealed until secrets() is called.
+ */
+class EntryRef {
+public:
+    EntryRef() = default;
+
+    explicit operator bool() const { return m_page != nullptr; }
+
+    uint64_t id() const;
+    uint64_t modified() const;
+    std::string_view title() const;
+    std::string_view username() const;
+    std::string_view url() const;
+    const std::vector<Attachment>& attachments() const;
+
+    /**
+     * @brief Strength and reuse fingerprint of the password, kept in the
+     * clear so the list and the health checks never decrypt it.
+     */
+    const PasswordAnalyzer::Summary& passwordSummary() const;
+
+    /**
+     * @brief The sealed password and notes (empty if there are neither), as
+     * EntryCodec writes them.
+     */
+    std::string_view sealedSecrets() const;
+
+    /**
+     * @brief Decrypts the password and notes. Call it when they are shown
+     * or copied, and let the result go soon after.
+     * @return std::nullopt if they don't open (corrupt data).
+     */
+    std::optional<EntrySecrets> secrets() const;
+
+    /**
+     * @brief A standalone copy, secrets decrypted, e.g. to fill in the edit form.
+     */
+    PasswordEntry toEntry() const;
+
+private:
+    friend class EntryStore;
+    EntryRef(const EntryPage* page, uint32_t row) : m_page(page), m_row(row) {}
+
+    const EntryPage* m_page = nullptr;
+    uint32_t m_row = 0; // Within the page
+};
+
+/**
+ * @brief Entries stored column by column (structure of arrays) instead of
+ * as one PasswordEntry, with five std::strings, per entry, in pages that
+ * copies of the store share.
+ *
+ * Rows are grouped into pages of PAGE_ROWS. Within a page:
+ *   ids, modified times   one array each
+ *   titles                [offset, length] spans into the page's text arena
+ *   usernames, urls       pointers into the store's intern pool, so a value
+ *                         repeated anywhere in the store (the same email, the
+ *                         same login page) is stored once
+ *   password and notes    sealed together per entry (Crypto::seal under the
+ *                         store's key), as spans into a separate arena
+ *   password summaries    strength and keyed fingerprint per entry (see
+ *                         PasswordAnalyzer::summarize)
+ *   attachments           a vector per entry; empty for almost all
+ * so a page is three allocations, and a scan over one field reads one
+ * dense array per page. Arenas hold up to 4 GiB each.
+ *
+ * The intern pool is append-only and shared by the store and its copies:
+ * a value never moves once added, so copies read it from any thread, and
+ * values no row uses anymore stay until the store is rebuilt (setKey,
+ * retain) or cleared.
+ *
+ * The pages hang off a 32-way tree (a persistent vector), and are shared,
+ * never changed, once the store has been copied: copying a store is O(1),
+ * and the first change to a shared page rebuilds that page and copies the
+ * tree nodes above it, O(log n). A copy is therefore a snapshot that stays
+ * as it is, which another thread may read while this one keeps changing the
+ * store (Vault's background saves and undo history). Pages nothing else
+ * holds are changed in place: appends fill them, and any other change
+ * rebuilds the page, which also leaves it without garbage.
+ *
+ * The arenas and the pool come from SecurePool, so every string of every
+ * entry sits in guarded, locked memory, and bytes are wiped when the page
+ * (or pool) holding them goes.
+ *
+ * Only what the list needs is ever in the clear; passwords and notes are
+ * decrypted one entry at a time, by EntryRef::secrets(). The key is the
+ * vault's data key (setKey), so the sealed secrets go to and from the file
+ * as they are: loading doesn't open them and saving doesn't reseal them. A
+ * store given plaintext before it has a key makes a random one.
+ *
+ * Rows are dense: remove() moves the last row into the hole, like Vault
+ * always did with its vector of entries.
+ */
+class EntryStore {
+public:
+    static constexpr size_t PAGE_ROWS = 64;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = EntryRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = EntryRef;
+
+        Iterator(const EntryStore* store, size_t row) : m_store(store), m_row(row) { findPage(); }
+        EntryRef operator*() const { return EntryRef(m_page, (uint32_t)(m_row % PAGE_ROWS)); }
+        Iterator& operator++() {
+            if (++m_row % PAGE_ROWS == 0) findPage();
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return m_row == other.m_row; }
+        bool operator!=(const Iterator& other) const { return m_row != other.m_row; }
+
+    private:
+        // The tree is walked once per page, not once per row
+        void findPage() { m_page = m_row < m_store->size() ? &m_store->page(m_row / PAGE_ROWS) : nullptr; }
+
+        const EntryStore* m_store;
+        size_t m_row;
+        const EntryPage* m_page = nullptr;
+    };
+
+    // Copies are O(1): they share every page (see above)
+    EntryStore() = default;
+    EntryStore(const EntryStore& other) = default;
+    EntryStore& operator=(const EntryStore& other) = default;
+    EntryStore(EntryStore&& other) noexcept;
+    EntryStore& operator=(EntryStore&& other) noexcept;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    EntryRef operator[](size_t row) const { return EntryRef(&page(row / PAGE_ROWS), (uint32_t)(row % PAGE_ROWS)); }
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, m_size); }
+
+    /**
+     * @brief Sets the (non-null) key secrets are sealed under, resealing
+     * (and re-fingerprinting) every entry if it had another one.
+     */
+    void setKey(std::shared_ptr<const Crypto::KeyHandle> key);
+    const std::shared_ptr<const Crypto::KeyHandle>& key() const { return m_key; }
+
+    /**
+     * @brief Hints that `rows` entries with `textBytes` of titles (one NUL
+     * each included) are about to be appended, so each new page sizes its
+     * text arena once.
+     */
+    void reserve(size_t rows, size_t textBytes = 0);
+
+    /**
+     * @brief Appends an entry as the last row, sealing its password and
+     * notes. An EntryRef must be a row of another store (or of a copy of
+     * this one); its sealed secrets are copied as they are if both stores
+     * share a key.
+     * @return Its row.
+     */
+    size_t append(const PasswordEntry& entry);
+    size_t append(EntryRef entry);
+    size_t append(uint64_t id, uint64_t modified, std::string_view title, std::string_view username, std::string_view password,
+                  std::string_view url, std::string_view notes, std::vector<Attachment> attachments);
+
+    /**
+     * @brief Appends an entry whose secrets are already sealed under this
+     * store's key, with their summary (as EntryCodec reads them from a file).
+     */
+    size_t appendSealed(uint64_t id, uint64_t modified, std::string_view title, std::string_view username, std::string_view url,
+                        const PasswordAnalyzer::Summary& summary, std::string_view sealed, std::vector<Attachment> attachments);
+
+    /**
+     * @brief Overwrites a row with another entry; again, an EntryRef must be
+     * a row of another store or copy.
+     */
+    void assign(size_t row, const PasswordEntry& entry);
+    void assign(size_t row, EntryRef entry);
+    void assign(size_t row, uint64_t id, uint64_t modified, std::string_view title, std::string_view username, std::string_view password,
+                std::string_view url, std::string_view notes, std::vector<Attachment> attachments);
+    void assignSealed(size_t row, uint64_t id, uint64_t modified, std::string_view title, std::string_view username,
+                      std::string_view url, const PasswordAnalyzer::Summary& summary, std::string_view sealed,
+                      std::vector<Attachment> attachments);
+
+    /**
+     * @brief Removes a row, moving the last row into its place.
+     * @return The row the last entry came from (equal to `row` if it was the last).
+     */
+    size_t remove(size_t row);
+
+    /**
+     * @brief Keeps the rows with keep[row] set, in order.
+     */
+    void retain(const std::vector<bool>& keep);
+
+    void setId(size_t row, uint64_t id);
+    void setModified(size_t row, uint64_t modified);
+
+    /**
+     * @brief Empties the store, keeping the key. Pages no copy holds are
+     * wiped and handed back to the pool.
+     */
+    void clear();
+
+    /**
+     * @brief Heap bytes held: pages, arenas and tree nodes, by capacity,
+     * counting pages shared with copies in full.
+     */
+    size_t memoryBytes() const;
+
+private:
+    struct Node; // A tree node: up to 32 pages, or 32 nodes
+
+    // The sealed form of a password and notes: [PASSWORD LENGTH (4, LE)]
+    // [PASSWORD][NOTES] through Crypto::seal; empty if both are
+    static std::vector<unsigned char> seal(std::string_view password, std::string_view notes, const Crypto::KeyHandle& key);
+    void ensureKey();
+
+    // --- The tree ---
+    const EntryPage& page(size_t index) const;
+    EntryPage& mutablePage(size_t index); // Unshares it and the nodes above it
+    EntryPage& lastPageForAppend();       // Likewise, with room for a row
+    void setPage(size_t index, std::shared_ptr<EntryPage> page);
+    void pushPage(std::shared_ptr<EntryPage> page);
+    void popPage();
+    std::shared_ptr<EntryPage> newPage();
+    size_t pageCount() const { return (m_size + PAGE_ROWS - 1) / PAGE_ROWS; }
+
+    std::shared_ptr<Node> m_root;
+    uint32_t m_depth = 0;                      // Node levels; pages hang off the lowest
+    size_t m_size = 0;
+    size_t m_textPerRow = 0;                   // From reserve()
+    std::shared_ptr<InternPool> m_pool;        // Shared with copies
+    std::shared_ptr<const Crypto::KeyHandle> m_key;
+    std::shared_ptr<const Crypto::KeyHandle> m_fingerprintKey; // A subkey of m_key
+};
@@ -0,0 +1,94 @@
+#include "EntryView.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    std::string lowercase(std::string_view text) {
+        std::string lower(text.size(), '\0');
+        for (size_t i = 0; i < text.size(); ++i) {
+            lower[i] = (char)std::tolower((unsigned char)text[i]);
+        }
+        return lower;
+    }
+}
+
+bool EntryView::update(Vault& vault, const std::string& filter, SortOrder order, Show show) {
+    if (m_revision == vault.revision() && m_order == order && m_filter == filter && m_show == show) {
+        return false;
+    }
+    m_revision = vault.revision();
+    m_order = order;
+    m_filter = filter;
+    m_show = show;
+
+    // 1. Collect the rows: everything, or the search results
+    const EntryStore& entries = vault.entries();
+    m_rows.clear();
+    if (filter.find_first_not_of(" \t") == std::string::npos) {
+        m_rows.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            m_rows.push_back(vault.handleAt(i));
+        }
+    } else {
+        m_rows = vault.search(filter);
+    }
+    if (show != Show::All) {
+        // O(1) per row: the analysis is kept current as entries change
+        const PasswordAnalyzer& analysis = vault.analysis();
+        auto hidden = [&](EntryHandle handle) {
+            uint64_t id = vault.getEntry(handle).id();
+            bool reused = (show == Show::Reused || show == Show::ReusedOrWeak) && analysis.isReused(id);
+            bool weak = (show == Show::Weak || show == Show::ReusedOrWeak) && analysis.isWeak(id);
+            return !reused && !weak;
+        };
+        m_rows.erase(std::remove_if(m_rows.begin(), m_rows.end(), hidden), m_rows.end());
+    }
+
+    // 2. Sort them. Build each row's sort key once up front rather than in every
+    // comparison; lowercasing inside the comparator is ~10x slower at 250k rows.
+    if (order == SortOrder::Title) {
+        struct Row { std::string key; uint64_t id; EntryHandle handle; };
+        std::vector<Row> keyed;
+        keyed.reserve(m_rows.size());
+        for (EntryHandle handle : m_rows) {
+            EntryRef entry = vault.getEntry(handle);
+            keyed.push_back(Row{ lowercase(entry.title()), entry.id(), handle });
+        }
+        std::sort(keyed.begin(), keyed.end(), [](const Row& a, const Row& b) {
+            int c = a.key.compare(b.key);
+            return c != 0 ? c < 0 : a.id < b.id; // Keep equal titles in a stable order
+        });
+        for (size_t i = 0; i < keyed.size(); ++i) {
+            m_rows[i] = keyed[i].handle;
+        }
+    } else {
+        struct Row { uint64_t modified; uint64_t id; EntryHandle handle; };
+        std::vector<Row> keyed;
+        keyed.reserve(m_rows.size());
+        for (EntryHandle handle : m_rows) {
+            EntryRef entry = vault.getEntry(handle);
+            keyed.push_back(Row{ entry.modified(), entry.id(), handle });
+        }
+        std::sort(keyed.begin(), keyed.end(), [](const Row& a, const Row& b) {
+            return a.modified != b.modified ? a.modified > b.modified : a.id < b.id; // Newest first
+        });
+        for (size_t i = 0; i < keyed.size(); ++i) {
+            m_rows[i] = keyed[i].handle;
+        }
+    }
+    return true;
+}
+
+void EntryView::invalidate() {
+    m_rows.clear();
+    m_revision = 0;
+}
+
+const std::vector<EntryHandle>& EntryView::rows() const {
+    return m_rows;
+}
+
+size_t EntryView::size() const {
+    return m_rows.size();
+}
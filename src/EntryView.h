@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Vault.h"
+
+/**
+ * @brief The filtered, sorted list of entries the UI shows, cached between frames.
+ *
+ * update() is cheap to call every frame: it only searches and sorts again
+ * when the filter text, the sort order, the Show setting or the vault's
+ * revision changed.
+ * The UI then draws just the visible rows (see ImGuiListClipper).
+ */
+class EntryView {
+public:
+    enum class SortOrder {
+        Title,           // A-Z, ignoring case
+        RecentlyModified // Newest first
+    };
+
+    enum class Show {
+        All,
+        Reused, // Entries sharing their password with another (see Vault::analysis)
+        Weak,
+        ReusedOrWeak
+    };
+
+    /**
+     * @brief Brings the view up to date with the vault.
+     * @param filter Search text (see Vault::search). Empty shows every entry.
+     * @param show Narrows the rows to entries with password problems.
+     * @return True if the rows were recomputed.
+     */
+    bool update(Vault& vault, const std::string& filter, SortOrder order, Show show = Show::All);
+
+    /**
+     * @brief Drops the cached rows, forcing the next update() to recompute.
+     */
+    void invalidate();
+
+    const std::vector<EntryHandle>& rows() const;
+    size_t size() const;
+
+private:
+    std::vector<EntryHandle> m_rows;
+    std::string m_filter;
+    SortOrder m_order = SortOrder::Title;
+    Show m_show = Show::All;
+    uint64_t m_revision = 0; // Vault revisions start at 1, so 0 means "never computed"
+};
@@ -0,0 +1,116 @@
+#include "FrameScheduler.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+    const std::chrono::milliseconds TIMER_SLACK{ 2 };
+}
+
+FrameScheduler::FrameScheduler() : FrameScheduler(Settings()) {}
+
+FrameScheduler::FrameScheduler(Settings settings)
+    : m_settings(settings), m_framesLeft(settings.settleFrames) { // Draw the first frames right away
+    m_waitStarted = m_frameStarted = m_windowStart = Clock::now();
+    m_windowCpuStart = processCpuSeconds();
+}
+
+double FrameScheduler::processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    auto seconds = [](const FILETIME& time) {
+        return (double)(((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) * 1e-7; // 100 ns ticks
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    timespec time{};
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) {
+        return 0.0;
+    }
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+void FrameScheduler::requestFrame() {
+    m_framesLeft = std::max(m_framesLeft, m_settings.settleFrames);
+}
+
+void FrameScheduler::requestFrameIn(std::chrono::milliseconds delay) {
+    requestFrameAt(Clock::now() + delay);
+}
+
+void FrameScheduler::requestFrameAt(Clock::time_point when) {
+    if (!m_due || when < *m_due) {
+        m_due = when;
+    }
+}
+
+std::optional<double> FrameScheduler::waitSeconds() const {
+    if (m_framesLeft > 0) {
+        return 0.0;
+    }
+    if (!m_due) {
+        return std::nullopt;
+    }
+    return std::max(0.0, std::chrono::duration<double>(*m_due - Clock::now()).count());
+}
+
+void FrameScheduler::beginFrame() {
+    m_frameStarted = Clock::now();
+    m_windowIdleSeconds += std::chrono::duration<double>(m_frameStarted - m_waitStarted).count();
+
+    // 1. Woken before anything was due: an event. Settle, then catch tooltips.
+    // Timed waits can end a little early (the platform rounds them), hence
+    // the slack.
+    bool timerDue = m_due && m_frameStarted + TIMER_SLACK >= *m_due;
+    if (m_framesLeft == 0 && !timerDue) {
+        m_framesLeft = m_settings.settleFrames;
+        m_due.reset();
+        requestFrameAt(m_frameStarted + m_settings.hoverDelay);
+    } else if (timerDue) {
+        m_due.reset();
+    }
+    if (m_framesLeft > 0) {
+        --m_framesLeft;
+    }
+}
+
+void FrameScheduler::endFrame() {
+    m_waitStarted = Clock::now();
+    m_windowFrameSeconds += std::chrono::duration<double>(m_waitStarted - m_frameStarted).count();
+    ++m_windowFrames;
+    ++m_stats.frames;
+
+    // 2. Close the window once it spans a second. Idle stretches make it
+    // longer, so an idle window reports its true (low) frame rate.
+    double windowSeconds = std::chrono::duration<double>(m_waitStarted - m_windowStart).count();
+    if (windowSeconds < 1.0) {
+        return;
+    }
+    double cpu = processCpuSeconds();
+    m_stats.framesPerSecond = (double)m_windowFrames / windowSeconds;
+    m_stats.frameMs = m_windowFrameSeconds * 1000.0 / (double)m_windowFrames;
+    m_stats.cpuPercent = (cpu - m_windowCpuStart) * 100.0 / windowSeconds;
+    m_stats.idlePercent = std::min(100.0, m_windowIdleSeconds * 100.0 / windowSeconds);
+
+    m_windowStart = m_waitStarted;
+    m_windowCpuStart = cpu;
+    m_windowFrames = 0;
+    m_windowFrameSeconds = 0.0;
+    m_windowIdleSeconds = 0.0;
+}
+
+const FrameScheduler::Stats& FrameScheduler::stats() const {
+    return m_stats;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+/**
+ * @brief Decides when the UI loop draws a frame, so an untouched window
+ * costs (next to) nothing instead of a full ImGui frame at vsync rate.
+ *
+ * The loop blocks for events for up to waitSeconds(), then brackets the
+ * frame with beginFrame() and endFrame(). A frame is drawn when:
+ *   - an event arrives (input, resize, or a background job posting an empty
+ *     event when it finishes), followed by a few settle frames, since ImGui
+ *     often needs another frame or two to show the result of an input, and
+ *     one more after the hover delay, for tooltips;
+ *   - a timer is due, set with requestFrameIn() (an autosave coming due, a
+ *     progress display, a blinking text cursor).
+ * Otherwise the loop sleeps in the event wait. It never polls.
+ *
+ * Also measures what the frames cost: frames drawn, time spent in them and
+ * the process's CPU use, per one-second window (see stats()). The CPU
+ * figure covers every thread, so background saves show up in it too.
+ *
+ * UI thread only.
+ */
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        int settleFrames = 3; // Drawn after each wake-up
+        std::chrono::milliseconds hoverDelay{ 600 }; // Then one more frame this long after the last event
+    };
+
+    struct Stats {
+        double framesPerSecond = 0.0;
+        double frameMs = 0.0;     // Average time from beginFrame() to endFrame()
+        double cpuPercent = 0.0;  // Process CPU time over wall time; 100 is one core
+        double idlePercent = 0.0; // Time outside frames: the event wait and buffer swaps
+        uint64_t frames = 0;      // Drawn since start
+    };
+
+    FrameScheduler();
+    explicit FrameScheduler(Settings settings);
+
+    /**
+     * @brief Draws the next frames as if an event had arrived, e.g. after a
+     * change made outside the UI.
+     */
+    void requestFrame();
+
+    /**
+     * @brief Draws a frame no later than `delay` from now (or at `when`).
+     * The earliest pending request wins, and it's dropped once it fires or
+     * an event wakes the loop, so callers re-arm their timers every frame.
+     */
+    void requestFrameIn(std::chrono::milliseconds delay);
+    void requestFrameAt(Clock::time_point when);
+
+    /**
+     * @brief How long the loop may wait for events before the next frame is
+     * due: 0 to draw right away, std::nullopt to wait for events alone.
+     */
+    std::optional<double> waitSeconds() const;
+
+    /**
+     * @brief Call after the wait, before drawing. Any return from the wait
+     * before a timer fell due counts as an event.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Call once the frame is drawn, before swapping buffers (the swap
+     * waits for vsync, which would otherwise count as frame time).
+     */
+    void endFrame();
+
+    /**
+     * @brief Figures for the last complete one-second window.
+     */
+    const Stats& stats() const;
+
+private:
+    static double processCpuSeconds();
+
+    Settings m_settings;
+    int m_framesLeft;                       // Settle frames still to draw
+    std::optional<Clock::time_point> m_due; // Earliest timer
+    Clock::time_point m_waitStarted;
+    Clock::time_point m_frameStarted;
+
+    // The window being measured
+    Clock::time_point m_windowStart;
+    double m_windowCpuStart;
+    uint64_t m_windowFrames = 0;
+    double m_windowFrameSeconds = 0.0;
+    double m_windowIdleSeconds = 0.0;
+    Stats m_stats;
+};
@@ -0,0 +1,394 @@
+#include "Importer.h"
+#include "Crypto.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+using json = nlohmann::json;
+
+namespace {
+
+    // Below this, splitting a file costs more than parsing it on one thread
+    const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+    // Chunks per thread, so one slow chunk doesn't leave the others idle
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    size_t chunkCount(size_t bytes, ThreadPool& pool) {
+        return std::max<size_t>(1, std::min(bytes / MIN_CHUNK_BYTES, pool.concurrency() * CHUNKS_PER_THREAD));
+    }
+
+    std::string_view skipBom(std::string_view text) {
+        if (text.size() >= 3 && text.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            text.remove_prefix(3);
+        }
+        return text;
+    }
+
+    // Which column (CSV) holds which field; -1 if none
+    struct Columns {
+        int title = -1;
+        int username = -1;
+        int password = -1;
+        int url = -1;
+        int notes = -1;
+
+        bool any() const { return title >= 0 || username >= 0 || password >= 0 || url >= 0 || notes >= 0; }
+    };
+
+    // Fills the gaps browsers leave: Firefox exports have no title column
+    void finishEntry(PasswordEntry& entry) {
+        if (!entry.title.empty()) {
+            return;
+        }
+        std::string_view host = entry.url;
+        size_t scheme = host.find("://");
+        if (scheme != std::string_view::npos) {
+            host.remove_prefix(scheme + 3);
+        }
+        host = host.substr(0, host.find_first_of("/?#"));
+        entry.title = !host.empty() ? std::string(host) : !entry.username.empty() ? entry.username : "Imported entry";
+    }
+
+    bool isEmpty(const PasswordEntry& entry) {
+        return entry.title.empty() && entry.username.empty() && entry.password.empty() && entry.url.empty() && entry.notes.empty();
+    }
+
+    // --- CSV ---
+
+    /**
+     * Reads one RFC 4180 row starting at p into fields[0, count), reusing the
+     * strings' buffers from row to row.
+     * @return The start of the next row.
+     */
+    const char* readRow(const char* p, const char* end, std::vector<std::string>& fields, size_t& count) {
+        count = 0;
+        auto nextField = [&]() -> std::string& {
+            if (count == fields.size()) fields.emplace_back();
+            std::string& field = fields[count++];
+            field.clear();
+            return field;
+        };
+
+        std::string* field = &nextField();
+        bool fieldStart = true;
+        while (p < end) {
+            if (fieldStart && *p == '"') {
+                // Quoted: runs to the closing quote; "" is a literal quote
+                ++p;
+                while (p < end) {
+                    const char* quote = (const char*)std::memchr(p, '"', end - p);
+                    if (quote == nullptr) quote = end;
+                    field->append(p, quote);
+                    p = quote;
+                    if (p == end) break;
+                    ++p;
+                    if (p < end && *p == '"') {
+                        field->push_back('"');
+                        ++p;
+                    } else {
+                        break;
+                    }
+                }
+                fieldStart = false;
+                continue;
+            }
+
+            const char* start = p;
+            while (p < end && *p != ',' && *p != '\n' && *p != '\r') ++p;
+            field->append(start, p);
+            fieldStart = false;
+            if (p == end) break;
+
+            char c = *p++;
+            if (c == ',') {
+                field = &nextField();
+                fieldStart = true;
+            } else {
+                if (c == '\r' && p < end && *p == '\n') ++p;
+                break;
+            }
+        }
+        return p;
+    }
+
+    std::string lowercase(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return text;
+    }
+
+    Columns mapColumns(const std::vector<std::string>& header, size_t count) {
+        Columns columns;
+        for (size_t i = 0; i < count; ++i) {
+            std::string name = lowercase(header[i]);
+            name.erase(0, name.find_first_not_of(' '));
+            name.erase(name.find_last_not_of(' ') + 1);
+            int* column = nullptr;
+            if (name == "name" || name == "title" || name == "account") column = &columns.title;
+            else if (name == "username" || name == "login_username" || name == "login name" || name == "login" || name == "user") column = &columns.username;
+            else if (name == "password" || name == "login_password") column = &columns.password;
+            else if (name == "url" || name == "login_uri" || name == "uri" || name == "website" || name == "web site") column = &columns.url;
+            else if (name == "notes" || name == "note" || name == "comments" || name == "extra") column = &columns.notes;
+            if (column != nullptr && *column < 0) {
+                *column = (int)i;
+            }
+        }
+        return columns;
+    }
+
+    void parseCsvChunk(const char* p, const char* end, const Columns& columns, Importer::Result& result) {
+        std::vector<std::string> fields;
+        size_t count;
+        auto take = [&](int column, std::string& out) {
+            if (column >= 0 && (size_t)column < count) out = std::move(fields[column]);
+        };
+
+        while (p < end) {
+            p = readRow(p, end, fields, count);
+            if (count == 1 && fields[0].empty()) {
+                continue; // Blank line
+            }
+            PasswordEntry entry{};
+            take(columns.title, entry.title);
+            take(columns.username, entry.username);
+            take(columns.password, entry.password);
+            take(columns.url, entry.url);
+            take(columns.notes, entry.notes);
+            if (isEmpty(entry)) {
+                ++result.skippedRows;
+                continue;
+            }
+            finishEntry(entry);
+            result.entries.push_back(std::move(entry));
+        }
+        for (auto& field : fields) {
+            Crypto::wipe(field);
+        }
+    }
+
+    /**
+     * Cuts [begin, text.size()) into chunks that start at row boundaries.
+     * A newline ends a row only outside quotes, i.e. after an even number of
+     * quote characters, so each block's quotes are counted in parallel first;
+     * their running total gives every block's starting parity.
+     */
+    std::vector<size_t> csvChunkStarts(std::string_view text, size_t begin, ThreadPool& pool) {
+        size_t blocks = chunkCount(text.size() - begin, pool);
+        size_t blockBytes = (text.size() - begin + blocks - 1) / blocks;
+        auto blockStart = [&](size_t b) { return std::min(text.size(), begin + b * blockBytes); };
+
+        // 1. Quotes per block
+        std::vector<size_t> quotes(blocks);
+        pool.parallelFor(blocks, [&](size_t b) {
+            quotes[b] = (size_t)std::count(text.begin() + blockStart(b), text.begin() + blockStart(b + 1), '"');
+        });
+
+        // 2. In each block, the first newline outside quotes
+        std::vector<size_t> starts(blocks, std::string_view::npos);
+        starts[0] = begin;
+        std::vector<bool> inQuotes(blocks);
+        for (size_t b = 1, total = quotes[0]; b < blocks; total += quotes[b++]) {
+            inQuotes[b] = total % 2 == 1;
+        }
+        pool.parallelFor(blocks - 1, [&](size_t i) {
+            size_t b = i + 1;
+            bool quoted = inQuotes[b];
+            for (size_t pos = blockStart(b); pos < blockStart(b + 1); ++pos) {
+                if (text[pos] == '"') {
+                    quoted = !quoted;
+                } else if (text[pos] == '\n' && !quoted) {
+                    starts[b] = pos + 1;
+                    break;
+                }
+            }
+        });
+
+        // 3. Blocks without a row boundary (one long row) merge into the previous chunk
+        starts.erase(std::remove(starts.begin(), starts.end(), std::string_view::npos), starts.end());
+        starts.push_back(text.size());
+        return starts;
+    }
+
+    // --- JSON ---
+
+    std::string stringField(const json& object, const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    // Our own field names, or Bitwarden's ("name", "login": {...})
+    bool entryFromJson(const json& item, PasswordEntry& entry) {
+        if (!item.is_object()) {
+            return false;
+        }
+        entry.title = stringField(item, "title");
+        if (entry.title.empty()) entry.title = stringField(item, "name");
+        entry.username = stringField(item, "username");
+        entry.password = stringField(item, "password");
+        entry.url = stringField(item, "url");
+        entry.notes = stringField(item, "notes");
+        if (entry.notes.empty()) entry.notes = stringField(item, "note");
+
+        auto login = item.find("login");
+        if (login != item.end() && login->is_object()) {
+            if (entry.username.empty()) entry.username = stringField(*login, "username");
+            if (entry.password.empty()) entry.password = stringField(*login, "password");
+            auto uris = login->find("uris");
+            if (entry.url.empty() && uris != login->end() && uris->is_array() && !uris->empty() && (*uris)[0].is_object()) {
+                entry.url = stringField((*uris)[0], "uri");
+            }
+        }
+        if (isEmpty(entry)) {
+            return false;
+        }
+        finishEntry(entry);
+        return true;
+    }
+
+    /**
+     * Scans a JSON text for top-level values, calling fn(begin, end) for each,
+     * where the text is a sequence of them separated by commas at depth 0.
+     * Strings are skipped, so brackets and commas inside them don't count.
+     * @return The position where scanning stopped: the closing ']' at depth 0, or end.
+     */
+    template <typename Fn>
+    const char* forEachValue(const char* p, const char* end, size_t minBytes, Fn fn) {
+        int depth = 0;
+        const char* start = p;
+        for (; p < end; ++p) {
+            char c = *p;
+            if (c == '"') {
+                for (++p; p < end && *p != '"'; ++p) {
+                    if (*p == '\\') ++p;
+                }
+            } else if (c == '[' || c == '{') {
+                ++depth;
+            } else if ((c == ']' || c == '}') && depth > 0) {
+                --depth;
+            } else if (c == ']') {
+                break;
+            } else if (c == ',' && depth == 0 && (size_t)(p - start) >= minBytes) {
+                fn(start, p);
+                start = p + 1;
+            }
+        }
+        p = std::min(p, end); // An escape at the very end can step past it
+        if (std::any_of(start, p, [](char ch) { return !std::isspace((unsigned char)ch); })) {
+            fn(start, p);
+        }
+        return p;
+    }
+
+} // namespace
+
+std::optional<Importer::Result> Importer::parseCsv(std::string_view text, ThreadPool& pool) {
+    text = skipBom(text);
+
+    // 1. The header row says which column is which
+    std::vector<std::string> header;
+    size_t count = 0;
+    const char* bodyStart = readRow(text.data(), text.data() + text.size(), header, count);
+    Columns columns = mapColumns(header, count);
+    if (!columns.any()) {
+        std::cerr << "Import: no known columns (name, username, password, url, notes) in the CSV header." << std::endl;
+        return std::nullopt;
+    }
+
+    // 2. Parse the chunks in parallel, then join them in file order
+    std::vector<size_t> starts = csvChunkStarts(text, bodyStart - text.data(), pool);
+    std::vector<Result> chunks(starts.size() - 1);
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        parseCsvChunk(text.data() + starts[i], text.data() + starts[i + 1], columns, chunks[i]);
+    });
+
+    Result result;
+    size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.entries.size();
+    result.entries.reserve(total);
+    for (auto& chunk : chunks) {
+        std::move(chunk.entries.begin(), chunk.entries.end(), std::back_inserter(result.entries));
+        result.skippedRows += chunk.skippedRows;
+    }
+    return result;
+}
+
+std::optional<Importer::Result> Importer::parseJson(std::string_view text, ThreadPool& pool) {
+    text = skipBom(text);
+    const char* p = text.data();
+    const char* end = text.data() + text.size();
+    while (p < end && std::isspace((unsigned char)*p)) ++p;
+
+    Result result;
+    try {
+        // A Bitwarden-style object is parsed in one piece
+        if (p < end && *p == '{') {
+            json document = json::parse(p, end);
+            auto items = document.find("items");
+            if (items == document.end() || !items->is_array()) {
+                std::cerr << "Import: JSON object has no \"items\" array." << std::endl;
+                return std::nullopt;
+            }
+            for (const auto& item : *items) {
+                PasswordEntry entry{};
+                if (entryFromJson(item, entry)) result.entries.push_back(std::move(entry));
+                else ++result.skippedRows;
+            }
+            return result;
+        }
+        if (p == end || *p != '[') {
+            std::cerr << "Import: expected a JSON array of entries." << std::endl;
+            return std::nullopt;
+        }
+
+        // 1. Cut the array into chunks of whole elements
+        std::vector<std::pair<const char*, const char*>> chunks;
+        size_t minBytes = std::max(MIN_CHUNK_BYTES, text.size() / chunkCount(text.size(), pool));
+        const char* close = forEachValue(p + 1, end, minBytes, [&](const char* b, const char* e) { chunks.emplace_back(b, e); });
+        if (close == end) {
+            std::cerr << "Import: JSON array is not closed." << std::endl;
+            return std::nullopt;
+        }
+
+        // 2. Each chunk splits itself into elements and parses them
+        std::vector<Result> parsed(chunks.size());
+        pool.parallelFor(chunks.size(), [&](size_t i) {
+            forEachValue(chunks[i].first, chunks[i].second, 0, [&](const char* b, const char* e) {
+                PasswordEntry entry{};
+                if (entryFromJson(json::parse(b, e), entry)) parsed[i].entries.push_back(std::move(entry));
+                else ++parsed[i].skippedRows;
+            });
+        });
+
+        for (auto& chunk : parsed) {
+            std::move(chunk.entries.begin(), chunk.entries.end(), std::back_inserter(result.entries));
+            result.skippedRows += chunk.skippedRows;
+        }
+    }
+    catch (const json::exception& e) {
+        std::cerr << "Import: invalid JSON: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<Importer::Result> Importer::parseFile(const std::string& filepath, ThreadPool& pool) {
+    MappedFile file;
+    if (!file.open(filepath)) {
+        std::cerr << "Import: can't open " << filepath << "." << std::endl;
+        return std::nullopt;
+    }
+    std::string_view text = skipBom(std::string_view((const char*)file.data(), file.size()));
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        std::cerr << "Import: " << filepath << " is empty." << std::endl;
+        return std::nullopt;
+    }
+    return text[first] == '[' || text[first] == '{' ? parseJson(text, pool) : parseCsv(text, pool);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Vault.h"
+
+class ThreadPool;
+
+/**
+ * @brief Bulk import of entries exported by browsers and other password managers.
+ *
+ * CSV: a header row names the columns; recognized (case-insensitively) are
+ *   title:    name, title, account
+ *   username: username, login_username, login name, login, user
+ *   password: password, login_password
+ *   url:      url, login_uri, uri, website, web site
+ *   notes:    notes, note, comments, extra
+ * which covers Chrome, Firefox, Bitwarden, KeePass, LastPass and 1Password
+ * exports. Fields follow RFC 4180 (quotes, doubled quotes, embedded newlines).
+ *
+ * JSON: an array of objects with the field names above (e.g. cppvault-cli
+ * export), or a Bitwarden export ({"items": [{"name", "notes", "login":
+ * {"username", "password", "uris": [{"uri"}]}}]}).
+ *
+ * The file is memory-mapped and cut into chunks at row (or array element)
+ * boundaries, and the chunks are parsed on a ThreadPool. Rows come back in
+ * file order without ids; Vault::importEntries assigns them.
+ */
+namespace Importer {
+
+    struct Result {
+        std::vector<PasswordEntry> entries;
+        size_t skippedRows = 0; // Rows with none of the known fields filled in
+    };
+
+    /**
+     * @brief Parses CSV text (header row first).
+     * @return std::nullopt if there's no header or it has no recognized column.
+     */
+    std::optional<Result> parseCsv(std::string_view text, ThreadPool& pool);
+
+    /**
+     * @brief Parses JSON text (see above).
+     * @return std::nullopt if it isn't valid JSON of a recognized shape.
+     */
+    std::optional<Result> parseJson(std::string_view text, ThreadPool& pool);
+
+    /**
+     * @brief Maps a file and parses it as JSON if it starts with '[' or '{',
+     * otherwise as CSV. Errors are reported on std::cerr.
+     */
+    std::optional<Result> parseFile(const std::string& filepath, ThreadPool& pool);
+
+} // namespace Importer
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A whole file mapped read-only into memory.
+ *
+ * Used to load the vault: the ciphertext is read straight out of the page
+ * cache, with no copy into a heap buffer, and decrypted from there. Move-only;
+ * the mapping goes away with the object.
+ *
+ * Reading a mapped file that another process truncates crashes (SIGBUS).
+ * Vault files are only ever appended to or replaced by rename, never
+ * truncated in place, so a mapping of one stays readable.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file, replacing any previous mapping.
+     * An empty file opens successfully with size() 0 and data() nullptr.
+     * @return False if the file doesn't exist or can't be mapped.
+     */
+    bool open(const std::string& filepath);
+
+    /**
+     * @brief Unmaps the file. Pointers into it become invalid.
+     */
+    void close();
+
+    const unsigned char* data() const;
+    size_t size() const;
+
+private:
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_mapping = nullptr; // HANDLE of the file mapping object
+#endif
+};
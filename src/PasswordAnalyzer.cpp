@@ -0,0 +1,187 @@
+#include "PasswordAnalyzer.h"
+#include "EntryStore.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+#include <sodium.h>
+
+namespace {
+
+    // Shorter passwords are Weak at best, whatever characters they use
+    const size_t MIN_FAIR_LENGTH = 8;
+
+    // The most common passwords in breach lists, lowercased; all rate VeryWeak
+    // whatever their length
+    const char* const COMMON_PASSWORDS[] = {
+        "123456", "123456789", "12345678", "password", "qwerty", "qwerty123", "1q2w3e4r", "12345",
+        "111111", "1234567890", "1234567", "000000", "123123", "abc123", "password1", "password123",
+        "iloveyou", "admin", "welcome", "letmein", "monkey", "dragon", "football", "baseball",
+        "sunshine", "princess", "master", "superman", "trustno1", "passw0rd", "qwertyuiop", "1qaz2wsx",
+        "zaq12wsx", "starwars", "whatever", "shadow", "michael", "hello123", "changeme", "secret"
+    };
+
+    bool isCommon(std::string_view password) {
+        if (password.size() > 16) return false;
+        char lower[17];
+        for (size_t i = 0; i < password.size(); ++i) lower[i] = (char)std::tolower((unsigned char)password[i]);
+        std::string_view folded(lower, password.size());
+        bool common = std::any_of(std::begin(COMMON_PASSWORDS), std::end(COMMON_PASSWORDS),
+                                  [&](const char* candidate) { return folded == candidate; });
+        sodium_memzero(lower, sizeof(lower));
+        return common;
+    }
+}
+
+// --- Rating ---
+
+PasswordAnalyzer::Strength PasswordAnalyzer::rate(std::string_view password) {
+    if (password.empty() || isCommon(password)) {
+        return Strength::VeryWeak;
+    }
+
+    // 1. The pool: the classes the password draws from
+    bool upper = false, lower = false, digit = false, other = false;
+    for (unsigned char c : password) {
+        if (std::isupper(c)) upper = true;
+        else if (std::islower(c)) lower = true;
+        else if (std::isdigit(c)) digit = true;
+        else other = true;
+    }
+    int pool = (upper ? 26 : 0) + (lower ? 26 : 0) + (digit ? 10 : 0) + (other ? 33 : 0);
+    double bitsPerChar = std::log2((double)pool);
+
+    // 2. Characters that repeat or step by one from the last add almost nothing
+    double bits = bitsPerChar;
+    for (size_t i = 1; i < password.size(); ++i) {
+        int step = (unsigned char)password[i] - (unsigned char)password[i - 1];
+        bits += (step >= -1 && step <= 1) ? 1.0 : bitsPerChar;
+    }
+
+    if (bits < 28.0) return Strength::VeryWeak;
+    if (bits < 36.0 || password.size() < MIN_FAIR_LENGTH) return Strength::Weak;
+    if (bits < 60.0) return Strength::Fair;
+    if (bits < 80.0) return Strength::Strong;
+    return Strength::VeryStrong;
+}
+
+const char* PasswordAnalyzer::label(Strength strength) {
+    switch (strength) {
+    case Strength::VeryWeak:   return "Very weak";
+    case Strength::Weak:       return "Weak";
+    case Strength::Fair:       return "Fair";
+    case Strength::Strong:     return "Strong";
+    case Strength::VeryStrong: return "Very strong";
+    }
+    return "";
+}
+
+bool PasswordAnalyzer::weak(Strength strength) {
+    return strength <= Strength::Weak;
+}
+
+// --- Fingerprints ---
+
+size_t PasswordAnalyzer::FingerprintHash::operator()(const Fingerprint& fingerprint) const {
+    size_t h;
+    std::memcpy(&h, fingerprint.data(), sizeof(h));
+    return h;
+}
+
+PasswordAnalyzer::Summary PasswordAnalyzer::summarize(std::string_view password, const Crypto::KeyHandle& key) {
+    Summary summary;
+    summary.hasPassword = !password.empty();
+    summary.strength = rate(password);
+    if (summary.hasPassword) {
+        static_assert(crypto_generichash_KEYBYTES == Crypto::KEY_BYTES, "fingerprints are keyed with a data key");
+        crypto_generichash(summary.fingerprint.data(), summary.fingerprint.size(), (const unsigned char*)password.data(),
+                           password.size(), key.data(), crypto_generichash_KEYBYTES);
+    }
+    return summary;
+}
+
+// --- Updates ---
+
+void PasswordAnalyzer::add(EntryRef entry) {
+    remove(entry.id());
+
+    const Summary& record = entry.passwordSummary();
+    if (record.hasPassword) {
+        std::vector<uint64_t>& group = m_groups[record.fingerprint];
+        group.push_back(entry.id());
+        // Joining a lone entry makes both reused; joining a larger group, one more
+        if (group.size() == 2) m_reused += 2;
+        else if (group.size() > 2) m_reused += 1;
+    }
+    if (record.hasPassword && weak(record.strength)) ++m_weak;
+    m_records.emplace(entry.id(), record);
+}
+
+void PasswordAnalyzer::remove(uint64_t id) {
+    auto it = m_records.find(id);
+    if (it == m_records.end()) {
+        return;
+    }
+    const Summary& record = it->second;
+    if (record.hasPassword) {
+        auto group = m_groups.find(record.fingerprint);
+        std::vector<uint64_t>& ids = group->second;
+        if (ids.size() == 2) m_reused -= 2;
+        else if (ids.size() > 2) m_reused -= 1;
+        auto member = std::find(ids.begin(), ids.end(), id);
+        *member = ids.back(); // Order within a group doesn't matter
+        ids.pop_back();
+        if (ids.empty()) m_groups.erase(group);
+    }
+    if (record.hasPassword && weak(record.strength)) --m_weak;
+    m_records.erase(it);
+}
+
+void PasswordAnalyzer::clear() {
+    m_records.clear();
+    m_groups.clear();
+    m_reused = 0;
+    m_weak = 0;
+}
+
+// --- Queries ---
+
+bool PasswordAnalyzer::isReused(uint64_t id) const {
+    return reuseCount(id) > 1;
+}
+
+bool PasswordAnalyzer::isWeak(uint64_t id) const {
+    auto it = m_records.find(id);
+    return it != m_records.end() && it->second.hasPassword && weak(it->second.strength);
+}
+
+size_t PasswordAnalyzer::reuseCount(uint64_t id) const {
+    auto it = m_records.find(id);
+    if (it == m_records.end() || !it->second.hasPassword) {
+        return 0;
+    }
+    return m_groups.find(it->second.fingerprint)->second.size();
+}
+
+std::vector<uint64_t> PasswordAnalyzer::sharingWith(uint64_t id) const {
+    auto it = m_records.find(id);
+    if (it == m_records.end() || !it->second.hasPassword) {
+        return {};
+    }
+    return m_groups.find(it->second.fingerprint)->second;
+}
+
+PasswordAnalyzer::Strength PasswordAnalyzer::strength(uint64_t id) const {
+    auto it = m_records.find(id);
+    return it != m_records.end() ? it->second.strength : Strength::VeryWeak;
+}
+
+size_t PasswordAnalyzer::reusedCount() const {
+    return m_reused;
+}
+
+size_t PasswordAnalyzer::weakCount() const {
+    return m_weak;
+}
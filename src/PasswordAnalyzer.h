@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Crypto.h"
+
+class EntryRef;
+
+/**
+ * @brief Incrementally maintained password health: which entries share a
+ * password, and how strong each one is.
+ *
+ * Passwords are grouped by a keyed BLAKE2b hash (crypto_generichash) under a
+ * key derived from the vault's data key, so the map holds no plaintext and
+ * its fingerprints can't be matched against anything without that key. The
+ * hash and the strength are worked out when a password is set and stored
+ * with the entry (see summarize() and EntryStore), so neither building the
+ * analysis nor keeping it current decrypts a password.
+ * Each add or remove touches one entry and its group;
+ * nothing ever compares entries pairwise. The reused/weak totals are kept
+ * as counters, so reading them is O(1).
+ */
+class PasswordAnalyzer {
+public:
+    enum class Strength : uint8_t {
+        VeryWeak, // A common password, or under 28 bits
+        Weak,     // Under 36 bits, or under 8 characters
+        Fair,     // Under 60 bits
+        Strong,   // Under 80 bits
+        VeryStrong
+    };
+
+    using Fingerprint = std::array<unsigned char, 16>;
+
+    /**
+     * @brief What the analysis needs to know about one password.
+     */
+    struct Summary {
+        bool hasPassword = false;
+        Strength strength = Strength::VeryWeak;
+        Fingerprint fingerprint{}; // All zero without a password
+    };
+
+    /**
+     * @brief Rates and fingerprints a password. Only summaries made with the
+     * same key can be compared.
+     */
+    static Summary summarize(std::string_view password, const Crypto::KeyHandle& key);
+
+    /**
+     * @brief Adds an entry's password summary, replacing any previous version with the same ID.
+     */
+    void add(EntryRef entry);
+
+    /**
+     * @brief Forgets an entry. Unknown IDs are ignored.
+     */
+    void remove(uint64_t id);
+
+    /**
+     * @brief Forgets every entry.
+     */
+    void clear();
+
+    /**
+     * @brief Entries with a password that at least one other entry also uses.
+     */
+    bool isReused(uint64_t id) const;
+
+    /**
+     * @brief True if the entry has a password rated Weak or worse.
+     */
+    bool isWeak(uint64_t id) const;
+
+    /**
+     * @brief How many entries, this one included, use the entry's password.
+     * 0 for unknown entries and empty passwords.
+     */
+    size_t reuseCount(uint64_t id) const;
+
+    /**
+     * @brief The IDs of the entries using the same password as this one (itself included).
+     */
+    std::vector<uint64_t> sharingWith(uint64_t id) const;
+
+    /**
+     * @brief The entry's strength. VeryWeak for unknown entries and empty passwords.
+     */
+    Strength strength(uint64_t id) const;
+
+    size_t reusedCount() const; // Entries whose password is reused
+    size_t weakCount() const;   // Entries whose password is weak
+
+    /**
+     * @brief Rates a password by its estimated entropy: each character adds
+     * log2 of the size of the classes the password draws from, except one
+     * that repeats or continues a sequence (aaa, abc, 321), which adds 1 bit.
+     * Common passwords are always VeryWeak.
+     */
+    static Strength rate(std::string_view password);
+
+    static const char* label(Strength strength);
+
+private:
+    struct FingerprintHash {
+        size_t operator()(const Fingerprint& fingerprint) const; // Already uniform; uses its first bytes
+    };
+
+    static bool weak(Strength strength);
+
+    std::unordered_map<uint64_t, Summary> m_records;
+    std::unordered_map<Fingerprint, std::vector<uint64_t>, FingerprintHash> m_groups; // Only non-empty passwords
+    size_t m_reused = 0;
+    size_t m_weak = 0;
+};
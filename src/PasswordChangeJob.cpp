@@ -0,0 +1,84 @@
+#include "PasswordChangeJob.h"
+
+PasswordChangeJob::~PasswordChangeJob() {
+    cancel();
+    // A cancelled worker may still be inside crypto_pwhash; wait for it.
+    for (auto& worker : m_workers) {
+        worker.first.join();
+    }
+}
+
+void PasswordChangeJob::start(const Vault& vault, const std::string& currentPassword, const std::string& newPassword) {
+    if (status() == Status::Running) {
+        return;
+    }
+    reapFinished();
+
+    m_state = std::make_shared<State>();
+    m_started = std::chrono::steady_clock::now();
+    m_workers.emplace_back(std::thread(&PasswordChangeJob::run, m_state, vault.keyslots(), vault.entries().key(), currentPassword,
+                                       newPassword, vault.kdfParams(), m_notify), m_state);
+}
+
+void PasswordChangeJob::setNotifier(std::function<void()> notify) {
+    m_notify = std::move(notify);
+}
+
+void PasswordChangeJob::cancel() {
+    if (m_state) {
+        m_state->cancelled = true;
+        m_state.reset();
+    }
+}
+
+PasswordChangeJob::Status PasswordChangeJob::status() const {
+    return m_state ? m_state->status.load() : Status::Idle;
+}
+
+double PasswordChangeJob::elapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+}
+
+std::string PasswordChangeJob::error() const {
+    return m_state && m_state->status == Status::Failed ? m_state->error : std::string();
+}
+
+Crypto::Keyslot PasswordChangeJob::takeSlot() {
+    Crypto::Keyslot slot = std::move(m_state->slot);
+    m_state.reset();
+    return slot;
+}
+
+void PasswordChangeJob::reset() {
+    if (status() != Status::Running) {
+        m_state.reset();
+    }
+}
+
+void PasswordChangeJob::reapFinished() {
+    for (auto it = m_workers.begin(); it != m_workers.end();) {
+        if (it->second->status != Status::Running) {
+            it->first.join(); // Already past its last write, so this is immediate
+            it = m_workers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PasswordChangeJob::run(std::shared_ptr<State> state, std::vector<Crypto::Keyslot> slots, std::shared_ptr<const Crypto::KeyHandle> key,
+                            std::string currentPassword, std::string newPassword, Crypto::KdfParams kdf, std::function<void()> notify) {
+    // 1. Both derivations; the vault itself is only changed on the UI thread
+    std::optional<Crypto::Keyslot> slot;
+    if (key) {
+        slot = Vault::wrapNewPassword(slots, *key, currentPassword, newPassword, kdf);
+    }
+    Crypto::wipe(currentPassword);
+    Crypto::wipe(newPassword);
+
+    // 2. Publish the result. A cancelled job's slot is simply dropped with the state.
+    if (slot) state->slot = std::move(*slot);
+    state->error = state->cancelled ? "Password change cancelled." : "Wrong current password, or the new key couldn't be derived.";
+    state->status = slot && !state->cancelled ? Status::Succeeded : Status::Failed;
+    if (notify && !state->cancelled) notify();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Vault.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs the key derivations of a master password change on a
+ * background thread, so the render loop keeps drawing while Argon2id runs
+ * (see Vault::wrapNewPassword).
+ *
+ * As with UnlockJob, the UI thread calls start(), polls status() once per
+ * frame, and once it has Succeeded collects the new keyslot with takeSlot()
+ * and stores it with Vault::replacePasswordSlot(). The worker only reads its
+ * own copy of the slot table and the data key, never the live vault.
+ */
+class PasswordChangeJob {
+public:
+    enum class Status {
+        Idle,
+        Running,
+        Succeeded,
+        Failed
+    };
+
+    PasswordChangeJob() = default;
+    ~PasswordChangeJob();
+    PasswordChangeJob(const PasswordChangeJob&) = delete;
+    PasswordChangeJob& operator=(const PasswordChangeJob&) = delete;
+
+    /**
+     * @brief Starts checking `currentPassword` against the unlocked `vault`
+     * and wrapping its data key for `newPassword`, with the costs of its
+     * current password slot. Ignored while a job is already running.
+     */
+    void start(const Vault& vault, const std::string& currentPassword, const std::string& newPassword);
+
+    /**
+     * @brief Called on the worker thread when a job started after this
+     * finishes, unless it was cancelled, e.g. to wake a UI loop that is
+     * waiting for events.
+     */
+    void setNotifier(std::function<void()> notify);
+
+    /**
+     * @brief Abandons the running job and returns to Idle immediately.
+     * Key derivation itself can't be interrupted; the worker stops after the
+     * one it is in and its result is discarded.
+     */
+    void cancel();
+
+    Status status() const;
+
+    /**
+     * @brief Seconds since start(), for the progress display.
+     */
+    double elapsedSeconds() const;
+
+    /**
+     * @brief Why the job failed. Only meaningful when Failed.
+     */
+    std::string error() const;
+
+    /**
+     * @brief Hands the new password keyslot to the caller and returns to Idle.
+     * Only call when status() is Succeeded.
+     */
+    Crypto::Keyslot takeSlot();
+
+    /**
+     * @brief Acknowledges a failure and returns to Idle.
+     */
+    void reset();
+
+private:
+    // Everything the worker writes. Shared so a cancelled worker can finish
+    // on its own after the UI has moved on.
+    struct State {
+        std::atomic<Status> status{ Status::Running };
+        std::atomic<bool> cancelled{ false };
+
+        // Written by the worker before it publishes Succeeded/Failed in
+        // `status`; read by the UI thread only after seeing that.
+        Crypto::Keyslot slot;
+        std::string error;
+    };
+
+    static void run(std::shared_ptr<State> state, std::vector<Crypto::Keyslot> slots, std::shared_ptr<const Crypto::KeyHandle> key,
+                    std::string currentPassword, std::string newPassword, Crypto::KdfParams kdf, std::function<void()> notify);
+    void reapFinished();
+
+    std::shared_ptr<State> m_state;
+    std::chrono::steady_clock::time_point m_started;
+    std::function<void()> m_notify;
+
+    // Workers that were cancelled but may still be inside crypto_pwhash.
+    // Joined once they finish, or in the destructor.
+    std::vector<std::pair<std::thread, std::shared_ptr<State>>> m_workers;
+};
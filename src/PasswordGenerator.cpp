@@ -0,0 +1,240 @@
+#include "PasswordGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+#include <sodium.h>
+
+namespace {
+    using namespace PasswordGenerator;
+
+    // --- Compile-time charsets ---
+
+    struct CharsetTable {
+        char chars[UPPERCASE.size() + LOWERCASE.size() + NUMBERS.size() + SYMBOLS.size()] = {};
+        size_t size = 0;
+    };
+
+    constexpr std::array<CharsetTable, AllClasses + 1> buildCharsets() {
+        const std::string_view classes[] = { UPPERCASE, LOWERCASE, NUMBERS, SYMBOLS };
+        std::array<CharsetTable, AllClasses + 1> tables{};
+        for (unsigned mask = 0; mask <= AllClasses; ++mask) {
+            for (unsigned bit = 0; bit < 4; ++bit) {
+                if ((mask & (1u << bit)) == 0) continue;
+                for (char c : classes[bit]) {
+                    tables[mask].chars[tables[mask].size++] = c;
+                }
+            }
+        }
+        return tables;
+    }
+
+    constexpr std::array<CharsetTable, AllClasses + 1> CHARSETS = buildCharsets();
+    static_assert(CHARSETS[AllClasses].size == 88, "Character classes changed size");
+
+    // --- Randomness ---
+
+    const size_t MIN_BUFFER_BYTES = 64;
+    const size_t MAX_BUFFER_BYTES = 1 << 20; // Bigger batches refill it
+
+    // Hands out bytes of one randombytes_buf fill, refilling when they run
+    // out, and wipes them when done.
+    class RandomBuffer {
+    public:
+        explicit RandomBuffer(size_t expectedBytes)
+            : m_bytes(std::clamp(expectedBytes, MIN_BUFFER_BYTES, MAX_BUFFER_BYTES)) {
+            refill();
+        }
+
+        ~RandomBuffer() {
+            sodium_memzero(m_bytes.data(), m_bytes.size());
+        }
+
+        RandomBuffer(const RandomBuffer&) = delete;
+        RandomBuffer& operator=(const RandomBuffer&) = delete;
+
+        unsigned char byte() {
+            if (m_pos == m_bytes.size()) refill();
+            return m_bytes[m_pos++];
+        }
+
+        uint32_t u32() {
+            uint32_t v = 0;
+            for (int i = 0; i < 4; ++i) v = (v << 8) | byte();
+            return v;
+        }
+
+    private:
+        void refill() {
+            randombytes_buf(m_bytes.data(), m_bytes.size());
+            m_pos = 0;
+        }
+
+        std::vector<unsigned char> m_bytes;
+        size_t m_pos = 0;
+    };
+
+    // Rejection sampling: draws past the largest multiple of n that fits are
+    // thrown away, so `value % n` is exactly uniform.
+    size_t uniformByte(RandomBuffer& random, unsigned n) {
+        const unsigned limit = 256 - 256 % n;
+        unsigned value;
+        do {
+            value = random.byte();
+        } while (value >= limit);
+        return value % n;
+    }
+
+    size_t uniformU32(RandomBuffer& random, uint64_t n) {
+        const uint64_t range = 1ull << 32;
+        const uint64_t limit = range - range % n;
+        uint64_t value;
+        do {
+            value = random.u32();
+        } while (value >= limit);
+        return (size_t)(value % n);
+    }
+
+    // Bytes a batch of `draws` is expected to need, with some slack
+    size_t expectedBytes(size_t draws, size_t bytesPerDraw, double acceptRate) {
+        return (size_t)((double)draws * bytesPerDraw / acceptRate * 1.125);
+    }
+}
+
+unsigned PasswordGenerator::classMask(bool upper, bool lower, bool numbers, bool symbols) {
+    unsigned classes = 0;
+    if (upper) classes |= Upper;
+    if (lower) classes |= Lower;
+    if (numbers) classes |= Numbers;
+    if (symbols) classes |= Symbols;
+    return classes;
+}
+
+std::string_view PasswordGenerator::charset(unsigned classes) {
+    const CharsetTable& table = CHARSETS[classes & AllClasses];
+    return std::string_view(table.chars, table.size);
+}
+
+double PasswordGenerator::entropyBits(size_t alphabetSize, size_t symbols) {
+    return alphabetSize < 2 ? 0.0 : (double)symbols * std::log2((double)alphabetSize);
+}
+
+std::optional<PasswordGenerator::Batch> PasswordGenerator::generateBatch(std::string_view charset, size_t length, size_t count) {
+    // 1. The distinct bytes, in the order given
+    bool seen[256] = {};
+    std::string alphabet;
+    for (char c : charset) {
+        unsigned char byte = (unsigned char)c;
+        if (!seen[byte]) {
+            seen[byte] = true;
+            alphabet += c;
+        }
+    }
+    if (alphabet.empty() || length == 0) {
+        return std::nullopt;
+    }
+
+    // 2. Draw every character of the batch from one buffer
+    const unsigned n = (unsigned)alphabet.size();
+    RandomBuffer random(expectedBytes(count * length, 1, (256 - 256 % n) / 256.0));
+    Batch batch;
+    batch.passwords.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string password(length, '\0');
+        for (char& c : password) {
+            c = alphabet[uniformByte(random, n)];
+        }
+        batch.passwords.push_back(std::move(password));
+    }
+    batch.alphabetSize = n;
+    batch.entropyBits = entropyBits(n, length);
+    return batch;
+}
+
+std::optional<PasswordGenerator::Batch> PasswordGenerator::generatePassphrases(const std::vector<std::string>& words, size_t wordCount, std::string_view separator, size_t count) {
+    // 1. The distinct words, in the order given
+    std::vector<const std::string*> list;
+    std::unordered_set<std::string_view> seen;
+    for (const auto& word : words) {
+        if (!word.empty() && seen.insert(word).second) {
+            list.push_back(&word);
+        }
+    }
+    if (list.size() < 2 || list.size() > UINT32_MAX || wordCount == 0) {
+        return std::nullopt;
+    }
+
+    // 2. Draw every word of the batch from one buffer
+    const uint64_t n = list.size();
+    const double acceptRate = (double)((1ull << 32) - (1ull << 32) % n) / (double)(1ull << 32);
+    RandomBuffer random(expectedBytes(count * wordCount, 4, acceptRate));
+    Batch batch;
+    batch.passwords.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string passphrase;
+        for (size_t w = 0; w < wordCount; ++w) {
+            if (w > 0) passphrase += separator;
+            passphrase += *list[uniformU32(random, n)];
+        }
+        batch.passwords.push_back(std::move(passphrase));
+    }
+    batch.alphabetSize = list.size();
+    batch.entropyBits = entropyBits(list.size(), wordCount);
+    return batch;
+}
+
+const std::vector<std::string>& PasswordGenerator::defaultWordlist() {
+    static const std::vector<std::string> WORDS = {
+        "able", "acid", "aged", "also", "area", "army", "away", "baby", "back", "ball", "band", "bank", "base", "bath", "bear", "beat",
+        "bell", "belt", "bend", "bird", "blow", "blue", "boat", "body", "bone", "book", "boot", "born", "boss", "both", "bowl", "bulk",
+        "burn", "bush", "busy", "cake", "call", "calm", "camp", "card", "care", "cart", "case", "cash", "cast", "cell", "chef", "chip",
+        "city", "clay", "club", "coal", "coat", "code", "cold", "cook", "cool", "copy", "cord", "core", "corn", "cost", "crew", "crop",
+        "dark", "data", "date", "dawn", "deal", "deck", "deep", "deer", "desk", "dial", "diet", "dirt", "dish", "dock", "door", "dose",
+        "down", "draw", "drop", "drum", "duck", "dust", "duty", "each", "earn", "east", "easy", "edge", "else", "even", "exit", "face",
+        "fact", "fair", "fall", "farm", "fast", "fear", "feed", "feel", "file", "film", "find", "fine", "fire", "firm", "fish", "five",
+        "flag", "flat", "flow", "folk", "food", "foot", "form", "fort", "four", "free", "frog", "fuel", "full", "fund", "gain", "game",
+        "gate", "gear", "gift", "girl", "give", "glad", "glow", "goal", "gold", "golf", "good", "gown", "grab", "gray", "grid", "grow",
+        "gulf", "hair", "half", "hall", "hand", "hang", "hard", "harm", "hawk", "head", "heap", "heat", "help", "herb", "hero", "high",
+        "hike", "hill", "hint", "hold", "hole", "home", "hook", "hope", "horn", "host", "hour", "huge", "hunt", "idea", "inch", "iron",
+        "item", "jade", "jazz", "join", "joke", "jump", "jury", "keen", "keep", "kick", "kind", "king", "kite", "knee", "knot", "lake",
+        "lamp", "land", "lane", "last", "late", "lawn", "lead", "leaf", "lean", "left", "lens", "life", "lift", "like", "lime", "line",
+        "link", "lion", "list", "load", "loan", "lock", "loft", "long", "loop", "lord", "lose", "loud", "love", "luck", "lung", "made",
+        "mail", "main", "make", "mall", "many", "mark", "mask", "mast", "math", "meal", "meet", "melt", "menu", "mild", "milk", "mill",
+        "mind", "mint", "miss", "mode", "mole", "moon", "more", "moss", "most", "moth", "move", "much", "mule", "nail", "name", "navy",
+    };
+    return WORDS;
+}
+
+std::optional<std::vector<std::string>> PasswordGenerator::loadWordlist(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> words;
+    std::string line;
+    while (std::getline(file, line)) {
+        // The last whitespace-separated column, so dice lists work as is
+        std::istringstream columns(line);
+        std::string word, column;
+        while (columns >> column) word = column;
+        if (!word.empty()) words.push_back(word);
+    }
+    if (words.empty()) {
+        return std::nullopt;
+    }
+    return words;
+}
+
+std::string PasswordGenerator::generate(int length, bool useUpper, bool useLower, bool useNumbers, bool useSymbols) {
+    auto batch = generateBatch(charset(classMask(useUpper, useLower, useNumbers, useSymbols)), (size_t)std::max(length, 0), 1);
+    if (!batch) {
+        return "Invalid settings";
+    }
+    return std::move(batch->passwords.front());
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Random password and passphrase generation, shared by the app, the
+ * CLI and the benchmarks.
+ *
+ * Every batch draws from one buffer of libsodium randomness (refilled only
+ * if rejections run it dry) and maps it onto the alphabet by rejection
+ * sampling, so each character or word is exactly uniform. The entropy
+ * reported is that of the process: symbols * log2(alphabet size).
+ */
+namespace PasswordGenerator {
+
+    // --- Character classes ---
+    // The class tables, and the charset of every combination of them, are
+    // built at compile time.
+
+    constexpr std::string_view UPPERCASE = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    constexpr std::string_view LOWERCASE = "abcdefghijklmnopqrstuvwxyz";
+    constexpr std::string_view NUMBERS = "0123456789";
+    constexpr std::string_view SYMBOLS = "!@#$%^&*()_+-=[]{};:,.<>/?";
+
+    enum Class : unsigned {
+        Upper = 1,
+        Lower = 2,
+        Numbers = 4,
+        Symbols = 8,
+        AllClasses = Upper | Lower | Numbers | Symbols
+    };
+
+    /**
+     * @brief The Class mask of the given selection.
+     */
+    unsigned classMask(bool upper, bool lower, bool numbers, bool symbols);
+
+    /**
+     * @brief The characters of the selected classes (a mask of Class), in the
+     * order above. Empty if none is selected.
+     */
+    std::string_view charset(unsigned classes);
+
+    struct Batch {
+        std::vector<std::string> passwords;
+        size_t alphabetSize = 0;  // Distinct characters, or words, drawn from
+        double entropyBits = 0.0; // Of each password
+    };
+
+    /**
+     * @brief `count` passwords of `length` characters drawn from `charset`.
+     * A custom charset is treated as a set of bytes: repeats are dropped (they
+     * would bias the draw), and multi-byte UTF-8 characters aren't supported.
+     * @return std::nullopt if the charset is empty or the length is zero.
+     */
+    std::optional<Batch> generateBatch(std::string_view charset, size_t length, size_t count);
+
+    /**
+     * @brief `count` passphrases of `wordCount` words from `words` (repeats
+     * dropped), joined by `separator`.
+     * @return std::nullopt if there are fewer than two distinct words or wordCount is zero.
+     */
+    std::optional<Batch> generatePassphrases(const std::vector<std::string>& words, size_t wordCount, std::string_view separator, size_t count);
+
+    /**
+     * @brief The built-in list of 256 short words (8 bits each). A larger list
+     * from loadWordlist, such as the EFF's 7776 words, gives more per word.
+     */
+    const std::vector<std::string>& defaultWordlist();
+
+    /**
+     * @brief Reads one word per line. Lines like "11111<TAB>word" (dice
+     * lists) keep their last column; blank lines are skipped.
+     * @return std::nullopt if the file can't be read or has no words.
+     */
+    std::optional<std::vector<std::string>> loadWordlist(const std::string& path);
+
+    /**
+     * @brief Bits of entropy of `symbols` uniform picks from `alphabetSize` choices.
+     */
+    double entropyBits(size_t alphabetSize, size_t symbols);
+
+    /**
+     * @brief One password from the selected character classes.
+     * @return The password, or "Invalid settings" if no class is selected.
+     */
+    std::string generate(int length, bool useUpper, bool useLower, bool useNumbers, bool useSymbols);
+
+} // namespace PasswordGenerator
@@ -0,0 +1,180 @@
+#include "SearchIndex.h"
+#include "EntryStore.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string_view>
+
+namespace {
+    // Tombstones tolerated before remove() compacts, on top of one per live document
+    const size_t MIN_DEAD_TO_COMPACT = 1024;
+
+    // Joins the fields of a document. Never appears in a query term, so
+    // trigrams containing it are skipped and matches can't span two fields.
+    const char FIELD_SEPARATOR = '\x1f';
+
+    void appendLower(std::string& out, std::string_view field) {
+        for (char c : field) {
+            out.push_back((char)std::tolower((unsigned char)c));
+        }
+    }
+
+    uint32_t trigramAt(const std::string& text, size_t i) {
+        return ((uint32_t)(unsigned char)text[i] << 16) |
+               ((uint32_t)(unsigned char)text[i + 1] << 8) |
+               (uint32_t)(unsigned char)text[i + 2];
+    }
+}
+
+std::string SearchIndex::normalize(EntryRef entry) {
+    std::string text;
+    text.reserve(entry.title().size() + entry.username().size() + entry.url().size() + 2);
+    appendLower(text, entry.title());
+    text.push_back(FIELD_SEPARATOR);
+    appendLower(text, entry.username());
+    text.push_back(FIELD_SEPARATOR);
+    appendLower(text, entry.url());
+    return text;
+}
+
+std::vector<uint32_t> SearchIndex::trigramsOf(const std::string& text) {
+    std::vector<uint32_t> trigrams;
+    if (text.size() < 3) {
+        return trigrams;
+    }
+    trigrams.reserve(text.size() - 2);
+    for (size_t i = 0; i + 2 < text.size(); ++i) {
+        if (text[i] == FIELD_SEPARATOR || text[i + 1] == FIELD_SEPARATOR || text[i + 2] == FIELD_SEPARATOR) {
+            continue;
+        }
+        trigrams.push_back(trigramAt(text, i));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+void SearchIndex::add(EntryRef entry) {
+    remove(entry.id());
+    addDocument(entry.id(), normalize(entry));
+}
+
+void SearchIndex::addDocument(uint64_t id, std::string text) {
+    // New documents always get the next number, so adding one only ever
+    // appends to the (sorted) posting lists
+    uint32_t doc = (uint32_t)m_docs.size();
+    m_docs.push_back(Document{ id, std::move(text) });
+    m_live.push_back(true);
+    m_idToDoc[id] = doc;
+
+    for (uint32_t trigram : trigramsOf(m_docs[doc].text)) {
+        m_postings[trigram].push_back(doc);
+    }
+}
+
+void SearchIndex::remove(uint64_t id) {
+    auto it = m_idToDoc.find(id);
+    if (it == m_idToDoc.end()) {
+        return;
+    }
+    uint32_t doc = it->second;
+    m_idToDoc.erase(it);
+
+    // Erasing from the posting lists of common trigrams ("com", "www") would
+    // mean shifting ~every document each time. Leave a tombstone that queries
+    // skip, and drop them all at once when they pile up.
+    m_docs[doc].text.clear();
+    m_docs[doc].text.shrink_to_fit();
+    m_live[doc] = false;
+    ++m_deadDocs;
+    if (m_deadDocs > MIN_DEAD_TO_COMPACT && m_deadDocs > m_idToDoc.size()) {
+        compact();
+    }
+}
+
+void SearchIndex::compact() {
+    std::vector<Document> docs;
+    docs.reserve(m_idToDoc.size());
+    for (uint32_t doc = 0; doc < m_docs.size(); ++doc) {
+        if (m_live[doc]) docs.push_back(std::move(m_docs[doc]));
+    }
+
+    clear();
+    for (auto& doc : docs) {
+        addDocument(doc.id, std::move(doc.text));
+    }
+}
+
+void SearchIndex::clear() {
+    m_docs.clear();
+    m_live.clear();
+    m_deadDocs = 0;
+    m_idToDoc.clear();
+    m_postings.clear();
+}
+
+size_t SearchIndex::size() const {
+    return m_idToDoc.size();
+}
+
+std::vector<uint64_t> SearchIndex::query(const std::string& text) const {
+    std::vector<uint64_t> results;
+
+    // 1. Split into lowercase terms
+    std::vector<std::string> terms;
+    std::istringstream stream(text);
+    std::string term;
+    while (stream >> term) {
+        std::string lower;
+        appendLower(lower, term);
+        terms.push_back(std::move(lower));
+    }
+    if (terms.empty()) {
+        return results;
+    }
+
+    // 2. Collect the posting lists of every trigram of every term. A missing
+    // trigram means nothing can match.
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (const auto& t : terms) {
+        for (uint32_t trigram : trigramsOf(t)) {
+            auto it = m_postings.find(trigram);
+            if (it == m_postings.end()) {
+                return results;
+            }
+            lists.push_back(&it->second);
+        }
+    }
+
+    // 3. Candidates: the intersection of those lists, smallest first. Terms
+    // shorter than three characters add no lists; with only those, every
+    // document is a candidate. Deleted documents are still in the lists.
+    std::vector<uint32_t> candidates;
+    if (lists.empty()) {
+        candidates.resize(m_docs.size());
+        for (uint32_t doc = 0; doc < m_docs.size(); ++doc) candidates[doc] = doc;
+    } else {
+        std::sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+        candidates = *lists[0];
+        std::vector<uint32_t> next;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            next.clear();
+            std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+            candidates.swap(next);
+        }
+    }
+
+    // 4. Confirm each term really occurs (trigrams can match out of order)
+    for (uint32_t doc : candidates) {
+        if (!m_live[doc]) continue;
+        const std::string& docText = m_docs[doc].text;
+        bool all = std::all_of(terms.begin(), terms.end(), [&](const std::string& t) {
+            return docText.find(t) != std::string::npos;
+        });
+        if (all) {
+            results.push_back(m_docs[doc].id);
+        }
+    }
+    return results;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class EntryRef;
+
+/**
+ * @brief An incrementally maintained trigram index over the plaintext fields
+ * of every entry (title, username, url). Notes are sealed with the password
+ * (see EntryStore) and stay out of the index.
+ *
+ * Each entry is stored once, lowercased, as a "document". Every 3-byte
+ * substring of a document maps to a sorted list of the documents containing
+ * it, so a query only has to look at documents that contain all of its
+ * trigrams, then confirms the real substring match on those.
+ *
+ * Matching is case-insensitive (ASCII) and never spans two fields.
+ */
+class SearchIndex {
+public:
+    /**
+     * @brief Indexes an entry, replacing any previous version with the same ID.
+     */
+    void add(EntryRef entry);
+
+    /**
+     * @brief Removes an entry from the index. Unknown IDs are ignored.
+     */
+    void remove(uint64_t id);
+
+    void clear();
+
+    /**
+     * @brief Finds entries matching every whitespace-separated term of the query
+     * as a substring of some field. An empty query matches nothing.
+     * @return Matching entry IDs, in no particular order.
+     */
+    std::vector<uint64_t> query(const std::string& text) const;
+
+    size_t size() const;
+
+private:
+    struct Document {
+        uint64_t id;
+        std::string text; // Lowercased fields joined by FIELD_SEPARATOR
+    };
+
+    void addDocument(uint64_t id, std::string text);
+    void compact(); // Renumbers the live documents and rebuilds the posting lists
+
+    static std::string normalize(EntryRef entry);
+    static std::vector<uint32_t> trigramsOf(const std::string& text);
+
+    std::vector<Document> m_docs; // Indexed by document number
+    std::vector<bool> m_live;     // False for removed documents (tombstones)
+    size_t m_deadDocs = 0;
+    std::unordered_map<uint64_t, uint32_t> m_idToDoc;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings; // trigram -> sorted document numbers
+};
@@ -0,0 +1,159 @@
+#include "SecurePool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <sodium.h>
+
+namespace {
+    const size_t MIN_BLOCK_BYTES = 16;
+
+    // sodium_malloc puts the block at the very end of its pages, so it's only
+    // aligned if the size is a multiple of the alignment
+    size_t roundUp(size_t size) {
+        return (size + MIN_BLOCK_BYTES - 1) & ~(MIN_BLOCK_BYTES - 1);
+    }
+}
+
+SecurePool::~SecurePool() {
+    for (auto& entry : m_slabs) {
+        sodium_free(entry.second.base);
+    }
+}
+
+SecurePool& SecurePool::shared() {
+    static SecurePool* pool = new SecurePool();
+    return *pool;
+}
+
+size_t SecurePool::classOf(size_t size) {
+    size_t index = 0;
+    for (size_t blockSize = MIN_BLOCK_BYTES; blockSize < size; blockSize <<= 1) {
+        ++index;
+    }
+    return index;
+}
+
+SecurePool::Slab* SecurePool::slabOf(const void* block) {
+    // The last slab starting at or before the block
+    auto it = m_slabs.upper_bound((uintptr_t)block);
+    if (it == m_slabs.begin()) {
+        return nullptr;
+    }
+    --it;
+    Slab& slab = it->second;
+    return (const unsigned char*)block < slab.base + SLAB_BYTES ? &slab : nullptr;
+}
+
+void* SecurePool::allocate(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+
+    // 1. Large blocks get guard pages of their own
+    if (size > MAX_BLOCK_BYTES) {
+        void* block = sodium_malloc(roundUp(size));
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_largeBlocks;
+        m_largeBytes += roundUp(size);
+        return block;
+    }
+
+    size_t index = classOf(size);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 2. Take a slab of this class with room, or make one
+    if (m_partial[index].empty()) {
+        auto* base = (unsigned char*)sodium_malloc(SLAB_BYTES);
+        if (base == nullptr) {
+            throw std::bad_alloc();
+        }
+        // sodium_malloc fills new memory with garbage; blocks start zeroed
+        sodium_memzero(base, SLAB_BYTES);
+        Slab slab;
+        slab.base = base;
+        slab.blockSize = MIN_BLOCK_BYTES << index;
+        slab.blocks = SLAB_BYTES / slab.blockSize;
+        m_partial[index].push_back(&m_slabs.emplace((uintptr_t)base, slab).first->second);
+    }
+    Slab& slab = *m_partial[index].back();
+
+    // 3. Reuse a freed block, else the next untouched one
+    unsigned char* block;
+    if (slab.freeList != nullptr) {
+        block = (unsigned char*)slab.freeList;
+        std::memcpy(&slab.freeList, block, sizeof(void*));
+        std::memset(block, 0, sizeof(void*));
+    } else {
+        block = slab.base + slab.bumped * slab.blockSize;
+        ++slab.bumped;
+    }
+    ++slab.live;
+    m_bytesInUse += slab.blockSize;
+    if (slab.live == slab.blocks) {
+        m_partial[index].pop_back();
+    }
+    return block;
+}
+
+void SecurePool::deallocate(void* block, size_t size) {
+    if (block == nullptr) {
+        return;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+
+    if (size > MAX_BLOCK_BYTES) {
+        sodium_free(block); // Wipes it
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_largeBlocks;
+        m_largeBytes -= roundUp(size);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Slab* slab = slabOf(block);
+    if (slab == nullptr) {
+        return; // Not ours; nothing sensible to do
+    }
+
+    // Wipe the whole block, not just `size`: it may have held a longer string before
+    sodium_memzero(block, slab->blockSize);
+    std::memcpy(block, &slab->freeList, sizeof(void*));
+    slab->freeList = block;
+    if (slab->live == slab->blocks) {
+        m_partial[classOf(slab->blockSize)].push_back(slab);
+    }
+    --slab->live;
+    m_bytesInUse -= slab->blockSize;
+}
+
+void SecurePool::trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_slabs.begin(); it != m_slabs.end();) {
+        Slab& slab = it->second;
+        if (slab.live > 0) {
+            ++it;
+            continue;
+        }
+        auto& partial = m_partial[classOf(slab.blockSize)];
+        partial.erase(std::remove(partial.begin(), partial.end(), &slab), partial.end());
+        sodium_free(slab.base);
+        it = m_slabs.erase(it);
+    }
+}
+
+SecurePool::Stats SecurePool::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.slabs = m_slabs.size();
+    stats.slabBytes = m_slabs.size() * SLAB_BYTES;
+    stats.largeBlocks = m_largeBlocks;
+    stats.largeBytes = m_largeBytes;
+    stats.bytesInUse = m_bytesInUse;
+    return stats;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Guarded, locked memory for many small plaintext allocations.
+ *
+ * sodium_malloc gives every allocation its own guard pages and locked pages,
+ * which costs a few system calls and at least three pages each: fine for a
+ * key, far too slow for every string of every entry. This pool carves small
+ * blocks out of a few large sodium_malloc'd slabs instead, so they share the
+ * slab's guard pages and mlock:
+ *
+ *   size classes   16, 32, ... 4096 bytes; each slab holds one class
+ *   slabs          256 KiB each, from sodium_malloc (guard pages, mlock
+ *                  where the OS allows it)
+ *   larger         their own sodium_malloc, as before
+ *
+ * Every block is zeroed when it is freed, so free memory never holds
+ * plaintext, and trim() hands empty slabs back (sodium_free wipes them too).
+ * Safe to use from several threads at once.
+ */
+class SecurePool {
+public:
+    SecurePool() = default;
+    ~SecurePool();
+    SecurePool(const SecurePool&) = delete;
+    SecurePool& operator=(const SecurePool&) = delete;
+
+    /**
+     * @brief At least `size` bytes, aligned to 16.
+     * Throws std::bad_alloc if no secure memory can be had.
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Wipes and frees a block. `size` must be what was passed to allocate().
+     */
+    void deallocate(void* block, size_t size);
+
+    /**
+     * @brief Frees the slabs nothing is allocated from anymore, e.g. on lock.
+     */
+    void trim();
+
+    struct Stats {
+        size_t slabs = 0;
+        size_t slabBytes = 0;     // Held in slabs, used or not
+        size_t largeBlocks = 0;   // Allocations with their own sodium_malloc
+        size_t largeBytes = 0;
+        size_t bytesInUse = 0;    // Handed out, rounded up to the size class
+    };
+    Stats stats() const;
+
+    /**
+     * @brief The process-wide pool, used by SecureAllocator. Never destroyed,
+     * so objects with static storage can still free into it at exit.
+     */
+    static SecurePool& shared();
+
+    static const size_t SLAB_BYTES = 256 * 1024;
+    static const size_t MAX_BLOCK_BYTES = 4096; // Larger goes straight to sodium_malloc
+
+private:
+    static const size_t CLASS_COUNT = 9; // 16 << 0 .. 16 << 8
+
+    struct Slab {
+        unsigned char* base;
+        size_t blockSize;
+        size_t blocks;       // SLAB_BYTES / blockSize
+        size_t bumped = 0;   // Blocks handed out at least once; the rest are untouched
+        size_t live = 0;
+        void* freeList = nullptr; // Freed blocks, linked through their first bytes
+    };
+
+    static size_t classOf(size_t size);
+    Slab* slabOf(const void* block);
+
+    mutable std::mutex m_mutex;
+    std::map<uintptr_t, Slab> m_slabs;                   // By base address, for slabOf()
+    std::array<std::vector<Slab*>, CLASS_COUNT> m_partial; // Slabs with a free block, per class
+    size_t m_largeBlocks = 0;
+    size_t m_largeBytes = 0;
+    size_t m_bytesInUse = 0;
+};
+
+/**
+ * @brief A standard allocator over SecurePool::shared(), for containers that
+ * hold plaintext.
+ */
+template <typename T>
+struct SecureAllocator {
+    using value_type = T;
+
+    SecureAllocator() = default;
+    template <typename U>
+    SecureAllocator(const SecureAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(SecurePool::shared().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        SecurePool::shared().deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const SecureAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const SecureAllocator<U>&) const { return false; }
+};
+
+// Strings and byte buffers whose contents never touch the ordinary heap
+using SecureString = std::basic_string<char, std::char_traits<char>, SecureAllocator<char>>;
+using SecureBytes = std::vector<unsigned char, SecureAllocator<unsigned char>>;
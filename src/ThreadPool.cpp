@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t workers) {
+    m_workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::concurrency() const {
+    return m_workers.size() + 1;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return; // Stopping, and nothing left to do
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    // Helpers and the caller claim indices from a shared counter until none are
+    // left. A helper that only gets to run after everything is done just exits,
+    // so the caller never has to wait for the queue to drain.
+    struct Job {
+        const std::function<void(size_t)>* fn;
+        size_t count;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+
+    auto work = [job] {
+        size_t completed = 0;
+        for (size_t i = job->next++; i < job->count; i = job->next++) {
+            try {
+                (*job->fn)(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (!job->error) job->error = std::current_exception();
+            }
+            ++completed;
+        }
+        if (completed > 0 && (job->done += completed) == job->count) {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->finished.notify_all();
+        }
+    };
+
+    // 1. Wake as many workers as there is work for
+    size_t helpers = std::min(m_workers.size(), count - 1);
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < helpers; ++i) {
+                m_tasks.push(work);
+            }
+        }
+        m_wake.notify_all();
+    }
+
+    // 2. Work alongside them, then wait for their last items
+    work();
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&] { return job->done == job->count; });
+    }
+
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads for splitting CPU-bound work (chunked
+ * encryption, bulk parsing) across cores.
+ *
+ * The calling thread always takes part in parallelFor(), so a pool with N
+ * workers runs up to N + 1 items at once, and a pool with 0 workers simply
+ * runs everything on the caller.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param workers Number of worker threads to start.
+     */
+    explicit ThreadPool(size_t workers);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Calls fn(i) for every i in [0, count), spread over the pool and the
+     * calling thread, and returns once all calls have finished. Safe to call
+     * from several threads at once. If a call throws, the first exception is
+     * rethrown here after the rest have finished.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    /**
+     * @brief Threads parallelFor() can use: the workers plus the caller.
+     */
+    size_t concurrency() const;
+
+    /**
+     * @brief The process-wide pool, with one thread per core (counting the caller).
+     */
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::queue<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+};
@@ -0,0 +1,107 @@
+#include "UnlockJob.h"
+#include "Crypto.h"
+
+#include <fstream>
+
+UnlockJob::~UnlockJob() {
+    cancel();
+    // A cancelled worker may still be inside crypto_pwhash; wait for it.
+    for (auto& worker : m_workers) {
+        worker.first.join();
+    }
+}
+
+void UnlockJob::start(const std::string& filepath, const std::string& password) {
+    if (status() == Status::Running) {
+        return;
+    }
+    reapFinished();
+
+    m_state = std::make_shared<State>();
+    m_started = std::chrono::steady_clock::now();
+    m_workers.emplace_back(std::thread(&UnlockJob::run, m_state, filepath, password, m_notify), m_state);
+}
+
+void UnlockJob::setNotifier(std::function<void()> notify) {
+    m_notify = std::move(notify);
+}
+
+void UnlockJob::cancel() {
+    if (m_state) {
+        m_state->cancelled = true;
+        m_state.reset();
+    }
+}
+
+UnlockJob::Status UnlockJob::status() const {
+    return m_state ? m_state->status.load() : Status::Idle;
+}
+
+Vault::LoadPhase UnlockJob::phase() const {
+    return m_state ? m_state->phase.load() : Vault::LoadPhase::ReadingFile;
+}
+
+double UnlockJob::elapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+}
+
+bool UnlockJob::createdNewVault() const {
+    return m_state && m_state->status == Status::Succeeded && m_state->createdNew;
+}
+
+std::string UnlockJob::error() const {
+    return m_state && m_state->status == Status::Failed ? m_state->error : std::string();
+}
+
+Vault UnlockJob::takeVault() {
+    Vault vault = std::move(m_state->vault);
+    m_state.reset();
+    return vault;
+}
+
+void UnlockJob::reset() {
+    if (status() != Status::Running) {
+        m_state.reset();
+    }
+}
+
+void UnlockJob::reapFinished() {
+    for (auto it = m_workers.begin(); it != m_workers.end();) {
+        if (it->second->status != Status::Running) {
+            it->first.join(); // Already past its last write, so this is immediate
+            it = m_workers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void UnlockJob::run(std::shared_ptr<State> state, std::string filepath, std::string password, std::function<void()> notify) {
+    Vault vault;
+    bool ok = false;
+    std::string error;
+
+    // 1. No file yet means a brand-new vault: only its key needs deriving,
+    // with parameters tuned to this machine
+    bool exists = std::ifstream(filepath).good();
+    if (!exists) {
+        state->phase = Vault::LoadPhase::DerivingKey;
+        ok = vault.setMasterPassword(password, Crypto::calibrateKdf());
+        if (!ok) error = "Failed to derive vault key.";
+    } else {
+        // 2. Otherwise load it, stopping at the next phase boundary if cancelled
+        ok = vault.load(filepath, password, [&state](Vault::LoadPhase phase) {
+            state->phase = phase;
+            return !state->cancelled;
+        });
+        if (!ok) error = "Wrong password or corrupt vault file.";
+    }
+    Crypto::wipe(password);
+
+    // 3. Publish the result. A cancelled job's vault is simply dropped with the state.
+    state->vault = std::move(vault);
+    state->createdNew = !exists;
+    state->error = state->cancelled ? "Unlock cancelled." : error;
+    state->status = ok && !state->cancelled ? Status::Succeeded : Status::Failed;
+    if (notify && !state->cancelled) notify();
+}
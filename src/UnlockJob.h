@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Vault.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs Vault::load (or new-vault key derivation) on a background thread
+ * so the render loop keeps drawing while Argon2id runs.
+ *
+ * The UI thread calls start(), polls status()/phase() once per frame, and
+ * collects the result with takeVault() once it has Succeeded. The worker only
+ * ever touches its own Vault, so no locking is needed on the live one.
+ */
+class UnlockJob {
+public:
+    enum class Status {
+        Idle,
+        Running,
+        Succeeded,
+        Failed
+    };
+
+    UnlockJob() = default;
+    ~UnlockJob();
+    UnlockJob(const UnlockJob&) = delete;
+    UnlockJob& operator=(const UnlockJob&) = delete;
+
+    /**
+     * @brief Starts unlocking `filepath` in the background. If the file doesn't
+     * exist, derives a key for a new vault instead.
+     * Ignored while a job is already running.
+     */
+    void start(const std::string& filepath, const std::string& password);
+
+    /**
+     * @brief Called on the worker thread when a job started after this
+     * finishes, unless it was cancelled, e.g. to wake a UI loop that is
+     * waiting for events.
+     */
+    void setNotifier(std::function<void()> notify);
+
+    /**
+     * @brief Abandons the running job and returns to Idle immediately.
+     * Key derivation itself can't be interrupted; the worker stops at the next
+     * phase boundary and its result is discarded.
+     */
+    void cancel();
+
+    Status status() const;
+
+    /**
+     * @brief The phase the worker is in. Only meaningful while Running.
+     */
+    Vault::LoadPhase phase() const;
+
+    /**
+     * @brief Seconds since start(), for the "deriving key" display.
+     */
+    double elapsedSeconds() const;
+
+    /**
+     * @brief True if the job created a new vault because the file didn't exist.
+     */
+    bool createdNewVault() const;
+
+    /**
+     * @brief Why the job failed. Only meaningful when Failed.
+     */
+    std::string error() const;
+
+    /**
+     * @brief Hands the unlocked vault to the caller and returns to Idle.
+     * Only call when status() is Succeeded.
+     */
+    Vault takeVault();
+
+    /**
+     * @brief Acknowledges a failure and returns to Idle.
+     */
+    void reset();
+
+private:
+    // Everything the worker writes. Shared so a cancelled worker can finish
+    // on its own after the UI has moved on.
+    struct State {
+        std::atomic<Status> status{ Status::Running };
+        std::atomic<Vault::LoadPhase> phase{ Vault::LoadPhase::ReadingFile };
+        std::atomic<bool> cancelled{ false };
+
+        // Written by the worker before it publishes Succeeded/Failed in
+        // `status`; read by the UI thread only after seeing that.
+        Vault vault;
+        bool createdNew = false;
+        std::string error;
+    };
+
+    static void run(std::shared_ptr<State> state, std::string filepath, std::string password, std::function<void()> notify);
+    void reapFinished();
+
+    std::shared_ptr<State> m_state;
+    std::chrono::steady_clock::time_point m_started;
+    std::function<void()> m_notify;
+
+    // Workers that were cancelled but may still be inside crypto_pwhash.
+    // Joined once they finish, or in the destructor.
+    std::vector<std::pair<std::thread, std::shared_ptr<State>>> m_workers;
+};
@@ -1,11 +1,20 @@
 #include "Vault.h"
+#include "AttachmentStore.h"
 #include "Crypto.h" // Our crypto class
+#include "Diagnostics.h"
+#include "EntryCodec.h"
+#include "MappedFile.h"
 
 // Include the nlohmann JSON library
 #include "nlohmann/json.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>   // For file reading/writing
 #include <iostream>  // For error logging
+#include <unordered_map>
+#include <utility>
 
 // Use the json alias
 using json = nlohmann::json;
@@ -21,7 +30,22 @@ void to_json(json& j, const PasswordEntry& p) {
         {"username", p.username},
         {"password", p.password},
         {"url", p.url},
-        {"notes", p.notes}
+        {"notes", p.notes},
+        {"modified", p.modified}
+    };
+}
+
+void to_json(json& j, const EntryRef& p) {
+    // Decrypts the secrets; the JSON copy is as sensitive as they are
+    std::optional<EntrySecrets> secrets = p.secrets();
+    j = json{
+        {"id", p.id()},
+        {"title", p.title()},
+        {"username", p.username()},
+        {"password", secrets ? std::string_view(secrets->password) : std::string_view()},
+        {"url", p.url()},
+        {"notes", secrets ? std::string_view(secrets->notes) : std::string_view()},
+        {"modified", p.modified()}
     };
 }
 
@@ -32,104 +56,1109 @@ void from_json(const json& j, PasswordEntry& p) {
     j.at("password").get_to(p.password);
     j.at("url").get_to(p.url);
     j.at("notes").get_to(p.notes);
+    // Older vaults don't record it; the id is the creation time, so use that
+    p.modified = j.value("modified", p.id);
 }
 // --- End of JSON Serialization ---
 
 
-bool Vault::load(const std::string& filepath, const std::string& password) {
-    // 1. Read the raw encrypted bytes from the file
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file) {
+namespace {
+    // How many superseded records the log may carry beyond the live entry
+    // count before save() compacts instead of appending.
+    const size_t COMPACTION_SLACK = 256;
+
+    // Shared by every Vault, so revision() values never repeat between vaults
+    std::atomic<uint64_t> g_lastRevision{ 0 };
+
+    uint64_t nextRevision() {
+        return ++g_lastRevision;
+    }
+
+    // Record payloads are binary (EntryCodec); vaults written before that used
+    // JSON, which we still read. Each returns std::nullopt if it won't parse.
+    // The payload is read in place, wherever it lives; a snapshot goes
+    // straight into the store's columns.
+    bool parseEntries(std::string_view payload, EntryStore& entries) {
+        if (EntryCodec::isBinary(payload)) {
+            Diagnostics::ScopedTimer timer("parse.codec", payload.size());
+            return EntryCodec::decodeEntries(payload, entries);
+        }
+        Diagnostics::ScopedTimer timer("parse.json", payload.size());
+        try {
+            auto parsed = json::parse(payload.begin(), payload.end()).get<std::vector<PasswordEntry>>();
+            entries.clear();
+            entries.reserve(parsed.size());
+            for (auto& entry : parsed) {
+                entries.append(entry);
+                Crypto::wipe(entry.password);
+                Crypto::wipe(entry.notes);
+            }
+            return true;
+        }
+        catch (const json::exception&) {
+            return false;
+        }
+    }
+
+    // Leaves the one entry in `entry`, a scratch store reused across records
+    bool parseEntry(std::string_view payload, EntryStore& entry) {
+        if (EntryCodec::isBinary(payload)) {
+            return EntryCodec::decodeEntry(payload, entry);
+        }
+        try {
+            PasswordEntry parsed = json::parse(payload.begin(), payload.end()).get<PasswordEntry>();
+            entry.clear();
+            entry.append(parsed);
+            Crypto::wipe(parsed.password);
+            Crypto::wipe(parsed.notes);
+            return true;
+        }
+        catch (const json::exception&) {
+            return false;
+        }
+    }
+
+    std::optional<uint64_t> parseId(std::string_view payload) {
+        if (EntryCodec::isBinary(payload)) {
+            return EntryCodec::decodeId(payload);
+        }
+        try {
+            return json::parse(payload.begin(), payload.end()).get<uint64_t>();
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    // A recovery key is 160 random bits, so guessing it is hopeless at any cost;
+    // the KDF only needs to be cheap.
+    Crypto::KdfParams recoveryKdf() {
+        Crypto::KdfParams kdf;
+        kdf.opsLimit = 1;
+        kdf.memLimit = 8ull << 20;
+        return kdf;
+    }
+
+    // Tries every slot `secret` could open. Recovery slots are only tried when
+    // it has the shape of a recovery key, so a wrong password costs one
+    // derivation per password slot.
+    std::optional<Crypto::KeyHandle> unwrapAny(const std::vector<Crypto::Keyslot>& slots, const std::string& secret) {
+        std::optional<std::string> recoveryKey = Crypto::normalizeRecoveryKey(secret);
+        for (const auto& slot : slots) {
+            std::optional<Crypto::KeyHandle> key;
+            if (slot.kind == Crypto::Keyslot::Kind::Password) {
+                key = Crypto::KeyHandle::unwrap(slot, secret);
+            } else if (slot.kind == Crypto::Keyslot::Kind::Recovery && recoveryKey) {
+                key = Crypto::KeyHandle::unwrap(slot, *recoveryKey);
+            }
+            if (key) {
+                if (recoveryKey) Crypto::wipe(*recoveryKey);
+                return key;
+            }
+        }
+        if (recoveryKey) Crypto::wipe(*recoveryKey);
+        return std::nullopt;
+    }
+
+    std::optional<size_t> freeKeyslot(const std::vector<Crypto::Keyslot>& slots) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].kind == Crypto::Keyslot::Kind::Empty) return i;
+        }
+        return std::nullopt;
+    }
+
+    uint64_t nowMillis() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+bool Vault::load(const std::string& filepath, const std::string& password, const LoadProgress& progress) {
+    auto enter = [&](LoadPhase phase) { return !progress || progress(phase); };
+    Diagnostics::ScopedTimer total("load");
+
+    // 1. Map the file. The ciphertext is decrypted straight out of the mapping,
+    // never copied onto the heap, so the actual reads show up under decrypting.
+    if (!enter(LoadPhase::ReadingFile)) return false;
+    Diagnostics::ScopedTimer reading("load.read_file");
+    MappedFile file;
+    if (!file.open(filepath)) {
         std::cerr << "Vault file not found. A new one will be created on save." << std::endl;
         return false; // Not an error, just no file to load
     }
 
-    std::vector<unsigned char> encrypted_data(
-        (std::istreambuf_iterator<char>(file)),
-        std::istreambuf_iterator<char>()
-    );
-    file.close();
-
-    if (encrypted_data.empty()) {
+    if (file.size() == 0) {
         std::cerr << "Vault file is empty." << std::endl;
         return false;
     }
+    total.addBytes(file.size());
 
-    // 2. Decrypt the data using our Crypto class
-    auto decrypted_json_string = Crypto::decrypt(encrypted_data, password);
+    // 2. Record-log vaults are decrypted record by record into one locked
+    // arena, and replayed from there
+    if (VaultLog::hasHeader(file.data(), file.size())) {
+        auto log = std::make_shared<VaultLog>();
+        if (!log->readHeader(file.data(), file.size())) {
+            std::cerr << "Failed to read vault header (file corrupt)." << std::endl;
+            return false;
+        }
+        reading.stop();
 
-    if (!decrypted_json_string) {
+        // Current files hold the data key in keyslots; older ones are
+        // encrypted with the password-derived key itself
+        if (!enter(LoadPhase::DerivingKey)) return false;
+        Crypto::KeyHandle key;
+        bool legacy = !log->usesKeyslots();
+        try {
+            Diagnostics::ScopedTimer deriving("load.derive_key");
+            if (legacy) {
+                key = Crypto::KeyHandle::derive(password, log->salt(), log->kdfParams());
+            } else {
+                auto unwrapped = unwrapAny(log->keyslots(), password);
+                if (!unwrapped) {
+                    std::cerr << "Failed to decrypt vault (wrong password)." << std::endl;
+                    return false;
+                }
+                key = std::move(*unwrapped);
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Failed to decrypt vault: " << e.what() << std::endl;
+            return false;
+        }
+
+        if (!enter(LoadPhase::Decrypting)) return false;
+        std::optional<VaultLog::Contents> contents;
+        try {
+            Diagnostics::ScopedTimer decrypting("load.decrypt", file.size());
+            contents = log->read(filepath, file.data(), file.size(), key);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Failed to decrypt vault: " << e.what() << std::endl;
+            return false;
+        }
+        file.close();
+        if (!contents) {
+            std::cerr << "Failed to decrypt vault (wrong password or corrupt file)." << std::endl;
+            return false;
+        }
+        if (!enter(LoadPhase::Parsing)) return false;
+        Diagnostics::ScopedTimer parsing("load.parse", contents->arena.size());
+        auto sharedKey = std::make_shared<const Crypto::KeyHandle>(std::move(key));
+        EntryStore entries;
+        entries.setKey(sharedKey);
+        if (!replay(contents->records, entries)) {
+            return false;
+        }
+        parsing.stop();
+        if (legacy && !adoptLegacyKey(*log, *sharedKey, password)) {
+            return false;
+        }
+        install(std::move(entries), log, sharedKey, legacy);
+        return true; // The arena is wiped as `contents` goes
+    }
+
+    // 3. Otherwise it's a legacy single-blob vault: [SALT][NONCE][CIPHERTEXT],
+    // always derived with the interactive costs. Derive the key from its salt
+    // and keep it; the next save migrates the file to the record log.
+    if (file.size() < Crypto::SALT_BYTES + Crypto::SEAL_OVERHEAD_BYTES) {
+        std::cerr << "Vault file is too short (file corrupt)." << std::endl;
+        return false;
+    }
+    reading.stop();
+
+    if (!enter(LoadPhase::DerivingKey)) return false;
+    Crypto::KeyHandle key;
+    try {
+        Diagnostics::ScopedTimer deriving("load.derive_key");
+        key = Crypto::KeyHandle::derive(password, std::vector<unsigned char>(file.data(), file.data() + Crypto::SALT_BYTES));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to decrypt vault: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (!enter(LoadPhase::Decrypting)) return false;
+    Diagnostics::ScopedTimer decrypting("load.decrypt", file.size());
+    const unsigned char* sealed = file.data() + Crypto::SALT_BYTES;
+    size_t sealedSize = file.size() - Crypto::SALT_BYTES;
+    std::optional<Crypto::SecureBuffer> plaintext;
+    try {
+        plaintext.emplace(sealedSize - Crypto::SEAL_OVERHEAD_BYTES);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to decrypt vault: " << e.what() << std::endl;
+        return false;
+    }
+    bool opened = Crypto::openTo(plaintext->data(), sealed, sealedSize, key);
+    file.close();
+    decrypting.stop();
+    if (!opened) {
         std::cerr << "Failed to decrypt vault (wrong password or corrupt file)." << std::endl;
         return false; // Decryption failed
     }
 
-    // 3. Parse the decrypted JSON string
+    // 4. Parse the decrypted JSON in place, sealing each entry's secrets as
+    // it goes; the buffer wipes itself
+    if (!enter(LoadPhase::Parsing)) return false;
+    Diagnostics::ScopedTimer parsing("load.parse", plaintext->size());
+    auto sharedKey = std::make_shared<const Crypto::KeyHandle>(std::move(key));
+    EntryStore entries;
+    entries.setKey(sharedKey);
+    bool parsed = parseEntries(std::string_view((const char*)plaintext->data(), plaintext->size()), entries);
+    plaintext.reset();
+    if (!parsed) {
+        std::cerr << "Failed to parse vault data (file corrupt)." << std::endl;
+        return false;
+    }
+
+    auto log = std::make_shared<VaultLog>();
+    if (!adoptLegacyKey(*log, *sharedKey, password)) {
+        return false;
+    }
+    install(std::move(entries), log, sharedKey, true);
+    return true; // Success!
+}
+
+bool Vault::adoptLegacyKey(VaultLog& log, const Crypto::KeyHandle& key, const std::string& password) {
+    // The password-derived key becomes the data key, so attachments encrypted
+    // with it stay readable. Wrapping it costs one more derivation, once; the
+    // caller forces a compaction, which writes the slot out as a version 3 header.
     try {
-        json j = json::parse(*decrypted_json_string);
-        m_entries = j.get<std::vector<PasswordEntry>>();
+        log.updateKeyslots({ key.wrap(Crypto::Keyslot::Kind::Password, password, key.kdf()) });
     }
-    catch (const json::exception& e) {
-        std::cerr << "Failed to parse vault data (file corrupt): " << e.what() << std::endl;
+    catch (const std::exception& e) {
+        std::cerr << "Failed to derive vault key: " << e.what() << std::endl;
         return false;
     }
+    return true;
+}
 
-    return true; // Success!
+void Vault::install(EntryStore entries, std::shared_ptr<VaultLog> log, std::shared_ptr<const Crypto::KeyHandle> key, bool forceCompact) {
+    m_entries = std::move(entries);
+    m_dirty.clear();
+    m_forceCompact = forceCompact;
+    rebuildIndex(); // Forces a compaction if it renumbers duplicate ids
+    clearHistory();
+    m_revision = nextRevision();
+    m_log = std::move(log);
+    m_key = std::move(key);
+}
+
+bool Vault::setMasterPassword(const std::string& password, const Crypto::KdfParams& kdf) {
+    try {
+        Crypto::KeyHandle key = Crypto::KeyHandle::generate();
+        auto log = std::make_shared<VaultLog>();
+        log->updateKeyslots({ key.wrap(Crypto::Keyslot::Kind::Password, password, kdf) });
+        auto sharedKey = std::make_shared<const Crypto::KeyHandle>(std::move(key));
+        m_entries.setKey(sharedKey); // Reseals any entries under the new key
+        m_key = sharedKey;
+        m_log = log;
+        m_forceCompact = true; // Written out by the next save, even with no entries yet
+        // Their fingerprints changed with it, and the history is sealed under the old key
+        m_analyzer.clear();
+        m_analyzed = false;
+        clearHistory();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to derive vault key: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
 }
 
-bool Vault::save(const std::string& filepath, const std::string& password) {
-    // 1. Serialize the list of entries into a JSON string
-    json j = m_entries;
-    std::string json_string = j.dump(4); // dump with 4-space indent
+bool Vault::changeMasterPassword(const std::string& filepath, const std::string& currentPassword, const std::string& newPassword, const Crypto::KdfParams& kdf) {
+    if (!m_key) {
+        std::cerr << "Cannot change the master password: the vault is locked." << std::endl;
+        return false;
+    }
+    std::optional<Crypto::Keyslot> slot = wrapNewPassword(m_log->keyslots(), *m_key, currentPassword, newPassword, kdf);
+    return slot && replacePasswordSlot(filepath, *slot);
+}
 
-    // 2. Encrypt the JSON string
-    std::vector<unsigned char> encrypted_data;
+std::optional<Crypto::Keyslot> Vault::wrapNewPassword(const std::vector<Crypto::Keyslot>& slots, const Crypto::KeyHandle& key,
+                                                      const std::string& currentPassword, const std::string& newPassword,
+                                                      const Crypto::KdfParams& kdf) {
+    // Check the current secret, then wrap the data key for the new password
     try {
-        encrypted_data = Crypto::encrypt(json_string, password);
+        if (!unwrapAny(slots, currentPassword)) {
+            std::cerr << "Current password is wrong." << std::endl;
+            return std::nullopt;
+        }
+        return key.wrap(Crypto::Keyslot::Kind::Password, newPassword, kdf);
     }
     catch (const std::exception& e) {
-        std::cerr << "Failed to encrypt vault: " << e.what() << std::endl;
+        std::cerr << "Failed to derive vault key: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+bool Vault::replacePasswordSlot(const std::string& filepath, const Crypto::Keyslot& slot) {
+    if (!m_key) {
+        std::cerr << "Cannot change the master password: the vault is locked." << std::endl;
         return false;
     }
 
-    // 3. Write the raw encrypted bytes to the file
-    std::ofstream file(filepath, std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to open vault file for writing." << std::endl;
+    // The new slot replaces every password slot; recovery keys stay
+    std::vector<Crypto::Keyslot> slots = m_log->keyslots();
+    std::vector<size_t> removed;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].kind == Crypto::Keyslot::Kind::Password) removed.push_back(i);
+    }
+    return storeKeyslot(filepath, slot, removed);
+}
+
+std::optional<std::string> Vault::createRecoveryKey(const std::string& filepath) {
+    if (!m_key) {
+        std::cerr << "Cannot create a recovery key: the vault is locked." << std::endl;
+        return std::nullopt;
+    }
+
+    std::string recoveryKey = Crypto::generateRecoveryKey();
+    Crypto::Keyslot slot;
+    try {
+        slot = m_key->wrap(Crypto::Keyslot::Kind::Recovery, recoveryKey, recoveryKdf());
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to derive recovery key: " << e.what() << std::endl;
+        Crypto::wipe(recoveryKey);
+        return std::nullopt;
+    }
+
+    // There's only ever one; a new key replaces the old
+    std::vector<Crypto::Keyslot> slots = m_log->keyslots();
+    std::vector<size_t> removed;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].kind == Crypto::Keyslot::Kind::Recovery) removed.push_back(i);
+    }
+    if (!storeKeyslot(filepath, slot, removed)) {
+        Crypto::wipe(recoveryKey);
+        return std::nullopt;
+    }
+    return recoveryKey;
+}
+
+bool Vault::removeRecoveryKey(const std::string& filepath) {
+    std::vector<Crypto::Keyslot> slots = m_log->keyslots();
+    bool found = false;
+    for (auto& slot : slots) {
+        if (slot.kind == Crypto::Keyslot::Kind::Recovery) {
+            slot = Crypto::Keyslot();
+            found = true;
+        }
+    }
+    return !found || writeKeyslots(filepath, slots);
+}
+
+std::vector<Crypto::Keyslot> Vault::keyslots() const {
+    return m_log->keyslots();
+}
+
+bool Vault::hasRecoveryKey() const {
+    for (const auto& slot : m_log->keyslots()) {
+        if (slot.kind == Crypto::Keyslot::Kind::Recovery) return true;
+    }
+    return false;
+}
+
+bool Vault::storeKeyslot(const std::string& filepath, const Crypto::Keyslot& slot, const std::vector<size_t>& removed) {
+    std::vector<Crypto::Keyslot> slots = m_log->keyslots();
+    auto free = freeKeyslot(slots);
+    if (!free) {
+        std::cerr << "No free keyslot in the vault header." << std::endl;
         return false;
     }
 
-    file.write((const char*)encrypted_data.data(), encrypted_data.size());
-    file.close();
+    // 1. Add the new slot first and clear the old ones after, so a crash in
+    // between leaves both secrets working rather than neither
+    slots[*free] = slot;
+    bool inPlace = m_log->isAttachedTo(filepath) && m_log->usesKeyslots();
+    if (inPlace && !m_log->updateKeyslots(slots)) {
+        return false;
+    }
+    for (size_t i : removed) {
+        slots[i] = Crypto::Keyslot();
+    }
+    return writeKeyslots(filepath, slots);
+}
 
-    return true; // Success!
+bool Vault::writeKeyslots(const std::string& filepath, const std::vector<Crypto::Keyslot>& slots) {
+    // 1. The file has a slot table: overwrite it, O(1) in the vault's size
+    if (m_log->isAttachedTo(filepath) && m_log->usesKeyslots()) {
+        return m_log->updateKeyslots(slots);
+    }
+
+    // 2. Otherwise (a version 1/2 file, or not saved there yet) write the
+    // whole vault with a fresh log carrying the slots. If that fails the
+    // file keeps the old slots, and so must the next save, or a change
+    // reported as failed would take effect then.
+    auto log = std::make_shared<VaultLog>();
+    log->updateKeyslots(slots);
+    std::shared_ptr<VaultLog> previous = std::exchange(m_log, log);
+    if (!compact(filepath)) {
+        m_log = std::move(previous);
+        return false;
+    }
+    return true;
+}
+
+Crypto::KdfParams Vault::kdfParams() const {
+    for (const auto& slot : m_log->keyslots()) {
+        if (slot.kind == Crypto::Keyslot::Kind::Password) return slot.kdf;
+    }
+    return Crypto::KdfParams::interactive();
+}
+
+bool Vault::replay(const std::vector<VaultLog::RecordView>& records, EntryStore& entries) {
+    // Records apply to the store directly; deleted rows are dropped at the
+    // end, keeping order. Secrets stay sealed under the data key.
+    EntryStore scratch; // Each Put record decodes here first
+    scratch.setKey(entries.key());
+    std::vector<bool> live;
+    std::unordered_map<uint64_t, size_t> index; // id -> row in entries
+
+    for (const auto& record : records) {
+        switch (record.op) {
+        case VaultLog::Op::Snapshot: {
+            if (!parseEntries(record.payload, entries)) {
+                std::cerr << "Failed to parse vault snapshot (file corrupt)." << std::endl;
+                return false;
+            }
+            live.assign(entries.size(), true);
+            index.clear();
+            index.reserve(entries.size());
+            for (size_t i = 0; i < entries.size(); ++i) {
+                index[entries[i].id()] = i;
+            }
+            break;
+        }
+
+        case VaultLog::Op::Put: {
+            if (!parseEntry(record.payload, scratch)) {
+                std::cerr << "Failed to parse vault entry (file corrupt)." << std::endl;
+                return false;
+            }
+            EntryRef entry = scratch[0];
+            auto it = index.find(entry.id());
+            if (it != index.end()) {
+                entries.assign(it->second, entry);
+                live[it->second] = true;
+            } else {
+                index[entry.id()] = entries.append(entry);
+                live.push_back(true);
+            }
+            break;
+        }
+
+        case VaultLog::Op::Delete: {
+            auto id = parseId(record.payload);
+            if (!id) {
+                std::cerr << "Failed to parse vault delete record (file corrupt)." << std::endl;
+                return false;
+            }
+            auto it = index.find(*id);
+            if (it != index.end()) {
+                live[it->second] = false;
+                index.erase(it);
+            }
+            break;
+        }
+
+        default:
+            std::cerr << "Unknown vault record type " << (int)record.op << "." << std::endl;
+            return false;
+        }
+    }
+
+    entries.retain(live);
+    return true;
+}
+
+bool Vault::save(const std::string& filepath) {
+    if (!m_key) {
+        std::cerr << "Cannot save: the vault has no key (not unlocked)." << std::endl;
+        return false;
+    }
+
+    // A refused append is retried once as a compaction
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        SaveSnapshot snapshot = takeSaveSnapshot(filepath);
+        SaveResult result = writeSnapshot(snapshot);
+        if (result == SaveResult::Saved) {
+            return true;
+        }
+        restoreSnapshot(snapshot, result);
+        if (result == SaveResult::Failed) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool Vault::compact(const std::string& filepath) {
+    m_forceCompact = true;
+    return save(filepath);
+}
+
+Vault::SaveSnapshot Vault::takeSaveSnapshot(const std::string& filepath) {
+    Diagnostics::ScopedTimer timer("save.snapshot");
+    SaveSnapshot snapshot;
+    snapshot.filepath = filepath;
+    snapshot.log = m_log;
+    snapshot.key = m_key;
+    snapshot.entries = m_entries; // O(1); pages the vault changes from here on are copied first
+
+    // 1. Rewrite everything if this is a new file, the key changed since it was
+    // written, or the log has outgrown the vault
+    bool canAppend = !m_forceCompact && m_key && m_log->isAttachedTo(filepath) && m_log->usesKeyslots();
+    if (!canAppend || m_log->appendedRecords() + m_dirty.size() > m_entries.size() + COMPACTION_SLACK) {
+        snapshot.compact = true;
+    } else {
+        // 2. Otherwise note where each changed entry is; writeSnapshot() encodes them
+        snapshot.changes.reserve(m_dirty.size());
+        for (uint64_t id : m_dirty) {
+            snapshot.changes.push_back(ChangedRow{ id, rowOf(id) });
+        }
+    }
+
+    snapshot.orphanedAttachments.swap(m_orphanedAttachments);
+    snapshot.changedIds.swap(m_dirty); // Leaves it empty, without the buckets a big import grew
+    m_forceCompact = false;
+    return snapshot;
+}
+
+Vault::SaveResult Vault::writeSnapshot(const SaveSnapshot& snapshot) {
+    if (!snapshot.key) {
+        std::cerr << "Cannot save: the vault has no key (not unlocked)." << std::endl;
+        return SaveResult::Failed;
+    }
+
+    Diagnostics::ScopedTimer timer("save.write");
+    SaveResult result;
+    try {
+        if (snapshot.compact) {
+            // 1. Serialize the list of entries straight into one buffer
+            Diagnostics::ScopedTimer encoding("save.encode");
+            std::string payload = EntryCodec::encodeEntries(snapshot.entries);
+            encoding.addBytes(payload.size());
+            encoding.stop();
+
+            // 2. Encrypt it as the snapshot record of a fresh log file
+            bool saved = snapshot.log->rewrite(snapshot.filepath, *snapshot.key, payload);
+            Crypto::wipe(payload);
+            result = saved ? SaveResult::Saved : SaveResult::Failed;
+        } else {
+            // 1. One record per changed entry
+            Diagnostics::ScopedTimer encoding("save.encode");
+            std::vector<VaultLog::Record> records;
+            records.reserve(snapshot.changes.size());
+            for (const ChangedRow& change : snapshot.changes) {
+                if (change.row != NO_ROW) {
+                    records.push_back(VaultLog::Record{ VaultLog::Op::Put, EntryCodec::encodeEntry(snapshot.entries[change.row]) });
+                } else {
+                    records.push_back(VaultLog::Record{ VaultLog::Op::Delete, EntryCodec::encodeId(change.id) });
+                }
+            }
+            encoding.stop();
+
+            // 2. The log refuses to append if the file changed under us
+            result = snapshot.log->append(records, *snapshot.key) ? SaveResult::Saved : SaveResult::NeedsCompaction;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to encrypt vault: " << e.what() << std::endl;
+        return SaveResult::Failed;
+    }
+
+    // 3. The vault no longer refers to these, so their files can go
+    if (result == SaveResult::Saved && !snapshot.orphanedAttachments.empty()) {
+        AttachmentStore store(snapshot.filepath);
+        for (const auto& id : snapshot.orphanedAttachments) {
+            store.remove(id);
+        }
+    }
+    return result;
+}
+
+void Vault::restoreSnapshot(const SaveSnapshot& snapshot, SaveResult result) {
+    m_dirty.insert(snapshot.changedIds.begin(), snapshot.changedIds.end());
+    m_orphanedAttachments.insert(m_orphanedAttachments.end(), snapshot.orphanedAttachments.begin(), snapshot.orphanedAttachments.end());
+    if (result == SaveResult::NeedsCompaction) {
+        m_forceCompact = true;
+    }
+}
+
+bool Vault::hasUnsavedChanges() const {
+    return !m_dirty.empty() || m_forceCompact;
+}
+
+size_t Vault::pendingChanges() const {
+    return m_dirty.size();
+}
+
+uint64_t Vault::revision() const {
+    return m_revision;
+}
+
+void Vault::markChanged(uint64_t id) {
+    m_dirty.insert(id);
+    m_revision = nextRevision();
 }
 
 void Vault::clear() {
-    m_entries.clear();
+    m_entries = EntryStore(); // Wiped, and its memory handed back to the pool
+    clearHistory();           // Likewise the snapshots it holds
+    rebuildIndex();
+    m_dirty.clear();
+    m_orphanedAttachments.clear();
+    m_forceCompact = false;
+    m_revision = nextRevision();
+    m_log = std::make_shared<VaultLog>();
+    m_key.reset(); // Wiped once any in-flight background save lets go of it too
+
+    // Return the slabs nothing lives in anymore; a background save still
+    // holding a snapshot keeps its own
+    SecurePool::shared().trim();
 }
 
-const std::vector<PasswordEntry>& Vault::getEntries() const {
+const EntryStore& Vault::entries() const {
     return m_entries;
 }
 
-void Vault::addEntry(const PasswordEntry& entry) {
-    m_entries.push_back(entry);
+EntryHandle Vault::addEntry(const PasswordEntry& entry) {
+    markChanged(entry.id);
+    if (m_historyLimit > 0) {
+        recordStep(captureStep(m_idToSlot.count(entry.id) ? "Edit" : "Add", { entry.id }));
+    }
+
+    // Same ID: replace in place, like a Put record does on load
+    EntryHandle handle;
+    auto it = m_idToSlot.find(entry.id);
+    if (it != m_idToSlot.end()) {
+        uint32_t row = m_slots[it->second].index;
+        orphanAttachments(m_entries[row].attachments(), &entry.attachments);
+        m_entries.assign(row, entry);
+        handle = EntryHandle{ it->second, m_slots[it->second].generation };
+    } else {
+        handle = appendEntry(entry);
+    }
+
+    uint32_t row = m_slots[handle.slot].index;
+    m_entries.setModified(row, nowMillis());
+    m_search.add(m_entries[row]);
+    if (m_analyzed) m_analyzer.add(m_entries[row]);
+    return handle;
+}
+
+size_t Vault::importEntries(std::vector<PasswordEntry>&& entries) {
+    if (entries.empty()) {
+        return 0;
+    }
+
+    // 1. Grow every container once, not entry by entry
+    size_t count = entries.size();
+    size_t total = m_entries.size() + count;
+    size_t textBytes = 0;
+    for (const auto& entry : entries) {
+        textBytes += entry.title.size() + 1; // Usernames and urls go to the intern pool
+    }
+    m_entries.reserve(count, textBytes);
+    m_entrySlots.reserve(total);
+    m_slots.reserve(m_slots.size() + count);
+    m_idToSlot.reserve(total);
+    m_dirty.reserve(m_dirty.size() + count);
+
+    // 2. One block of fresh ids; none of them can collide. Undoing the
+    // import deletes them all again.
+    uint64_t id = reserveEntryIds(count);
+    uint64_t now = nowMillis();
+    if (m_historyLimit > 0) {
+        HistoryStep step{ "Import", m_entries, {} };
+        step.rows.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            step.rows.push_back(ChangedRow{ id + i, NO_ROW });
+        }
+        recordStep(std::move(step));
+    }
+    for (auto& entry : entries) {
+        entry.id = id++;
+        entry.modified = now;
+        m_dirty.insert(entry.id);
+        EntryHandle handle = appendEntry(entry);
+        // Sealed now; don't leave the plaintext in freed heap memory
+        Crypto::wipe(entry.password);
+        Crypto::wipe(entry.notes);
+        EntryRef added = m_entries[m_slots[handle.slot].index];
+        m_search.add(added);
+        if (m_analyzed) m_analyzer.add(added);
+    }
+    entries.clear();
+    m_revision = nextRevision();
+    return count;
+}
+
+uint64_t Vault::newEntryId() {
+    return reserveEntryIds(1);
+}
+
+uint64_t Vault::reserveEntryIds(size_t count) {
+    // Ids are creation times, as they always were, but bumped past every id
+    // in use or already handed out, so two entries made in the same
+    // millisecond no longer collide (and silently replace one another)
+    uint64_t first = std::max({ nowMillis(), m_nextId, m_maxId + 1 });
+    m_nextId = first + count;
+    return first;
+}
+
+EntryHandle Vault::appendEntry(const PasswordEntry& entry) {
+    m_entries.append(entry);
+    return addSlot(entry.id);
+}
+
+EntryHandle Vault::addSlot(uint64_t id) {
+    // Reuse a freed slot if there is one
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = (uint32_t)m_slots.size();
+        m_slots.push_back(Slot{ 0, 0 });
+    }
+
+    m_maxId = std::max(m_maxId, id);
+    m_slots[slot].index = (uint32_t)m_entries.size() - 1;
+    m_idToSlot[id] = slot;
+    m_entrySlots.push_back(slot);
+    return EntryHandle{ slot, m_slots[slot].generation };
+}
+
+uint32_t Vault::rowOf(uint64_t id) const {
+    auto it = m_idToSlot.find(id);
+    return it != m_idToSlot.end() ? m_slots[it->second].index : NO_ROW;
 }
 
 void Vault::deleteEntry(uint64_t id) {
-    // Find the entry with the matching ID and erase it
-    m_entries.erase(
-        std::remove_if(m_entries.begin(), m_entries.end(),
-            [id](const PasswordEntry& entry) { return entry.id == id; }),
-        m_entries.end()
-    );
+    if (m_historyLimit > 0 && m_idToSlot.count(id)) {
+        recordStep(captureStep("Delete", { id }));
+    }
+    removeEntry(id);
+}
+
+void Vault::removeEntry(uint64_t id) {
+    auto it = m_idToSlot.find(id);
+    if (it == m_idToSlot.end()) {
+        return;
+    }
+    markChanged(id);
+    m_search.remove(id);
+    if (m_analyzed) m_analyzer.remove(id);
+
+    uint32_t slot = it->second;
+    uint32_t index = m_slots[slot].index;
+    orphanAttachments(m_entries[index].attachments(), nullptr);
+
+    // The store moves the last entry into the hole instead of shifting everything down
+    uint32_t last = (uint32_t)m_entries.remove(index);
+    if (index != last) {
+        m_entrySlots[index] = m_entrySlots[last];
+        m_slots[m_entrySlots[index]].index = index;
+    }
+    m_entrySlots.pop_back();
+
+    // Invalidate handles to the deleted entry and recycle its slot
+    ++m_slots[slot].generation;
+    m_freeSlots.push_back(slot);
+    m_idToSlot.erase(it);
+}
+
+bool Vault::editEntry(uint64_t id, const std::function<void(PasswordEntry&)>& edit) {
+    if (m_historyLimit > 0 && m_idToSlot.count(id)) {
+        recordStep(captureStep("Edit", { id }));
+    }
+    return updateEntry(id, edit);
+}
+
+bool Vault::updateEntry(uint64_t id, const std::function<void(PasswordEntry&)>& edit) {
+    auto it = m_idToSlot.find(id);
+    if (it == m_idToSlot.end()) {
+        return false;
+    }
+    uint32_t row = m_slots[it->second].index;
+    PasswordEntry entry = m_entries[row].toEntry();
+    edit(entry);
+    entry.id = id; // The id is the entry's identity; it can't be edited
+    entry.modified = nowMillis();
+    m_entries.assign(row, entry);
+    Crypto::wipe(entry.password);
+    Crypto::wipe(entry.notes);
+
+    markChanged(id);
+    m_search.add(m_entries[row]);
+    if (m_analyzed) m_analyzer.add(m_entries[row]);
+    return true;
+}
+
+std::vector<EntryHandle> Vault::search(const std::string& query) {
+    std::vector<EntryHandle> handles;
+    for (uint64_t id : m_search.query(query)) {
+        handles.push_back(findEntry(id));
+    }
+    return handles;
+}
+
+const PasswordAnalyzer& Vault::analysis() {
+    if (!m_analyzed) {
+        // First use since unlock; from here on every change updates it
+        for (EntryRef entry : m_entries) {
+            m_analyzer.add(entry);
+        }
+        m_analyzed = true;
+    }
+    return m_analyzer;
+}
+
+void Vault::orphanAttachments(const std::vector<Attachment>& before, const std::vector<Attachment>* after) {
+    for (const auto& attachment : before) {
+        bool kept = after && std::any_of(after->begin(), after->end(),
+                                         [&](const Attachment& a) { return a.id == attachment.id; });
+        if (!kept) {
+            m_orphanedAttachments.push_back(attachment.id);
+        }
+    }
+}
+
+bool Vault::attachFile(const std::string& vaultPath, uint64_t entryId, const std::string& sourcePath) {
+    if (!m_key) {
+        std::cerr << "Cannot attach: the vault has no key (not unlocked)." << std::endl;
+        return false;
+    }
+    if (findEntry(entryId).isNull()) {
+        return false;
+    }
+
+    auto attachment = AttachmentStore(vaultPath).import(sourcePath, *m_key);
+    if (!attachment) {
+        return false;
+    }
+    // Until the entry is saved, the new file is unreferenced; at worst a crash
+    // leaves an orphaned file, never an entry pointing at nothing.
+    updateEntry(entryId, [&](PasswordEntry& entry) { entry.attachments.push_back(*attachment); });
+    return true;
 }
 
-PasswordEntry* Vault::getEntryForEdit(uint64_t id) {
-    for (auto& entry : m_entries) {
-        if (entry.id == id) {
-            return &entry;
+bool Vault::exportAttachment(const std::string& vaultPath, const Attachment& attachment, const std::string& destPath) const {
+    if (!m_key) {
+        std::cerr << "Cannot export: the vault has no key (not unlocked)." << std::endl;
+        return false;
+    }
+    return AttachmentStore(vaultPath).exportTo(attachment, destPath, *m_key);
+}
+
+void Vault::removeAttachment(uint64_t entryId, const std::string& attachmentId) {
+    auto it = m_idToSlot.find(entryId);
+    if (it == m_idToSlot.end()) {
+        return;
+    }
+    const auto& attachments = m_entries[m_slots[it->second].index].attachments();
+    auto pos = std::find_if(attachments.begin(), attachments.end(), [&](const Attachment& a) { return a.id == attachmentId; });
+    if (pos == attachments.end()) {
+        return;
+    }
+    // attachmentId may refer into the attachment being erased
+    m_orphanedAttachments.push_back(attachmentId);
+    size_t position = pos - attachments.begin();
+    updateEntry(entryId, [&](PasswordEntry& entry) { entry.attachments.erase(entry.attachments.begin() + position); });
+}
+
+// --- Undo history ---
+
+void Vault::setHistoryLimit(size_t steps) {
+    m_historyLimit = steps;
+    while (m_undo.size() > steps) {
+        m_undo.pop_front();
+    }
+    if (steps == 0) {
+        m_redo.clear();
+    }
+}
+
+bool Vault::canUndo() const {
+    return !m_undo.empty();
+}
+
+bool Vault::canRedo() const {
+    return !m_redo.empty();
+}
+
+std::string Vault::undoLabel() const {
+    return m_undo.empty() ? std::string() : m_undo.back().label;
+}
+
+std::string Vault::redoLabel() const {
+    return m_redo.empty() ? std::string() : m_redo.back().label;
+}
+
+bool Vault::undo() {
+    if (m_undo.empty()) {
+        return false;
+    }
+    HistoryStep step = std::move(m_undo.back());
+    m_undo.pop_back();
+
+    // The entries as they are now become the step that redoes it
+    std::vector<uint64_t> ids;
+    ids.reserve(step.rows.size());
+    for (const ChangedRow& changed : step.rows) ids.push_back(changed.id);
+    m_redo.push_back(captureStep(step.label, ids));
+    applyStep(step);
+    return true;
+}
+
+bool Vault::redo() {
+    if (m_redo.empty()) {
+        return false;
+    }
+    HistoryStep step = std::move(m_redo.back());
+    m_redo.pop_back();
+
+    std::vector<uint64_t> ids;
+    ids.reserve(step.rows.size());
+    for (const ChangedRow& changed : step.rows) ids.push_back(changed.id);
+    m_undo.push_back(captureStep(step.label, ids));
+    applyStep(step);
+    return true;
+}
+
+Vault::HistoryStep Vault::captureStep(std::string label, const std::vector<uint64_t>& ids) const {
+    HistoryStep step{ std::move(label), m_entries, {} }; // O(1), see EntryStore
+    step.rows.reserve(ids.size());
+    for (uint64_t id : ids) {
+        step.rows.push_back(ChangedRow{ id, rowOf(id) });
+    }
+    return step;
+}
+
+void Vault::recordStep(HistoryStep step) {
+    m_undo.push_back(std::move(step));
+    if (m_undo.size() > m_historyLimit) {
+        m_undo.pop_front();
+    }
+    m_redo.clear();
+}
+
+void Vault::applyStep(const HistoryStep& step) {
+    for (const ChangedRow& changed : step.rows) {
+        uint32_t row = rowOf(changed.id);
+
+        // 1. Absent before the step: delete it
+        if (changed.row == NO_ROW) {
+            removeEntry(changed.id);
+            continue;
+        }
+
+        // 2. Otherwise put it back. Both stores share the vault key (a new
+        // key clears the history), so its secrets go back sealed as they are.
+        EntryRef before = step.entries[changed.row];
+        std::vector<Attachment> attachments;
+        if (row != NO_ROW) {
+            attachments = m_entries[row].attachments();
+        } else {
+            for (const auto& attachment : before.attachments()) {
+                auto orphaned = std::find(m_orphanedAttachments.begin(), m_orphanedAttachments.end(), attachment.id);
+                if (orphaned != m_orphanedAttachments.end()) {
+                    m_orphanedAttachments.erase(orphaned);
+                    attachments.push_back(attachment);
+                }
+            }
+        }
+        if (row != NO_ROW) {
+            m_entries.assignSealed(row, changed.id, before.modified(), before.title(), before.username(), before.url(),
+                                   before.passwordSummary(), before.sealedSecrets(), std::move(attachments));
+        } else {
+            m_entries.appendSealed(changed.id, before.modified(), before.title(), before.username(), before.url(),
+                                   before.passwordSummary(), before.sealedSecrets(), std::move(attachments));
+            row = m_slots[addSlot(changed.id).slot].index;
+        }
+
+        markChanged(changed.id);
+        m_search.add(m_entries[row]);
+        if (m_analyzed) m_analyzer.add(m_entries[row]);
+    }
+}
+
+void Vault::clearHistory() {
+    m_undo.clear();
+    m_redo.clear();
+}
+
+// --- Handles ---
+
+EntryHandle Vault::findEntry(uint64_t id) const {
+    auto it = m_idToSlot.find(id);
+    if (it == m_idToSlot.end()) {
+        return EntryHandle();
+    }
+    return EntryHandle{ it->second, m_slots[it->second].generation };
+}
+
+EntryHandle Vault::handleAt(size_t index) const {
+    if (index >= m_entrySlots.size()) {
+        return EntryHandle();
+    }
+    uint32_t slot = m_entrySlots[index];
+    return EntryHandle{ slot, m_slots[slot].generation };
+}
+
+EntryRef Vault::getEntry(EntryHandle handle) const {
+    if (handle.slot >= m_slots.size() || m_slots[handle.slot].generation != handle.generation) {
+        return EntryRef();
+    }
+    return m_entries[m_slots[handle.slot].index];
+}
+
+void Vault::rebuildIndex() {
+    Diagnostics::ScopedTimer timer("vault.index");
+    // Every slot's generation moves on, so handles from before a load or
+    // clear() don't resolve to whatever now sits in their slot.
+    uint32_t generation = 0;
+    for (const auto& slot : m_slots) {
+        generation = std::max(generation, slot.generation + 1);
+    }
+
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_entrySlots.clear();
+    m_idToSlot.clear();
+    m_slots.reserve(m_entries.size());
+    m_entrySlots.reserve(m_entries.size());
+    m_idToSlot.reserve(m_entries.size());
+
+    uint64_t maxId = 0;
+    for (EntryRef entry : m_entries) {
+        maxId = std::max(maxId, entry.id());
+    }
+
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        // Old vaults can hold two entries created in the same millisecond.
+        // Give the later one a fresh ID rather than losing it.
+        if (m_idToSlot.count(m_entries[i].id())) {
+            std::cerr << "Duplicate entry id " << m_entries[i].id() << "; assigning a new one." << std::endl;
+            m_entries.setId(i, ++maxId);
+            m_dirty.insert(maxId);
+            m_forceCompact = true; // Appending would leave both old records in the file
         }
+
+        uint32_t slot = (uint32_t)i;
+        m_slots.push_back(Slot{ (uint32_t)i, generation });
+        m_entrySlots.push_back(slot);
+        m_idToSlot[m_entries[i].id()] = slot;
+    }
+    m_maxId = maxId;
+
+    m_search.clear();
+    m_analyzer.clear(); // Rebuilt by the first analysis()
+    m_analyzed = false;
+    for (EntryRef entry : m_entries) {
+        m_search.add(entry);
     }
-    return nullptr;
-}
\ No newline at end of file
+}
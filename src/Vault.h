@@ -1,63 +1,422 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
-// Define a structure for a single password entry
-struct PasswordEntry {
-    // We use a simple timestamp as a unique ID
-    uint64_t id; 
-    std::string title;
-    std::string username;
-    std::string password;
-    std::string url;
-    std::string notes;
+#include "Crypto.h"
+#include "EntryStore.h"
+#include "PasswordAnalyzer.h"
+#include "SearchIndex.h"
+#include "VaultLog.h"
+
+/**
+ * @brief A stable reference to an entry. Unlike a position in entries(),
+ * it keeps pointing at the same entry when others are added or deleted, and
+ * goes stale (Vault::getEntry returns a null EntryRef) once its own entry is deleted.
+ */
+struct EntryHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool isNull() const { return slot == UINT32_MAX; }
+    bool operator==(const EntryHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const EntryHandle& other) const { return !(*this == other); }
 };
 
 class Vault {
 public:
+    Vault() = default;
+    Vault(Vault&&) = default;
+    Vault& operator=(Vault&&) = default;
+    Vault(const Vault&) = delete;
+    Vault& operator=(const Vault&) = delete;
+
+    // The steps of load(), in order, for progress reporting
+    enum class LoadPhase {
+        ReadingFile,
+        DerivingKey, // Argon2id; by far the slowest step
+        Decrypting,
+        Parsing
+    };
+
+    /**
+     * @brief Called by load() as it enters each phase.
+     * Return false to cancel; load() then stops and returns false.
+     */
+    using LoadProgress = std::function<bool(LoadPhase)>;
+
     /**
      * @brief Tries to load and decrypt the vault file from disk.
+     * The file is memory-mapped and decrypted straight into one locked,
+     * self-wiping buffer (Crypto::SecureBuffer) that the entries are parsed
+     * from in place; the only other copy of the data is the entries themselves.
+     * On success the data key is kept for the session, so save() doesn't
+     * need the password again. Files from before keyslots are upgraded (their
+     * password-derived key becomes the data key) by the next save. On
+     * failure the vault is left exactly as it was.
      * @param filepath The path to the vault file (e.g., "vault.db").
-     * @param password The master password.
+     * @param password The master password, or the recovery key.
+     * @param progress Optional phase callback (see LoadProgress).
      * @return True if loading and decryption are successful, false otherwise.
      */
-    bool load(const std::string& filepath, const std::string& password);
+    bool load(const std::string& filepath, const std::string& password, const LoadProgress& progress = nullptr);
 
     /**
-     * @brief Encrypts and saves the current vault state to disk.
-     * @param filepath The path to the vault file.
+     * @brief Makes a new random data key with one password keyslot, for a
+     * brand-new vault (no file to load yet) or for re-encrypting this one.
+     * Any recovery key is dropped (callers re-encrypting a vault must say
+     * so, or create a new one), and attachments encrypted under the old key
+     * become unreadable; the next save rewrites the whole file.
+     * To change the password of an existing vault, use changeMasterPassword().
      * @param password The master password.
+     * @param kdf The key derivation costs, recorded in the keyslot
+     * (typically from Crypto::calibrateKdf).
+     * @return True on success, false if key derivation failed.
+     */
+    bool setMasterPassword(const std::string& password, const Crypto::KdfParams& kdf = Crypto::KdfParams::interactive());
+
+    // --- Keyslots ---
+    // The data key stays the same; only its wrapping changes. When the file at
+    // `filepath` is the version 3 file we're attached to, just its header's
+    // slot table is rewritten, in time independent of the vault's size (one
+    // key derivation per secret involved). Otherwise the vault is compacted.
+
+    /**
+     * @brief Replaces the master password.
+     * @param currentPassword Checked against the vault; the recovery key also works.
+     * @param kdf Costs for the new password's keyslot.
+     * @return False if the current password is wrong or the write failed.
+     */
+    bool changeMasterPassword(const std::string& filepath, const std::string& currentPassword, const std::string& newPassword, const Crypto::KdfParams& kdf);
+
+    /**
+     * @brief The slow half of changeMasterPassword(): checks `currentPassword`
+     * against `slots`, then wraps `key` for the new password (two key
+     * derivations). Touches no vault, so it can run on another thread (see
+     * PasswordChangeJob).
+     * @return The new password keyslot, or std::nullopt if the current
+     * password is wrong or derivation failed.
+     */
+    static std::optional<Crypto::Keyslot> wrapNewPassword(const std::vector<Crypto::Keyslot>& slots, const Crypto::KeyHandle& key,
+                                                          const std::string& currentPassword, const std::string& newPassword,
+                                                          const Crypto::KdfParams& kdf);
+
+    /**
+     * @brief The quick half: stores a slot from wrapNewPassword() in place of
+     * every password slot; recovery keys stay.
+     */
+    bool replacePasswordSlot(const std::string& filepath, const Crypto::Keyslot& slot);
+
+    /**
+     * @brief Adds a recovery key (replacing any earlier one) that unlocks the
+     * vault in place of the password. It is only ever returned here.
+     * @return The key (see Crypto::generateRecoveryKey), or std::nullopt on failure.
+     */
+    std::optional<std::string> createRecoveryKey(const std::string& filepath);
+
+    bool removeRecoveryKey(const std::string& filepath);
+    bool hasRecoveryKey() const;
+    std::vector<Crypto::Keyslot> keyslots() const;
+
+    /**
+     * @brief The key derivation costs of the password keyslot (interactive() if there is none).
+     */
+    Crypto::KdfParams kdfParams() const;
+
+    /**
+     * @brief Encrypts and saves the current vault state to disk with the session key.
+     * If the file is the one we loaded, only the entries changed since the last
+     * save are appended as records; otherwise (or once the log has grown too
+     * long) the whole vault is rewritten via compact().
+     * @param filepath The path to the vault file.
+     * @return True on success, false on failure (including no session key).
+     */
+    bool save(const std::string& filepath);
+
+    /**
+     * @brief Rewrites the whole vault as a single snapshot, dropping superseded records.
      * @return True on success, false on failure.
      */
-    bool save(const std::string& filepath, const std::string& password);
+    bool compact(const std::string& filepath);
+
+    // --- Background saving ---
+    // save() is takeSaveSnapshot() + writeSnapshot() on one thread. AutoSaver
+    // splits them: the snapshot is taken on the UI thread, the write (encoding,
+    // encryption and I/O) happens on a worker while the UI keeps editing the vault.
+
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+
+    /**
+     * @brief An entry a change touched, and its row in the EntryStore the
+     * change was recorded against (NO_ROW: it isn't there, i.e. deleted).
+     */
+    struct ChangedRow {
+        uint64_t id;
+        uint32_t row;
+    };
+
+    /**
+     * @brief Everything one save needs, detached from the Vault.
+     */
+    struct SaveSnapshot {
+        std::string filepath;
+        std::shared_ptr<VaultLog> log;
+        std::shared_ptr<const Crypto::KeyHandle> key;
+        bool compact = false;
+        EntryStore entries;                        // Every entry as of the snapshot; shares pages with the vault
+        std::vector<ChangedRow> changes;           // Unless compact: the entries to append records for
+        std::unordered_set<uint64_t> changedIds;   // What this save covers, for restoreSnapshot()
+        std::vector<std::string> orphanedAttachments; // Attachment files to delete once saved
+    };
+
+    enum class SaveResult {
+        Saved,
+        NeedsCompaction, // The file changed under us; retry with a fresh snapshot
+        Failed
+    };
+
+    /**
+     * @brief Captures the pending changes and marks the vault clean.
+     * O(changes): the entries are a copy-on-write snapshot (see EntryStore),
+     * which writeSnapshot() encodes, so edits made meanwhile never reach the file
+     * half done.
+     */
+    SaveSnapshot takeSaveSnapshot(const std::string& filepath);
+
+    /**
+     * @brief Encrypts and writes a snapshot. Doesn't touch any Vault, so it can
+     * run on another thread. Run at most one at a time per vault.
+     */
+    static SaveResult writeSnapshot(const SaveSnapshot& snapshot);
+
+    /**
+     * @brief Re-marks a snapshot's changes as unsaved after writeSnapshot failed.
+     */
+    void restoreSnapshot(const SaveSnapshot& snapshot, SaveResult result);
 
     /**
-     * @brief Clears all entries from memory. Used for logging out.
+     * @brief True if there are changes save() hasn't written yet.
+     */
+    bool hasUnsavedChanges() const;
+
+    /**
+     * @brief Number of entries added, edited or deleted since the last save.
+     */
+    size_t pendingChanges() const;
+
+    /**
+     * @brief Changes on every change to the entries; lets observers notice edits.
+     * Values are unique across all Vault objects, so a cache keyed on one can't
+     * mistake a different (e.g. freshly unlocked) vault for the one it saw.
+     */
+    uint64_t revision() const;
+
+    /**
+     * @brief Clears all entries from memory and wipes the session key. Used for logging out.
      */
     void clear();
 
     /**
-     * @brief Gets a const reference to the list of entries.
-     * This is for the UI to read and display the entries.
+     * @brief Gets a const reference to the entries, stored column by column
+     * (see EntryStore). This is for the UI to read and display the entries.
+     * Deleting an entry moves the last entry into its place, so positions
+     * aren't stable; hold an EntryHandle (handleAt) instead.
+     */
+    const EntryStore& entries() const;
+
+    /**
+     * @brief Adds a new entry to the vault. An entry with the same ID is replaced.
+     * Its modified time is set to now.
+     * @return A handle to the entry.
      */
-    const std::vector<PasswordEntry>& getEntries() const;
+    EntryHandle addEntry(const PasswordEntry& entry);
 
     /**
-     * @brief Adds a new entry to the vault.
+     * @brief Adds entries in bulk (e.g. from Importer), each as a new entry
+     * with a fresh id; whatever ids they carry are ignored. Capacity is
+     * reserved once up front. Each password and note is wiped once sealed,
+     * and `entries` is left empty.
+     * @return The number of entries added.
      */
-    void addEntry(const PasswordEntry& entry);
+    size_t importEntries(std::vector<PasswordEntry>&& entries);
 
     /**
-     * @brief Deletes an entry by its unique ID.
+     * @brief A fresh id for a new entry: the current time in milliseconds,
+     * bumped past every id in use or handed out before, so it's unique even
+     * when entries are created faster than one per millisecond.
+     */
+    uint64_t newEntryId();
+
+    /**
+     * @brief Reserves `count` consecutive fresh ids (see newEntryId).
+     * @return The first of them.
+     */
+    uint64_t reserveEntryIds(size_t count);
+
+    /**
+     * @brief Deletes an entry by its unique ID. O(1).
      */
     void deleteEntry(uint64_t id);
 
     /**
-     * @brief Gets a mutable pointer to an entry by its ID for editing.
+     * @brief Edits an entry by its ID. The entry is copied out, passed to
+     * `edit`, and stored back; it is marked as changed, its modified time set
+     * to now and it is re-indexed, so the next save() writes it out.
+     * @return False if there is no such entry.
+     */
+    bool editEntry(uint64_t id, const std::function<void(PasswordEntry&)>& edit);
+
+    // --- Undo history ---
+    // addEntry, editEntry, deleteEntry and importEntries each record a step
+    // holding a snapshot of the entries from before it (O(1), see EntryStore).
+    // Undoing a step puts the entries it touched back as they were, and is
+    // itself a change that the next save writes out. Attachments aren't part
+    // of the history: an entry keeps its current ones, and a deleted entry
+    // that comes back gets back only those whose files haven't been removed
+    // by a save yet. Loading, clear() and a new key drop the history.
+
+    /**
+     * @brief Keeps up to `steps` steps to undo; 0 (the default) turns the history off.
+     */
+    void setHistoryLimit(size_t steps);
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    /**
+     * @brief What the next undo()/redo() would revert or repeat, e.g. "Edit"; empty if nothing.
      */
-    PasswordEntry* getEntryForEdit(uint64_t id);
+    std::string undoLabel() const;
+    std::string redoLabel() const;
+
+    /**
+     * @return False if there was nothing to undo (redo).
+     */
+    bool undo();
+    bool redo();
+
+    /**
+     * @brief Full-text search over title, username and url (notes are sealed).
+     * Case-insensitive; every whitespace-separated term must occur somewhere
+     * in the entry. Backed by an incrementally updated index (SearchIndex).
+     * @return Handles of the matching entries, in no particular order. Empty for an empty query.
+     */
+    std::vector<EntryHandle> search(const std::string& query);
+
+    /**
+     * @brief Password reuse and strength, for every entry. Kept up to date as
+     * entries change (see PasswordAnalyzer). Built on first use after a
+     * load, so unlocking doesn't pay for it.
+     */
+    const PasswordAnalyzer& analysis();
+
+    // --- Attachments ---
+    // Contents are stored encrypted next to the vault file (see AttachmentStore);
+    // entries only hold references. A removed attachment's file is deleted by
+    // the next successful save, so the file on disk never refers to a missing one.
+
+    /**
+     * @brief Encrypts a file into the vault's attachment store and adds it to an entry.
+     * Streams in fixed-size chunks, so memory use doesn't depend on the file size.
+     * @param vaultPath The vault file (attachments live next to it).
+     * @return True on success, false if there's no such entry, no session key or the copy failed.
+     */
+    bool attachFile(const std::string& vaultPath, uint64_t entryId, const std::string& sourcePath);
+
+    /**
+     * @brief Decrypts an attachment to destPath, chunk by chunk.
+     * @return True on success.
+     */
+    bool exportAttachment(const std::string& vaultPath, const Attachment& attachment, const std::string& destPath) const;
+
+    /**
+     * @brief Removes an attachment from an entry. Its file goes at the next save.
+     */
+    void removeAttachment(uint64_t entryId, const std::string& attachmentId);
+
+    // --- Handles ---
+
+    /**
+     * @brief Looks up an entry's handle by ID. O(1). Null if there is no such entry.
+     */
+    EntryHandle findEntry(uint64_t id) const;
+
+    /**
+     * @brief The handle of the entry at a position in entries().
+     */
+    EntryHandle handleAt(size_t index) const;
+
+    /**
+     * @brief Resolves a handle. O(1). Like a position, the view is only good
+     * until the vault next changes.
+     * @return The entry, or a null EntryRef if it has been deleted (or the handle is null).
+     */
+    EntryRef getEntry(EntryHandle handle) const;
 
 private:
-    std::vector<PasswordEntry> m_entries;
+    // load() builds everything on locals with these, then installs it in
+    // one go, so a load that fails leaves the vault as it was
+    static bool replay(const std::vector<VaultLog::RecordView>& records, EntryStore& entries); // Into an empty store with the key set
+    static bool adoptLegacyKey(VaultLog& log, const Crypto::KeyHandle& key, const std::string& password);
+    void install(EntryStore entries, std::shared_ptr<VaultLog> log, std::shared_ptr<const Crypto::KeyHandle> key, bool forceCompact);
+    bool storeKeyslot(const std::string& filepath, const Crypto::Keyslot& slot, const std::vector<size_t>& removed);
+    bool writeKeyslots(const std::string& filepath, const std::vector<Crypto::Keyslot>& slots);
+
+    EntryHandle appendEntry(const PasswordEntry& entry); // Stores an entry under a new slot
+    EntryHandle addSlot(uint64_t id);                     // Gives the last row a new slot
+    uint32_t rowOf(uint64_t id) const;                    // NO_ROW if there's no such entry
+    bool updateEntry(uint64_t id, const std::function<void(PasswordEntry&)>& edit); // editEntry, unrecorded
+    void removeEntry(uint64_t id);                        // deleteEntry, unrecorded
+    void markChanged(uint64_t id);
+    void orphanAttachments(const std::vector<Attachment>& before, const std::vector<Attachment>* after);
+    void rebuildIndex();
+
+    // A step of the undo history: the entries it touched, as they were before it
+    struct HistoryStep {
+        std::string label;
+        EntryStore entries;
+        std::vector<ChangedRow> rows; // Into `entries`
+    };
+
+    HistoryStep captureStep(std::string label, const std::vector<uint64_t>& ids) const;
+    void recordStep(HistoryStep step);
+    void applyStep(const HistoryStep& step);
+    void clearHistory();
+
+    // A slot is a handle's target. It points at the entry's current position in
+    // m_entries; its generation is bumped when the entry is deleted, which
+    // invalidates outstanding handles, and the slot is then reused.
+    struct Slot {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    EntryStore m_entries;                      // Dense, so the UI can iterate quickly
+    std::vector<uint32_t> m_entrySlots;        // m_entries position -> slot
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<uint64_t, uint32_t> m_idToSlot;
+    uint64_t m_maxId = 0;  // Largest id in m_entries, for reserveEntryIds()
+    uint64_t m_nextId = 0; // Ids below this have been handed out
+    SearchIndex m_search;
+    PasswordAnalyzer m_analyzer;
+    bool m_analyzed = false; // m_analyzer covers every entry
+    // The data key, unwrapped once at unlock; clear() drops it. Shared so an
+    // in-flight background save can finish with it.
+    std::shared_ptr<const Crypto::KeyHandle> m_key;
+    std::unordered_set<uint64_t> m_dirty; // Ids added, edited or deleted since the last save
+    std::vector<std::string> m_orphanedAttachments; // Dropped since the last save; deleted by it
+    std::shared_ptr<VaultLog> m_log = std::make_shared<VaultLog>(); // The file we loaded from / last saved to
+    bool m_forceCompact = false;
+    uint64_t m_revision = 0;
+    std::deque<HistoryStep> m_undo; // Oldest first
+    std::deque<HistoryStep> m_redo; // Likewise; cleared by a new step
+    size_t m_historyLimit = 0;
 };
\ No newline at end of file
@@ -0,0 +1,583 @@
+#include "VaultLog.h"
+#include "Diagnostics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include <sodium.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    const unsigned char MAGIC[4] = { 'C', 'V', 'L', 'T' };
+    const uint8_t VERSION_V1 = 1;  // Password-derived key; derivation parameters implied (interactive)
+    const uint8_t VERSION_V2 = 2;  // Password-derived key; records the parameters
+    const uint8_t VERSION = 3;     // Written by rewrite(); a data key in keyslots
+    const uint8_t KIND_SECRETBOX = 1; // Crypto::seal
+    const uint8_t KIND_CHUNKED = 2;   // Crypto::sealChunked, for records over one chunk
+
+    const size_t HEADER_V1_BYTES = 4 + 1 + 3 + Crypto::SALT_BYTES + 8;
+    const size_t HEADER_V2_BYTES = HEADER_V1_BYTES + 8 + 8; // + [OPSLIMIT][MEMLIMIT]
+    const size_t KEYSLOTS_OFFSET = 4 + 1 + 3 + 8;
+    const size_t KEYSLOT_BYTES = 1 + 1 + 6 + 8 + 8 + Crypto::SALT_BYTES + Crypto::WRAPPED_KEY_BYTES;
+    const size_t HEADER_BYTES = KEYSLOTS_OFFSET + VaultLog::MAX_KEYSLOTS * KEYSLOT_BYTES;
+    const size_t RECORD_PREFIX_BYTES = 4 + 1;      // [LENGTH][KIND]
+    const size_t PLAINTEXT_PREFIX_BYTES = 8 + 8 + 1; // [FILE ID][SEQ][OP]
+
+    // All integers are stored little-endian regardless of the host.
+    void putU32(std::vector<unsigned char>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) out.push_back((unsigned char)(v >> (8 * i)));
+    }
+
+    void putU64(std::vector<unsigned char>& out, uint64_t v) {
+        for (int i = 0; i < 8; ++i) out.push_back((unsigned char)(v >> (8 * i)));
+    }
+
+    uint32_t getU32(const unsigned char* p) {
+        uint32_t v = 0;
+        for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+        return v;
+    }
+
+    uint64_t getU64(const unsigned char* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+        return v;
+    }
+
+    void putKeyslot(std::vector<unsigned char>& out, const Crypto::Keyslot& slot) {
+        size_t start = out.size();
+        out.push_back((unsigned char)slot.kind);
+        if (slot.kind != Crypto::Keyslot::Kind::Empty) {
+            out.push_back(slot.kdf.algorithm);
+            out.insert(out.end(), 6, 0);
+            putU64(out, slot.kdf.opsLimit);
+            putU64(out, slot.kdf.memLimit);
+            out.insert(out.end(), slot.salt.begin(), slot.salt.end());
+            out.insert(out.end(), slot.wrappedKey.begin(), slot.wrappedKey.end());
+        }
+        out.resize(start + KEYSLOT_BYTES, 0); // Empty slots are zeros
+    }
+
+    // The whole slot table, padded with empty slots
+    std::vector<unsigned char> encodeKeyslots(const std::vector<Crypto::Keyslot>& slots) {
+        std::vector<unsigned char> out;
+        out.reserve(VaultLog::MAX_KEYSLOTS * KEYSLOT_BYTES);
+        for (const auto& slot : slots) putKeyslot(out, slot);
+        out.resize(VaultLog::MAX_KEYSLOTS * KEYSLOT_BYTES, 0);
+        return out;
+    }
+
+    std::optional<Crypto::Keyslot> getKeyslot(const unsigned char* p) {
+        Crypto::Keyslot slot;
+        if (p[0] == (uint8_t)Crypto::Keyslot::Kind::Empty) {
+            return slot;
+        }
+        if (p[0] != (uint8_t)Crypto::Keyslot::Kind::Password && p[0] != (uint8_t)Crypto::Keyslot::Kind::Recovery) {
+            std::cerr << "Unknown keyslot kind " << (int)p[0] << " in vault header." << std::endl;
+            return std::nullopt;
+        }
+        slot.kind = (Crypto::Keyslot::Kind)p[0];
+        slot.kdf.algorithm = p[1];
+        slot.kdf.opsLimit = getU64(p + 8);
+        slot.kdf.memLimit = getU64(p + 16);
+        if (!slot.kdf.valid()) {
+            std::cerr << "Unsupported key derivation parameters in vault header." << std::endl;
+            return std::nullopt;
+        }
+        p += 24;
+        slot.salt.assign(p, p + Crypto::SALT_BYTES);
+        p += Crypto::SALT_BYTES;
+        slot.wrappedKey.assign(p, p + Crypto::WRAPPED_KEY_BYTES);
+        return slot;
+    }
+
+    bool hasKeyslot(const std::vector<Crypto::Keyslot>& slots) {
+        for (const auto& slot : slots) {
+            if (slot.kind != Crypto::Keyslot::Kind::Empty) return true;
+        }
+        return false;
+    }
+
+    uint64_t randomFileId() {
+        std::vector<unsigned char> bytes = Crypto::generateSalt(); // any random bytes will do
+        return getU64(bytes.data());
+    }
+
+    // --- Durable writes ---
+    // A stream's flush() only reaches the OS cache; after a power cut the
+    // file (or, for a rename, the directory entry) may still be gone. Each
+    // write here returns only once the data is on the disk.
+
+#ifdef _WIN32
+
+    bool writeAll(HANDLE file, const unsigned char* data, size_t size) {
+        while (size > 0) {
+            DWORD chunk = (DWORD)std::min<size_t>(size, 1u << 30), written = 0;
+            if (!WriteFile(file, data, chunk, &written, nullptr) || written == 0) return false;
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    // Writes at `offset`, or at the end if there is none, then syncs
+    bool writeDurably(const std::string& path, const unsigned char* data, size_t size, std::optional<uint64_t> offset) {
+        HANDLE file = CreateFileA(path.c_str(), offset ? GENERIC_WRITE : FILE_APPEND_DATA, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER position;
+        position.QuadPart = offset ? (LONGLONG)*offset : 0;
+        bool ok = (!offset || SetFilePointerEx(file, position, nullptr, FILE_BEGIN)) && writeAll(file, data, size) &&
+                  FlushFileBuffers(file);
+        CloseHandle(file);
+        return ok;
+    }
+
+    // Writes a new file under a unique name next to `path`
+    std::optional<std::string> writeTempFile(const std::string& path, const unsigned char* data, size_t size) {
+        unsigned char random[6];
+        randombytes_buf(random, sizeof(random));
+        char suffix[2 * sizeof(random) + 1];
+        sodium_bin2hex(suffix, sizeof(suffix), random, sizeof(random));
+        std::string tmpPath = path + ".tmp." + suffix;
+
+        HANDLE file = CreateFileA(tmpPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return std::nullopt;
+        bool ok = writeAll(file, data, size) && FlushFileBuffers(file);
+        CloseHandle(file);
+        if (!ok) {
+            DeleteFileA(tmpPath.c_str());
+            return std::nullopt;
+        }
+        return tmpPath;
+    }
+
+    // Write-through: returns once the rename itself is on the disk
+    bool replaceFile(const std::string& tmpPath, const std::string& path) {
+        return MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+
+#else
+
+    bool writeAll(int fd, const unsigned char* data, size_t size, std::optional<uint64_t> offset) {
+        while (size > 0) {
+            ssize_t written = offset ? pwrite(fd, data, size, (off_t)*offset) : write(fd, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            data += written;
+            size -= (size_t)written;
+            if (offset) *offset += (uint64_t)written;
+        }
+        return true;
+    }
+
+    // Writes at `offset`, or at the end if there is none, then syncs
+    bool writeDurably(const std::string& path, const unsigned char* data, size_t size, std::optional<uint64_t> offset) {
+        int fd = open(path.c_str(), O_WRONLY | (offset ? 0 : O_APPEND));
+        if (fd < 0) return false;
+        bool ok = writeAll(fd, data, size, offset) && fsync(fd) == 0;
+        return close(fd) == 0 && ok;
+    }
+
+    // Writes a new file (owner-only, as mkstemp makes it) under a unique
+    // name next to `path`, so two processes saving at once can't share it
+    std::optional<std::string> writeTempFile(const std::string& path, const unsigned char* data, size_t size) {
+        std::string tmpPath = path + ".tmp.XXXXXX";
+        int fd = mkstemp(&tmpPath[0]);
+        if (fd < 0) return std::nullopt;
+        bool ok = writeAll(fd, data, size, std::nullopt) && fsync(fd) == 0;
+        ok = close(fd) == 0 && ok;
+        if (!ok) {
+            unlink(tmpPath.c_str());
+            return std::nullopt;
+        }
+        return tmpPath;
+    }
+
+    // Renames, then syncs the directory so the new entry survives a crash
+    bool replaceFile(const std::string& tmpPath, const std::string& path) {
+        if (rename(tmpPath.c_str(), path.c_str()) != 0) return false;
+        std::string dir = std::filesystem::path(path).parent_path().string();
+        int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) return false;
+        bool ok = fsync(fd) == 0;
+        close(fd);
+        return ok;
+    }
+
+#endif
+
+} // namespace
+
+bool VaultLog::hasHeader(const unsigned char* bytes, size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(bytes, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool VaultLog::readHeader(const unsigned char* bytes, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (size < HEADER_V1_BYTES || !hasHeader(bytes, size)) {
+        return false;
+    }
+
+    // 1. Current files: the data key's slots
+    if (bytes[4] == VERSION) {
+        if (size < HEADER_BYTES) {
+            return false;
+        }
+        std::vector<Crypto::Keyslot> slots;
+        for (size_t i = 0; i < MAX_KEYSLOTS; ++i) {
+            auto slot = getKeyslot(bytes + KEYSLOTS_OFFSET + i * KEYSLOT_BYTES);
+            if (!slot) {
+                return false;
+            }
+            slots.push_back(std::move(*slot));
+        }
+        m_version = VERSION;
+        m_keyslots = std::move(slots);
+        m_salt.clear();
+        m_kdf = Crypto::KdfParams::interactive();
+        m_fileId = getU64(bytes + 8);
+        m_headerBytes = HEADER_BYTES;
+        return true;
+    }
+
+    // 2. Older files: a key derived from the password and the header's salt
+    Crypto::KdfParams kdf = Crypto::KdfParams::interactive();
+    size_t headerBytes = HEADER_V1_BYTES;
+    if (bytes[4] == VERSION_V2) {
+        if (size < HEADER_V2_BYTES) {
+            return false;
+        }
+        kdf.algorithm = bytes[5];
+        kdf.opsLimit = getU64(bytes + HEADER_V1_BYTES);
+        kdf.memLimit = getU64(bytes + HEADER_V1_BYTES + 8);
+        headerBytes = HEADER_V2_BYTES;
+        if (!kdf.valid()) {
+            std::cerr << "Unsupported key derivation parameters in vault header." << std::endl;
+            return false;
+        }
+    } else if (bytes[4] != VERSION_V1) {
+        std::cerr << "Unsupported vault version " << (int)bytes[4] << "." << std::endl;
+        return false;
+    }
+
+    m_version = bytes[4];
+    m_keyslots.assign(MAX_KEYSLOTS, Crypto::Keyslot());
+    m_salt.assign(bytes + 8, bytes + 8 + Crypto::SALT_BYTES);
+    m_fileId = getU64(bytes + 8 + Crypto::SALT_BYTES);
+    m_kdf = kdf;
+    m_headerBytes = headerBytes;
+    return true;
+}
+
+std::optional<VaultLog::Contents> VaultLog::read(const std::string& filepath, const unsigned char* bytes, size_t size, const Crypto::KeyHandle& key) {
+    if (!readHeader(bytes, size)) {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_path.clear();
+
+    // A record's plaintext is never longer than its sealed bytes, so the file
+    // size bounds the arena; one allocation holds every record.
+    Contents contents;
+    contents.arena = Crypto::SecureBuffer(size - m_headerBytes);
+    size_t used = 0;
+    size_t pos = m_headerBytes;
+    uint64_t expectedSeq = 0;
+
+    while (pos < size) {
+        // 1. Frame the record. Anything that doesn't fit is a torn append.
+        if (size - pos < RECORD_PREFIX_BYTES) break;
+        uint32_t length = getU32(bytes + pos);
+        uint8_t kind = bytes[pos + 4];
+        if (size - pos - RECORD_PREFIX_BYTES < length) break;
+
+        // 2. Decrypt into the arena. A complete record that fails authentication
+        // means a wrong password (first record) or tampering (later ones);
+        // either way, stop.
+        const unsigned char* sealed = bytes + pos + RECORD_PREFIX_BYTES;
+        unsigned char* plaintext = contents.arena.data() + used;
+        size_t plaintextSize = 0;
+        bool opened = false;
+        if (kind == KIND_SECRETBOX) {
+            opened = Crypto::openTo(plaintext, sealed, length, key);
+            plaintextSize = opened ? length - Crypto::SEAL_OVERHEAD_BYTES : 0;
+        } else if (kind == KIND_CHUNKED) {
+            auto openedSize = Crypto::openChunkedTo(plaintext, contents.arena.size() - used, sealed, length, key, ThreadPool::shared());
+            opened = openedSize.has_value();
+            plaintextSize = opened ? *openedSize : 0;
+        } else {
+            std::cerr << "Unknown vault record kind " << (int)kind << "." << std::endl;
+            return std::nullopt;
+        }
+        if (!opened || plaintextSize < PLAINTEXT_PREFIX_BYTES) {
+            return std::nullopt;
+        }
+
+        // 3. Check the record belongs here. This catches reordered, spliced
+        // and missing records, but not missing trailing ones (see VaultLog.h).
+        uint64_t fileId = getU64(plaintext);
+        uint64_t seq = getU64(plaintext + 8);
+        Op op = (Op)plaintext[16];
+        if (fileId != m_fileId || seq != expectedSeq) {
+            std::cerr << "Vault record out of sequence (file tampered with?)." << std::endl;
+            return std::nullopt;
+        }
+        if ((seq == 0) != (op == Op::Snapshot)) {
+            std::cerr << "Vault log does not start with a snapshot." << std::endl;
+            return std::nullopt;
+        }
+
+        contents.records.push_back(RecordView{ op, std::string_view((const char*)plaintext + PLAINTEXT_PREFIX_BYTES, plaintextSize - PLAINTEXT_PREFIX_BYTES) });
+        used += plaintextSize;
+        ++expectedSeq;
+        pos += RECORD_PREFIX_BYTES + length;
+    }
+
+    if (contents.records.empty()) {
+        std::cerr << "Vault log has no snapshot." << std::endl;
+        return std::nullopt;
+    }
+    if (pos < size) {
+        std::cerr << "Ignoring " << (size - pos) << " bytes of incomplete vault record at end of file." << std::endl;
+    }
+
+    m_path = filepath;
+    m_nextSeq = expectedSeq;
+    m_validLength = pos;
+    m_appended = contents.records.size() - 1;
+    m_keyCheck = Crypto::seal(nullptr, 0, key);
+    return contents;
+}
+
+std::vector<unsigned char> VaultLog::encodeRecord(Op op, const std::string& payload, const Crypto::KeyHandle& key) {
+    std::vector<unsigned char> plaintext;
+    plaintext.reserve(PLAINTEXT_PREFIX_BYTES + payload.size());
+    putU64(plaintext, m_fileId);
+    putU64(plaintext, m_nextSeq++);
+    plaintext.push_back((unsigned char)op);
+    plaintext.insert(plaintext.end(), payload.begin(), payload.end());
+
+    // Big records (snapshots) are split into chunks encrypted on every core
+    bool chunked = plaintext.size() > Crypto::CHUNK_BYTES;
+    std::vector<unsigned char> sealed = chunked
+        ? Crypto::sealChunked(plaintext.data(), plaintext.size(), key, ThreadPool::shared())
+        : Crypto::seal(plaintext.data(), plaintext.size(), key);
+    sodium_memzero(plaintext.data(), plaintext.size());
+    if (sealed.size() > UINT32_MAX) {
+        throw std::runtime_error("Vault record too large");
+    }
+
+    std::vector<unsigned char> record;
+    record.reserve(RECORD_PREFIX_BYTES + sealed.size());
+    putU32(record, (uint32_t)sealed.size());
+    record.push_back(chunked ? KIND_CHUNKED : KIND_SECRETBOX);
+    record.insert(record.end(), sealed.begin(), sealed.end());
+    return record;
+}
+
+bool VaultLog::append(const std::vector<Record>& records, const Crypto::KeyHandle& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_path.empty() || records.empty()) {
+        return !m_path.empty();
+    }
+
+    // 1. Only append with the key the file was written with
+    if (!Crypto::open(m_keyCheck.data(), m_keyCheck.size(), key)) {
+        return false;
+    }
+
+    // 2. Only append if nobody (including a torn write of ours) touched the file
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(m_path, ec);
+    if (ec || size != m_validLength) {
+        return false;
+    }
+
+    // 3. Encode everything first so the file sees a single write
+    uint64_t firstSeq = m_nextSeq;
+    std::vector<unsigned char> buffer;
+    {
+        Diagnostics::ScopedTimer timer("log.encrypt");
+        for (const auto& record : records) {
+            std::vector<unsigned char> encoded = encodeRecord(record.op, record.payload, key);
+            buffer.insert(buffer.end(), encoded.begin(), encoded.end());
+            timer.addBytes(record.payload.size());
+        }
+    }
+
+    Diagnostics::ScopedTimer writing("log.write_file", buffer.size());
+    if (!writeDurably(m_path, buffer.data(), buffer.size(), std::nullopt)) {
+        // Part of the buffer may be on disk; the size check above will force
+        // the next save to compact.
+        m_nextSeq = firstSeq;
+        m_validLength = UINT64_MAX;
+        return false;
+    }
+
+    m_validLength += buffer.size();
+    m_appended += records.size();
+    return true;
+}
+
+bool VaultLog::rewrite(const std::string& filepath, const Crypto::KeyHandle& key, const std::string& snapshot) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!hasKeyslot(m_keyslots)) {
+        // Nothing could ever open the file again
+        std::cerr << "Cannot write vault file: no keyslots." << std::endl;
+        return false;
+    }
+
+    // 1. Start a new generation of the file
+    m_fileId = randomFileId();
+    m_nextSeq = 0;
+
+    std::vector<unsigned char> buffer(MAGIC, MAGIC + sizeof(MAGIC));
+    buffer.push_back(VERSION);
+    buffer.insert(buffer.end(), 3, 0);
+    putU64(buffer, m_fileId);
+    std::vector<unsigned char> slots = encodeKeyslots(m_keyslots);
+    buffer.insert(buffer.end(), slots.begin(), slots.end());
+
+    {
+        Diagnostics::ScopedTimer timer("log.encrypt", snapshot.size());
+        std::vector<unsigned char> record = encodeRecord(Op::Snapshot, snapshot, key);
+        buffer.insert(buffer.end(), record.begin(), record.end());
+    }
+
+    // 2. Write to a temp file, sync it, and rename it over the old one, so a
+    // crash or power cut mid-write never leaves a half-written vault behind
+    Diagnostics::ScopedTimer writing("log.write_file", buffer.size());
+    std::optional<std::string> tmpPath = writeTempFile(filepath, buffer.data(), buffer.size());
+    if (!tmpPath) {
+        std::cerr << "Failed to write vault file." << std::endl;
+        resetLocked();
+        return false;
+    }
+    if (!replaceFile(*tmpPath, filepath)) {
+        std::cerr << "Failed to replace vault file." << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(*tmpPath, ec); // Gone already if only the directory sync failed
+        resetLocked();
+        return false;
+    }
+
+    writing.stop();
+
+    // 3. Attach to the new file
+    m_path = filepath;
+    m_version = VERSION;
+    m_salt.clear();
+    m_kdf = Crypto::KdfParams::interactive();
+    m_headerBytes = HEADER_BYTES;
+    m_validLength = buffer.size();
+    m_appended = 0;
+    m_keyCheck = Crypto::seal(nullptr, 0, key);
+    return true;
+}
+
+bool VaultLog::updateKeyslots(const std::vector<Crypto::Keyslot>& slots) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (slots.size() > MAX_KEYSLOTS) {
+        return false;
+    }
+    std::vector<Crypto::Keyslot> padded = slots;
+    padded.resize(MAX_KEYSLOTS);
+
+    // 1. Not attached to a file with a slot table: the next rewrite() writes them
+    if (m_path.empty() || m_version != VERSION) {
+        m_keyslots = std::move(padded);
+        return true;
+    }
+
+    // 2. Otherwise overwrite the table in place, leaving the records alone,
+    // if the file is still the one we know (as append() checks)
+    if (!hasKeyslot(padded)) {
+        std::cerr << "Cannot remove the last keyslot." << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(m_path, ec);
+    if (ec || size != m_validLength) {
+        std::cerr << "Vault file changed on disk; not updating its keyslots." << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> table = encodeKeyslots(padded);
+    if (!writeDurably(m_path, table.data(), table.size(), KEYSLOTS_OFFSET)) {
+        std::cerr << "Failed to write vault keyslots." << std::endl;
+        return false;
+    }
+
+    m_keyslots = std::move(padded);
+    return true;
+}
+
+void VaultLog::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    resetLocked();
+}
+
+void VaultLog::resetLocked() {
+    m_path.clear();
+    m_version = 0;
+    m_salt.clear();
+    m_kdf = Crypto::KdfParams::interactive();
+    m_headerBytes = 0;
+    m_fileId = 0;
+    m_nextSeq = 0;
+    m_validLength = 0;
+    m_appended = 0;
+    m_keyCheck.clear();
+}
+
+bool VaultLog::isAttachedTo(const std::string& filepath) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_path.empty() && m_path == filepath;
+}
+
+Crypto::KdfParams VaultLog::kdfParams() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_kdf;
+}
+
+std::vector<unsigned char> VaultLog::salt() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_salt;
+}
+
+std::vector<Crypto::Keyslot> VaultLog::keyslots() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_keyslots;
+}
+
+bool VaultLog::usesKeyslots() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version == VERSION;
+}
+
+size_t VaultLog::headerBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_headerBytes;
+}
+
+size_t VaultLog::appendedRecords() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_appended;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+
+#include "Crypto.h"
+
+/**
+ * @brief The on-disk vault format: a small plaintext header followed by an
+ * append-only sequence of individually encrypted records.
+ *
+ * Header: [MAGIC "CVLT"][VERSION (3)][RESERVED (3)][FILE ID (8)][KEYSLOT (112)] x 4
+ * Keyslot: [KIND (1)][KDF ALGORITHM (1)][RESERVED (6)][OPSLIMIT (8)][MEMLIMIT (8)]
+ *          [SALT (16)][WRAPPED KEY (72)], all zeros when empty
+ * Records are encrypted with a random data key; each keyslot holds it wrapped
+ * under one secret (Crypto::Keyslot). The slot table has a fixed size and
+ * place, so changing a secret overwrites its slot and nothing else.
+ *
+ * Older headers carry no slots: the key is derived from the password and the
+ * header's salt. Version 2 is [MAGIC][VERSION (2)][KDF ALGORITHM (1)]
+ * [RESERVED (2)][SALT (16)][FILE ID (8)][OPSLIMIT (8)][MEMLIMIT (8)]; version
+ * 1 stops after the file id and implies Crypto::KdfParams::interactive().
+ * Both are still read; Vault rewrites them as version 3 on the next save.
+ *
+ * Record: [LENGTH (4, LE)][KIND (1)][SEALED PLAINTEXT]
+ * KIND 1 is a Crypto::seal box ([NONCE (24)][CIPHERTEXT]); records larger than
+ * one chunk use KIND 2, a Crypto::sealChunked container decrypted in parallel.
+ *
+ * Every record plaintext starts with [FILE ID (8)][SEQ (8)][OP (1)], so records
+ * can't be reordered, dropped from the middle or spliced in from an older
+ * generation of the file without failing the load.
+ *
+ * Limit: nothing records how many records were committed, so a file cut
+ * back at a record boundary (whole trailing records lost, or the file rolled
+ * back to an older length) loads silently as the older vault it then is.
+ * Appends are synced before they're reported saved, so a crash alone
+ * doesn't do this; damage or tampering can. Only a torn last record is
+ * detected (and dropped with a warning). A whole-file rollback to an older
+ * copy can't be detected from the file alone either way.
+ *
+ * The first record is always a Snapshot of every entry. Add/edit/delete append
+ * a small Put or Delete record; compaction rewrites the file as a fresh header
+ * plus one Snapshot. Payloads are encoded with EntryCodec (older files: JSON);
+ * the log itself treats them as opaque bytes.
+ *
+ * All methods are thread-safe, so a background saver can write while the UI
+ * thread inspects the log.
+ */
+class VaultLog {
+public:
+    VaultLog() = default;
+    VaultLog(const VaultLog&) = delete;
+    VaultLog& operator=(const VaultLog&) = delete;
+
+    enum class Op : uint8_t {
+        Snapshot = 1, // payload: every entry
+        Put = 2,      // payload: one entry (insert or replace by id)
+        Delete = 3    // payload: the id
+    };
+
+    struct Record {
+        Op op;
+        std::string payload;
+    };
+
+    /**
+     * @brief A decrypted record, as returned by read(). The payload points into
+     * the Contents' arena rather than owning a copy.
+     */
+    struct RecordView {
+        Op op;
+        std::string_view payload;
+    };
+
+    /**
+     * @brief Every decrypted record of a file. All plaintexts share one
+     * SecureBuffer, so they live in locked memory and are wiped together when
+     * this is destroyed.
+     */
+    struct Contents {
+        Crypto::SecureBuffer arena;
+        std::vector<RecordView> records;
+    };
+
+    static constexpr size_t MAX_KEYSLOTS = 4;
+
+    /**
+     * @brief Checks whether a file's bytes start with the log header.
+     * Files without it are treated as the legacy [SALT][NONCE][CIPHERTEXT] blob.
+     */
+    static bool hasHeader(const unsigned char* bytes, size_t size);
+
+    /**
+     * @brief Decrypts every record of a log file and attaches to it, so that
+     * later saves can append instead of rewriting.
+     * Each record is decrypted straight from `bytes` (typically a MappedFile)
+     * into the arena; nothing else holds a copy of the plaintext.
+     * A torn record at the end (crash during append) is dropped with a warning.
+     * @param filepath The file the bytes were read from.
+     * @param bytes The whole file.
+     * @param key The data key (unwrapped from a keyslot), or for version 1/2
+     * files the key derived from the password and salt().
+     * @return The records in order, or std::nullopt on a wrong key or tampering.
+     */
+    std::optional<Contents> read(const std::string& filepath, const unsigned char* bytes, size_t size, const Crypto::KeyHandle& key);
+
+    /**
+     * @brief Parses only the header, so the caller can unwrap the key from
+     * keyslots() (or, if !usesKeyslots(), derive it from salt() and kdfParams()).
+     * @return False if the header is malformed or an unknown version.
+     */
+    bool readHeader(const unsigned char* bytes, size_t size);
+
+    /**
+     * @brief Appends records to the attached file.
+     * Refuses (returns false) if the file changed on disk since it was last read
+     * or written, or if the key differs from the one the file was written with.
+     * Returns once the records are synced to disk.
+     */
+    bool append(const std::vector<Record>& records, const Crypto::KeyHandle& key);
+
+    /**
+     * @brief Compaction: atomically replaces the file with a new (version 3)
+     * header carrying keyslots() and one Snapshot record, then attaches to it.
+     * The new file and the rename are both synced to disk before it returns.
+     * @param key The data key the keyslots wrap.
+     * @return False on I/O failure, or if every keyslot is empty.
+     */
+    bool rewrite(const std::string& filepath, const Crypto::KeyHandle& key, const std::string& snapshot);
+
+    /**
+     * @brief Replaces the keyslots (at most MAX_KEYSLOTS; the rest are empty).
+     * If attached to a version 3 file, overwrites its slot table in place and
+     * refuses (returns false) when the file changed on disk or every slot
+     * would be empty; otherwise they're kept for the next rewrite().
+     */
+    bool updateKeyslots(const std::vector<Crypto::Keyslot>& slots);
+
+    /**
+     * @brief Forgets the attached file; the keyslots stay.
+     */
+    void reset();
+
+    bool isAttachedTo(const std::string& filepath) const;
+
+    /**
+     * @brief Always MAX_KEYSLOTS long, empty ones included, in file order.
+     */
+    std::vector<Crypto::Keyslot> keyslots() const;
+
+    /**
+     * @brief True if the header read or written last is version 3 (keyslots).
+     */
+    bool usesKeyslots() const;
+
+    // Version 1/2 headers only: the password's salt and derivation costs
+    std::vector<unsigned char> salt() const;
+    Crypto::KdfParams kdfParams() const;
+
+    /**
+     * @brief Size of the header read or written last; records start here.
+     */
+    size_t headerBytes() const;
+
+    /**
+     * @brief Number of Put/Delete records written since the last Snapshot.
+     * Vault uses this to decide when to compact.
+     */
+    size_t appendedRecords() const;
+
+private:
+    void resetLocked();
+    std::vector<unsigned char> encodeRecord(Op op, const std::string& payload, const Crypto::KeyHandle& key);
+
+    mutable std::mutex m_mutex;
+    std::string m_path;
+    uint8_t m_version = 0;
+    std::vector<Crypto::Keyslot> m_keyslots = std::vector<Crypto::Keyslot>(MAX_KEYSLOTS);
+    std::vector<unsigned char> m_salt;
+    Crypto::KdfParams m_kdf;
+    size_t m_headerBytes = 0; // Depends on the version
+    uint64_t m_fileId = 0;
+    uint64_t m_nextSeq = 0;
+    uint64_t m_validLength = 0; // Bytes of the file we've verified or written
+    size_t m_appended = 0;
+    std::vector<unsigned char> m_keyCheck; // Empty record sealed under the file's key
+};
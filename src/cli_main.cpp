@@ -0,0 +1,728 @@
+// cppvault-cli: scripted access to a vault, without a window.
+// Links only the core (Vault, Crypto and friends), not ImGui/GLFW/OpenGL.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "BreachAudit.h"
+#include "Crypto.h"
+#include "Diagnostics.h"
+#include "Importer.h"
+#include "PasswordGenerator.h"
+#include "ThreadPool.h"
+#include "Vault.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+void to_json(json& j, const EntryRef& p); // Defined in Vault.cpp
+
+// --- Options ---
+
+struct Options {
+    std::string vaultPath = "vault.db";
+    std::string passwordFile;    // Empty: CPPVAULT_PASSWORD, else prompt
+    std::string newPasswordFile; // passwd: empty prompts; reencrypt: empty keeps the password
+    bool reveal = false;         // query prints passwords too
+    bool dropRecoveryKey = false; // reencrypt may discard the recovery key
+    double kdfMs = Crypto::DEFAULT_UNLOCK_MS; // Unlock time new keys are calibrated for
+    bool diagnostics = false;    // Print per-phase timings to stderr at exit
+    std::string diagnosticsLog;  // Also write them as JSON lines to this file
+};
+
+// --- Helper Functions ---
+
+static void PrintUsage() {
+    std::cerr <<
+        "Usage: cppvault-cli [options] <command> [arguments]\n"
+        "\n"
+        "Commands (each runs under one unlock and ends with at most one save):\n"
+        "  query [TEXT]               Print matching entries as JSON lines (all if TEXT is empty)\n"
+        "  add --title T [--username U] [--password P] [--url URL] [--notes N] [--id ID]\n"
+        "                             Add an entry (or replace the one with ID)\n"
+        "  delete ID                  Delete an entry\n"
+        "  import FILE                Add every entry from a CSV or JSON export (browsers, other managers)\n"
+        "  export FILE                Write every entry, decrypted, to FILE as JSON\n"
+        "  passwd                     Change the master password (--new-password-file, else a prompt).\n"
+        "                             Rewrites only the vault header, whatever the vault's size.\n"
+        "  recovery-key               Create a recovery key, printed once, that unlocks the vault in\n"
+        "                             place of the master password (replaces any earlier one)\n"
+        "  remove-recovery-key        Remove the recovery key\n"
+        "  reencrypt                  Rewrite the vault under a fresh data key, with key derivation\n"
+        "                             costs recalibrated for this machine (and --new-password-file).\n"
+        "                             The recovery key can't open the new key: if the vault has one,\n"
+        "                             pass --drop-recovery-key, or run recovery-key in the same batch.\n"
+        "  generate [--count N] [--length N] [--classes ULNS] [--charset CHARS]\n"
+        "           [--words N] [--wordlist FILE] [--separator S]\n"
+        "                             Print N new passwords (default 1), one per line; no vault needed.\n"
+        "                             Characters come from the classes (Upper, Lower, Numbers,\n"
+        "                             Symbols; default all) or CHARS. --words makes passphrases\n"
+        "                             from FILE (one word per line) or a built-in list of 256.\n"
+        "  audit CORPUS [BLOOM]       Check every password against a local, sorted SHA-1 breach list\n"
+        "                             (e.g. Pwned Passwords ordered by hash, SHA1:COUNT lines, or\n"
+        "                             packed 20-byte digests); prints {\"id\",\"title\",\"count\"} lines\n"
+        "                             for the ones found. Offline; the list is memory-mapped.\n"
+        "  bloom CORPUS OUT [BITS]    Build a Bloom filter for audit from CORPUS, BITS per hash\n"
+        "                             (default 10, about 1% false positives); no vault needed.\n"
+        "  batch FILE                 Run the operations in FILE ('-' for stdin), one JSON object\n"
+        "                             per line: {\"op\":\"add\",\"title\":...}, {\"op\":\"delete\",\"id\":N},\n"
+        "                             {\"op\":\"query\",\"text\":...}, {\"op\":\"import\",\"path\":...},\n"
+        "                             {\"op\":\"export\",\"path\":...}, {\"op\":\"reencrypt\"}, {\"op\":\"passwd\"},\n"
+        "                             {\"op\":\"recovery-key\"}, {\"op\":\"remove-recovery-key\"},\n"
+        "                             {\"op\":\"audit\",\"path\":...,\"bloom\":...}.\n"
+        "                             If any fails, nothing is saved.\n"
+        "\n"
+        "Options:\n"
+        "  --vault PATH               Vault file (default: vault.db). Created by add/batch if missing.\n"
+        "  --password-file FILE       Read the master password from FILE's first line.\n"
+        "                             Otherwise CPPVAULT_PASSWORD, otherwise a prompt.\n"
+        "                             The recovery key works here too.\n"
+        "  --new-password-file FILE   New master password for passwd and reencrypt\n"
+        "  --kdf-ms MS                Unlock time to calibrate new keys for (default: 500)\n"
+        "  --reveal                   Include passwords in query output\n"
+        "  --drop-recovery-key        Let reencrypt remove the vault's recovery key\n"
+        "  --diagnostics              Print where the time went (unlock, save, crypto) to stderr\n"
+        "  --diagnostics-log FILE     Append those timings to FILE as JSON lines\n";
+}
+
+// Prints the per-phase totals when it goes out of scope, however main returns
+struct DiagnosticsReport {
+    bool enabled;
+
+    ~DiagnosticsReport() {
+        if (!enabled) return;
+        std::fprintf(stderr, "%-24s %8s %12s %12s %12s\n", "phase", "calls", "total ms", "max ms", "bytes");
+        for (const auto& phase : Diagnostics::stats()) {
+            std::fprintf(stderr, "%-24s %8llu %12.2f %12.2f %12llu\n", phase.name.c_str(),
+                (unsigned long long)phase.calls, phase.totalMs, phase.maxMs, (unsigned long long)phase.bytes);
+        }
+    }
+};
+
+// Reads one line from the terminal without echoing it
+static std::string PromptPassword(const std::string& prompt) {
+    std::cerr << prompt << std::flush;
+    std::string password;
+#ifdef _WIN32
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    DWORD mode = 0;
+    bool console = GetConsoleMode(input, &mode) != 0;
+    if (console) SetConsoleMode(input, mode & ~ENABLE_ECHO_INPUT);
+    std::getline(std::cin, password);
+    if (console) SetConsoleMode(input, mode);
+#else
+    termios saved;
+    bool terminal = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (terminal) {
+        termios quiet = saved;
+        quiet.c_lflag &= ~ECHO;
+        tcsetattr(STDIN_FILENO, TCSANOW, &quiet);
+    }
+    std::getline(std::cin, password);
+    if (terminal) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+#endif
+    std::cerr << std::endl;
+    return password;
+}
+
+static bool ReadPasswordFile(const std::string& path, std::string& password) {
+    std::ifstream file(path);
+    if (!file || !std::getline(file, password)) {
+        std::cerr << "Failed to read password from " << path << "." << std::endl;
+        return false;
+    }
+    if (!password.empty() && password.back() == '\r') {
+        password.pop_back();
+    }
+    return true;
+}
+
+static bool GetMasterPassword(const Options& options, std::string& password) {
+    if (!options.passwordFile.empty()) {
+        return ReadPasswordFile(options.passwordFile, password);
+    }
+    if (const char* env = std::getenv("CPPVAULT_PASSWORD")) {
+        password = env;
+        return true;
+    }
+    password = PromptPassword("Master password: ");
+    return true;
+}
+
+static bool GetNewPassword(const Options& options, std::string& password) {
+    if (!options.newPasswordFile.empty()) {
+        return ReadPasswordFile(options.newPasswordFile, password);
+    }
+    password = PromptPassword("New master password: ");
+    std::string repeated = PromptPassword("Repeat new master password: ");
+    bool same = password == repeated;
+    Crypto::wipe(repeated);
+    if (!same || password.empty()) {
+        std::cerr << (same ? "The new password is empty." : "The passwords don't match.") << std::endl;
+        Crypto::wipe(password);
+        return false;
+    }
+    return true;
+}
+
+static void PrintKdf(const Crypto::KdfParams& kdf) {
+    std::cerr << "Key derivation: Argon2id, " << kdf.opsLimit << " passes over "
+              << (kdf.memLimit >> 20) << " MiB." << std::endl;
+}
+
+// Builds a batch operation from a command line subcommand
+static bool ParseCommand(const std::vector<std::string>& args, json& op) {
+    const std::string& command = args[0];
+    if (command == "query") {
+        op = { {"op", "query"}, {"text", args.size() > 1 ? args[1] : ""} };
+        return args.size() <= 2;
+    }
+    if (command == "delete" && args.size() == 2) {
+        try {
+            op = { {"op", "delete"}, {"id", std::stoull(args[1])} };
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid entry id: " << args[1] << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if ((command == "export" || command == "import") && args.size() == 2) {
+        op = { {"op", command}, {"path", args[1]} };
+        return true;
+    }
+    if ((command == "reencrypt" || command == "passwd" || command == "recovery-key" || command == "remove-recovery-key") && args.size() == 1) {
+        op = { {"op", command} };
+        return true;
+    }
+    if (command == "audit" && (args.size() == 2 || args.size() == 3)) {
+        op = { {"op", "audit"}, {"path", args[1]} };
+        if (args.size() == 3) op["bloom"] = args[2];
+        return true;
+    }
+    if (command == "add") {
+        op = { {"op", "add"} };
+        for (size_t i = 1; i + 1 < args.size(); i += 2) {
+            std::string field = args[i].rfind("--", 0) == 0 ? args[i].substr(2) : "";
+            if (field == "id") {
+                try {
+                    op["id"] = std::stoull(args[i + 1]);
+                }
+                catch (const std::exception&) {
+                    std::cerr << "Invalid entry id: " << args[i + 1] << std::endl;
+                    return false;
+                }
+            } else if (field == "title" || field == "username" || field == "password" || field == "url" || field == "notes") {
+                op[field] = args[i + 1];
+            } else {
+                std::cerr << "Unknown add option: " << args[i] << std::endl;
+                return false;
+            }
+        }
+        return args.size() % 2 == 1;
+    }
+    return false;
+}
+
+// --- Generating ---
+
+static bool ParseCount(const std::string& text, size_t& value) {
+    try {
+        size_t used = 0;
+        value = std::stoull(text, &used);
+        return used == text.size();
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+// `generate`: a batch of passwords or passphrases, written in one go
+static int RunGenerate(const std::vector<std::string>& args) {
+    size_t count = 1, length = 20, words = 0;
+    std::string classes = "ULNS", customCharset, wordlistPath, separator = "-";
+    for (size_t i = 1; i < args.size(); i += 2) {
+        if (i + 1 >= args.size()) {
+            std::cerr << "generate: " << args[i] << " needs a value." << std::endl;
+            return 2;
+        }
+        const std::string& name = args[i];
+        const std::string& value = args[i + 1];
+        bool ok = true;
+        if (name == "--count") ok = ParseCount(value, count);
+        else if (name == "--length") ok = ParseCount(value, length);
+        else if (name == "--words") ok = ParseCount(value, words);
+        else if (name == "--classes") classes = value;
+        else if (name == "--charset") customCharset = value;
+        else if (name == "--wordlist") wordlistPath = value;
+        else if (name == "--separator") separator = value;
+        else {
+            std::cerr << "Unknown generate option: " << name << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "generate: " << name << " needs a number." << std::endl;
+            return 2;
+        }
+    }
+
+    // 1. One batch, from one buffer of randomness
+    std::optional<PasswordGenerator::Batch> batch;
+    if (words > 0 || !wordlistPath.empty()) {
+        std::optional<std::vector<std::string>> wordlist;
+        if (!wordlistPath.empty()) {
+            wordlist = PasswordGenerator::loadWordlist(wordlistPath);
+            if (!wordlist) {
+                std::cerr << "generate: failed to read words from " << wordlistPath << "." << std::endl;
+                return 1;
+            }
+        }
+        batch = PasswordGenerator::generatePassphrases(wordlist ? *wordlist : PasswordGenerator::defaultWordlist(),
+            words > 0 ? words : 6, separator, count);
+    } else {
+        std::string charset = customCharset;
+        if (charset.empty()) {
+            auto has = [&](char c) { return classes.find(c) != std::string::npos || classes.find((char)std::tolower(c)) != std::string::npos; };
+            charset = PasswordGenerator::charset(PasswordGenerator::classMask(has('U'), has('L'), has('N'), has('S')));
+        }
+        batch = PasswordGenerator::generateBatch(charset, length, count);
+    }
+    if (!batch) {
+        std::cerr << "generate: nothing to generate from (empty charset or word list, or zero length)." << std::endl;
+        return 2;
+    }
+
+    // 2. Print them, then wipe our copies
+    std::string out;
+    for (auto& password : batch->passwords) {
+        out += password;
+        out += '\n';
+        Crypto::wipe(password);
+    }
+    std::cout << out << std::flush;
+    Crypto::wipe(out);
+    std::fprintf(stderr, "Generated %zu (%.1f bits of entropy each, from %zu %s).\n", count, batch->entropyBits,
+        batch->alphabetSize, words > 0 || !wordlistPath.empty() ? "words" : "characters");
+    return 0;
+}
+
+// `bloom`: a prefilter for audit, built once per corpus download
+static int RunBloom(const std::vector<std::string>& args) {
+    if (args.size() != 3 && args.size() != 4) {
+        PrintUsage();
+        return 2;
+    }
+    double bitsPerHash = 10.0;
+    if (args.size() == 4) {
+        bitsPerHash = std::atof(args[3].c_str());
+        if (bitsPerHash < 1.0) {
+            std::cerr << "bloom: BITS needs a number of at least 1." << std::endl;
+            return 2;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!BreachAudit::buildBloomFilter(args[1], args[2], ThreadPool::shared(), bitsPerHash)) {
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Wrote " << args[2] << " (" << std::filesystem::file_size(args[2]) << " bytes) in " << (int)ms << " ms." << std::endl;
+    return 0;
+}
+
+// --- Batch Execution ---
+
+// State carried across the operations of one batch
+struct Batch {
+    Vault& vault;
+    const Options& options;
+    size_t added = 0;
+    size_t deleted = 0;
+    bool changed = false;    // Needs a save
+    bool reencrypt = false;  // Save as a full rewrite under a new key
+    // Keyslot changes, made after the other operations succeed. They write
+    // the vault header themselves.
+    bool passwd = false;
+    bool removeRecoveryKey = false;
+    bool createRecoveryKey = false;
+};
+
+static void PrintEntry(EntryRef entry, bool reveal) {
+    json j = entry;
+    if (!reveal) {
+        j.erase("password");
+    }
+    std::cout << j.dump() << "\n";
+}
+
+static bool ApplyOperation(Batch& batch, const json& op) {
+    Vault& vault = batch.vault;
+    std::string name = op.value("op", "");
+
+    if (name == "query") {
+        std::string text = op.value("text", "");
+        if (text.find_first_not_of(" \t") == std::string::npos) {
+            for (EntryRef entry : vault.entries()) {
+                PrintEntry(entry, batch.options.reveal);
+            }
+        } else {
+            for (EntryHandle handle : vault.search(text)) {
+                PrintEntry(vault.getEntry(handle), batch.options.reveal);
+            }
+        }
+        return true;
+    }
+
+    if (name == "add") {
+        PasswordEntry entry;
+        entry.id = op.contains("id") ? op["id"].get<uint64_t>() : vault.newEntryId();
+        entry.title = op.value("title", "");
+        entry.username = op.value("username", "");
+        entry.password = op.value("password", "");
+        entry.url = op.value("url", "");
+        entry.notes = op.value("notes", "");
+        if (entry.title.empty()) {
+            std::cerr << "add: an entry needs a title." << std::endl;
+            return false;
+        }
+        vault.addEntry(entry);
+        Crypto::wipe(entry.password);
+        ++batch.added;
+        batch.changed = true;
+        return true;
+    }
+
+    if (name == "delete") {
+        uint64_t id = op.at("id").get<uint64_t>();
+        if (vault.findEntry(id).isNull()) {
+            std::cerr << "delete: no entry with id " << id << "." << std::endl;
+            return false;
+        }
+        vault.deleteEntry(id);
+        ++batch.deleted;
+        batch.changed = true;
+        return true;
+    }
+
+    if (name == "import") {
+        std::string path = op.at("path").get<std::string>();
+        auto result = Importer::parseFile(path, ThreadPool::shared());
+        if (!result) {
+            return false;
+        }
+        size_t count = vault.importEntries(std::move(result->entries));
+        std::cerr << "Imported " << count << " entries from " << path << " (" << result->skippedRows << " empty rows skipped)." << std::endl;
+        batch.added += count;
+        batch.changed = batch.changed || count > 0;
+        return true;
+    }
+
+    if (name == "export") {
+        std::string path = op.at("path").get<std::string>();
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        json entries = json::array();
+        for (EntryRef entry : vault.entries()) {
+            entries.push_back(entry);
+        }
+        file << entries.dump(4);
+        if (!file.flush()) {
+            std::cerr << "export: failed to write " << path << "." << std::endl;
+            return false;
+        }
+        std::cerr << "Exported " << vault.entries().size() << " entries to " << path << " (unencrypted)." << std::endl;
+        return true;
+    }
+
+    if (name == "audit") {
+        std::string path = op.at("path").get<std::string>();
+        std::string bloomPath = op.value("bloom", "");
+        BreachAudit audit;
+        if (!audit.open(path) || (!bloomPath.empty() && !audit.openBloomFilter(bloomPath))) {
+            return false;
+        }
+        BreachAudit::Report report = audit.audit(vault.entries(), ThreadPool::shared());
+        for (const auto& finding : report.findings) {
+            EntryRef entry = vault.getEntry(vault.findEntry(finding.entryId));
+            std::cout << json{ {"id", finding.entryId}, {"title", entry ? entry.title() : ""}, {"count", finding.count} }.dump() << "\n";
+        }
+        std::cerr << "Checked " << report.checked << " passwords: " << report.findings.size() << " found in " << path
+                  << " (" << report.corpusLookups << " needed the corpus)." << std::endl;
+        return true;
+    }
+
+    if (name == "reencrypt") {
+        // Attachment files are encrypted with the vault key and would be left
+        // unreadable by a new one
+        for (EntryRef entry : vault.entries()) {
+            if (!entry.attachments().empty()) {
+                std::cerr << "reencrypt: vaults with attachments can't be re-encrypted yet." << std::endl;
+                return false;
+            }
+        }
+        batch.reencrypt = true;
+        batch.changed = true;
+        return true;
+    }
+
+    if (name == "passwd" || name == "recovery-key" || name == "remove-recovery-key") {
+        if (!std::filesystem::exists(batch.options.vaultPath)) {
+            std::cerr << name << ": there is no vault at " << batch.options.vaultPath << " yet." << std::endl;
+            return false;
+        }
+        if (name == "passwd") {
+            batch.passwd = true;
+        } else if (name == "recovery-key") {
+            batch.createRecoveryKey = true;
+            batch.removeRecoveryKey = false;
+        } else {
+            batch.removeRecoveryKey = true;
+            batch.createRecoveryKey = false;
+        }
+        return true;
+    }
+
+    std::cerr << "Unknown operation: " << op.dump() << std::endl;
+    return false;
+}
+
+static bool ReadBatchFile(const std::string& path, std::vector<json>& ops) {
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "Failed to open batch file " << path << "." << std::endl;
+            return false;
+        }
+    }
+    std::istream& in = path == "-" ? std::cin : file;
+
+    std::string line;
+    for (size_t number = 1; std::getline(in, line); ++number) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        try {
+            ops.push_back(json::parse(line));
+        }
+        catch (const json::exception& e) {
+            std::cerr << path << ":" << number << ": " << e.what() << std::endl;
+            return false;
+        }
+        if (!ops.back().is_object()) {
+            std::cerr << path << ":" << number << ": expected a JSON object." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Main ---
+
+int main(int argc, char** argv) {
+    // 1. Parse the options, then the command
+    Options options;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--vault" && hasValue) {
+            options.vaultPath = argv[++i];
+        } else if (arg == "--password-file" && hasValue) {
+            options.passwordFile = argv[++i];
+        } else if (arg == "--new-password-file" && hasValue) {
+            options.newPasswordFile = argv[++i];
+        } else if (arg == "--reveal") {
+            options.reveal = true;
+        } else if (arg == "--drop-recovery-key") {
+            options.dropRecoveryKey = true;
+        } else if (arg == "--kdf-ms" && hasValue) {
+            options.kdfMs = std::atof(argv[++i]);
+            if (options.kdfMs <= 0.0) {
+                std::cerr << "--kdf-ms needs a positive number of milliseconds." << std::endl;
+                return 2;
+            }
+        } else if (arg == "--diagnostics") {
+            options.diagnostics = true;
+        } else if (arg == "--diagnostics-log" && hasValue) {
+            options.diagnosticsLog = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        } else if (args.empty() && arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.empty()) {
+        PrintUsage();
+        return 2;
+    }
+
+    if (args[0] == "generate") {
+        if (!Crypto::init()) {
+            return 1;
+        }
+        return RunGenerate(args);
+    }
+    if (args[0] == "bloom") {
+        return RunBloom(args);
+    }
+
+    std::vector<json> ops;
+    if (args[0] == "batch" && args.size() == 2) {
+        if (!ReadBatchFile(args[1], ops)) {
+            return 2;
+        }
+    } else {
+        json op;
+        if (!ParseCommand(args, op)) {
+            PrintUsage();
+            return 2;
+        }
+        ops.push_back(op);
+    }
+
+    if (!Crypto::init()) {
+        return 1;
+    }
+
+    Diagnostics::setEnabled(options.diagnostics);
+    if (!options.diagnosticsLog.empty() && !Diagnostics::openLog(options.diagnosticsLog)) {
+        std::cerr << "Failed to open " << options.diagnosticsLog << "." << std::endl;
+        return 1;
+    }
+    DiagnosticsReport report{ options.diagnostics };
+
+    // 2. Unlock once, deriving the key a single time for the whole batch.
+    // A missing vault is created, but only by commands that write.
+    std::string password;
+    if (!GetMasterPassword(options, password)) {
+        return 1;
+    }
+    Vault vault;
+    bool exists = std::filesystem::exists(options.vaultPath);
+    bool unlocked = exists
+        ? vault.load(options.vaultPath, password)
+        : vault.setMasterPassword(password, Crypto::calibrateKdf(options.kdfMs));
+    if (!unlocked) {
+        std::cerr << "Failed to unlock " << options.vaultPath << "." << std::endl;
+        return 1;
+    }
+
+    // 3. Apply every operation in memory; stop at the first failure without saving
+    Batch batch{ vault, options };
+    for (size_t i = 0; i < ops.size(); ++i) {
+        bool ok;
+        try {
+            ok = ApplyOperation(batch, ops[i]);
+        }
+        catch (const json::exception& e) {
+            std::cerr << "Invalid operation " << ops[i].dump() << ": " << e.what() << std::endl;
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Operation " << (i + 1) << " of " << ops.size() << " failed; nothing was saved." << std::endl;
+            return 1;
+        }
+    }
+    std::cout.flush();
+
+    bool keyslots = batch.passwd || batch.createRecoveryKey || batch.removeRecoveryKey;
+    if ((!batch.changed && !keyslots) || (!exists && vault.entries().empty())) {
+        Crypto::wipe(password);
+        return 0; // Nothing to write; don't create an empty vault
+    }
+
+    // 4. A new data key (and freshly calibrated costs) makes the save a full
+    // rewrite. Without a new password, the current one is kept. The recovery
+    // key only wraps the old data key, so it is never dropped silently.
+    if (batch.reencrypt) {
+        if (vault.hasRecoveryKey() && !batch.createRecoveryKey && !batch.removeRecoveryKey && !options.dropRecoveryKey) {
+            std::cerr << "reencrypt: the vault has a recovery key, which won't open the new data key. Pass "
+                         "--drop-recovery-key to remove it, or also run recovery-key for a new one. Nothing was saved." << std::endl;
+            Crypto::wipe(password);
+            return 1;
+        }
+        if (!options.newPasswordFile.empty() && !ReadPasswordFile(options.newPasswordFile, password)) {
+            Crypto::wipe(password);
+            return 1;
+        }
+        Crypto::KdfParams kdf = Crypto::calibrateKdf(options.kdfMs);
+        if (!vault.setMasterPassword(password, kdf)) {
+            Crypto::wipe(password);
+            return 1;
+        }
+        PrintKdf(kdf);
+    } else if (batch.passwd) {
+        // Only the password's keyslot changes; the data stays as it is
+        std::string newPassword;
+        if (!GetNewPassword(options, newPassword)) {
+            Crypto::wipe(password);
+            return 1;
+        }
+        Crypto::KdfParams kdf = Crypto::calibrateKdf(options.kdfMs);
+        bool changed = vault.changeMasterPassword(options.vaultPath, password, newPassword, kdf);
+        Crypto::wipe(newPassword);
+        if (!changed) {
+            std::cerr << "Failed to change the master password." << std::endl;
+            Crypto::wipe(password);
+            return 1;
+        }
+        PrintKdf(kdf);
+        std::cerr << "Master password changed." << std::endl;
+    }
+    Crypto::wipe(password);
+
+    if (batch.removeRecoveryKey) {
+        if (!vault.removeRecoveryKey(options.vaultPath)) {
+            std::cerr << "Failed to remove the recovery key." << std::endl;
+            return 1;
+        }
+        std::cerr << "Recovery key removed." << std::endl;
+    }
+    if (batch.createRecoveryKey) {
+        std::optional<std::string> recoveryKey = vault.createRecoveryKey(options.vaultPath);
+        if (!recoveryKey) {
+            std::cerr << "Failed to create a recovery key." << std::endl;
+            return 1;
+        }
+        std::cout << *recoveryKey << std::endl;
+        Crypto::wipe(*recoveryKey);
+        std::cerr << "Recovery key created. Store it somewhere safe; it won't be shown again." << std::endl;
+    }
+    if (!batch.changed) {
+        return 0;
+    }
+
+    // 5. One save for the whole batch: appended records, or a single rewrite
+    // once that's smaller
+    auto start = std::chrono::steady_clock::now();
+    if (!vault.save(options.vaultPath)) {
+        std::cerr << "Failed to save " << options.vaultPath << "." << std::endl;
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Applied " << ops.size() << " operations (" << batch.added << " added, " << batch.deleted
+              << " deleted); saved " << vault.entries().size() << " entries in " << (int)ms << " ms." << std::endl;
+    return 0;
+}
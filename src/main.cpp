@@ -4,6 +4,9 @@
 #include <chrono>
 #include <fstream>
 #include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <optional>
 
 // GLAD (must be included before GLFW)
 #include <glad/glad.h>
@@ -16,8 +19,19 @@
 
 // Our custom classes
 #include "Crypto.h"
+#include "Diagnostics.h"
 #include <sodium.h> // This also includes <sodium.h> for us
 #include "Vault.h"
+#include "UnlockJob.h"
+#include "AutoSaver.h"
+#include "BreachAudit.h"
+#include "BreachAuditJob.h"
+#include "EntryView.h"
+#include "FrameScheduler.h"
+#include "Importer.h"
+#include "PasswordChangeJob.h"
+#include "PasswordGenerator.h"
+#include "ThreadPool.h"
 
 // --- Application State ---
 enum class AppState {
@@ -25,15 +39,26 @@ enum class AppState {
     Unlocked
 };
 
+// Edits the Undo button can take back; each holds a snapshot that shares
+// all but the changed pages with the vault
+const size_t UNDO_STEPS = 100;
+
 // --- Helper Functions ---
 static void glfw_error_callback(int error, const char* description) {
     std::cerr << "Glfw Error " << error << ": " << description << std::endl;
 }
 
-uint64_t GetCurrentTimeMillis() {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()
-    ).count();
+std::string FormatBytes(uint64_t bytes) {
+    const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    double value = (double)bytes;
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        ++unit;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+    return buffer;
 }
 
 void CenterWindow(GLFWwindow* window, int display_w, int display_h) {
@@ -41,68 +66,171 @@ void CenterWindow(GLFWwindow* window, int display_w, int display_h) {
     ImGui::SetNextWindowPos(ImVec2((display_w - 700) * 0.5f, (display_h - 500) * 0.5f), ImGuiCond_FirstUseEver);
 }
 
-// --- NEW: Password Generator ---
-std::string GeneratePassword(int length, bool use_upper, bool use_lower, bool use_numbers, bool use_symbols) {
-    const std::string UPPERCASE = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    const std::string LOWERCASE = "abcdefghijklmnopqrstuvwxyz";
-    const std::string NUMBERS = "0123456789";
-    const std::string SYMBOLS = "!@#$%^&*()_+-=[]{};:,.<>/?";
+// True while any key is held or in the frame it is let go. Keys that type
+// nothing (Enter, Escape, arrows, Ctrl+Z) never reach the character queue.
+bool AnyKeyActive() {
+    for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; ++key) {
+        if (ImGui::IsKeyDown((ImGuiKey)key) || ImGui::IsKeyReleased((ImGuiKey)key)) return true;
+    }
+    return false;
+}
 
-    std::string char_set = "";
-    if (use_upper) char_set += UPPERCASE;
-    if (use_lower) char_set += LOWERCASE;
-    if (use_numbers) char_set += NUMBERS;
-    if (use_symbols) char_set += SYMBOLS;
+const char* LoadPhaseLabel(Vault::LoadPhase phase) {
+    switch (phase) {
+    case Vault::LoadPhase::ReadingFile: return "Reading vault file";
+    case Vault::LoadPhase::DerivingKey: return "Deriving key";
+    case Vault::LoadPhase::Decrypting:  return "Decrypting";
+    case Vault::LoadPhase::Parsing:     return "Loading entries";
+    }
+    return "";
+}
 
-    if (char_set.empty()) {
-        return "Invalid settings";
+// Frame rate, frame time and CPU use, to check that an idle window stays idle
+void RenderFrameStats(const FrameScheduler& scheduler, bool& open) {
+    if (!open) return;
+    const FrameScheduler::Stats& stats = scheduler.stats();
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.6f);
+    if (ImGui::Begin("Frame Stats", &open, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+        ImGui::Text("%.1f frames/s, %.2f ms each", stats.framesPerSecond, stats.frameMs);
+        ImGui::Text("CPU %.1f%%, idle %.0f%% of the time", stats.cpuPercent, stats.idlePercent);
+        ImGui::Text("%llu frames drawn", (unsigned long long)stats.frames);
+        ImGui::TextDisabled("Shown, this window redraws once a second.");
     }
+    ImGui::End();
+}
 
-    std::string password;
-    password.reserve(length);
+// Per-phase timings of unlock, save and crypto (see Diagnostics.h)
+void RenderDiagnostics(bool& open, bool& showFrameStats) {
+    if (!open) return;
+    ImGui::SetNextWindowSize(ImVec2(640, 320), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Diagnostics", &open)) {
+        ImGui::End();
+        return;
+    }
 
-    for (int i = 0; i < length; ++i) {
-        // randombytes_uniform(N) securely generates a number between 0 and N-1
-        uint32_t index = randombytes_uniform((uint32_t)char_set.length());
-        password += char_set[index];
+    bool recording = Diagnostics::enabled();
+    if (ImGui::Checkbox("Record timings", &recording)) {
+        Diagnostics::setEnabled(recording);
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        Diagnostics::reset();
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Frame stats", &showFrameStats);
+    ImGui::TextDisabled("Phases nest: load.decrypt includes the crypto.open calls it makes.");
 
-    return password;
+    std::vector<Diagnostics::PhaseStats> stats = Diagnostics::stats();
+    if (stats.empty()) {
+        ImGui::TextUnformatted(recording ? "Nothing timed yet. Unlock or save the vault." : "Turn on recording, then unlock or save the vault.");
+    }
+    else if (ImGui::BeginTable("Phases", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("Total ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("Bytes");
+        ImGui::TableSetupColumn("MB/s");
+        ImGui::TableHeadersRow();
+        for (const auto& phase : stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(phase.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)phase.calls);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", phase.lastMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", phase.totalMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", phase.maxMs);
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(phase.bytes > 0 ? FormatBytes(phase.bytes).c_str() : "");
+            ImGui::TableNextColumn();
+            if (phase.bytes > 0 && phase.totalMs > 0.0) {
+                ImGui::Text("%.1f", phase.bytes / (1024.0 * 1024.0) / (phase.totalMs / 1000.0));
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
 }
 
 // --- Main UI Rendering Functions ---
-void RenderLoginScreen(AppState& currentState, Vault& vault, char* passwordBuffer, std::string& vaultFilepath, std::string& loginError) {
+void RenderLoginScreen(AppState& currentState, Vault& vault, UnlockJob& unlockJob, char* passwordBuffer, std::string& vaultFilepath, std::string& loginError, bool& showDiagnostics) {
     ImGui::Begin("Login to Vault");
-    ImGui::Text("Enter Master Password:");
+
+    // The unlock runs on a background thread; keep the inputs frozen meanwhile
+    bool unlocking = unlockJob.status() == UnlockJob::Status::Running;
+    ImGui::BeginDisabled(unlocking);
+    ImGui::Text("Enter Master Password (or recovery key):");
     ImGui::InputText("##Password", passwordBuffer, 128, ImGuiInputTextFlags_Password);
     ImGui::InputText("Vault File", &vaultFilepath[0], 256);
 
     if (ImGui::Button("Unlock")) {
-        if (vault.load(vaultFilepath, passwordBuffer)) {
-            currentState = AppState::Unlocked;
-            loginError = "";
-        }
-        else {
-            std::ifstream f(vaultFilepath.c_str());
-            if (!f.good()) {
-                currentState = AppState::Unlocked;
-                loginError = "New vault created. Click 'Save' to protect it.";
-            } else {
-                loginError = "Wrong password or corrupt vault file.";
-            }
+        loginError = "";
+        unlockJob.start(vaultFilepath, passwordBuffer);
+    }
+    ImGui::EndDisabled();
+
+    if (unlocking) {
+        ImGui::Text("%s... (%.1f s)", LoadPhaseLabel(unlockJob.phase()), unlockJob.elapsedSeconds());
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            unlockJob.cancel();
+            loginError = "Unlock cancelled.";
         }
     }
+
+    // Hand a finished job's vault over to the UI thread
+    if (unlockJob.status() == UnlockJob::Status::Succeeded) {
+        bool createdNew = unlockJob.createdNewVault();
+        vault = unlockJob.takeVault();
+        vault.setHistoryLimit(UNDO_STEPS);
+        // The session key is derived; the password itself is no longer needed
+        for (int i = 0; i < 128; ++i) passwordBuffer[i] = 0;
+        currentState = AppState::Unlocked;
+        loginError = createdNew ? "New vault created. Click 'Save' to protect it." : "";
+    }
+    else if (unlockJob.status() == UnlockJob::Status::Failed) {
+        loginError = unlockJob.error();
+        unlockJob.reset();
+    }
+
     if (!loginError.empty()) {
         ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", loginError.c_str());
     }
+
+    // Turn recording on here to see where a slow unlock spends its time
+    if (ImGui::Button("Diagnostics")) {
+        showDiagnostics = true;
+    }
     ImGui::End();
 }
 
-void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer, std::string& vaultFilepath, std::string& loginError) {
-    static int selectedEntry = -1;
+void RenderMainVault(AppState& currentState, Vault& vault, AutoSaver& autoSaver, BreachAuditJob& auditJob, PasswordChangeJob& passwordJob, char* passwordBuffer, std::string& vaultFilepath, std::string& loginError, bool& showDiagnostics) {
+    static EntryHandle selectedEntry; // Survives other entries being deleted
+    // The selected entry's password and notes, opened once per selection
+    // (or change to the vault) rather than every frame
+    static std::optional<EntrySecrets> shownSecrets;
+    static EntryHandle shownEntry;
+    static uint64_t shownRevision = 0;
+    // The Add/Edit form: the entry being edited and its input buffers. They
+    // hold the password and notes in the clear, so they are wiped as soon as
+    // the form closes (however it closes) and when the vault locks.
     static PasswordEntry currentEntry;
     static bool showAddEditPopup = false;
+    static bool editFormOpen = false;
+    static char titleBuf[128], userBuf[128], passBuf[128], urlBuf[256], notesBuf[512];
+    auto wipeEditForm = [] {
+        Crypto::wipe(currentEntry.password);
+        Crypto::wipe(currentEntry.notes);
+        currentEntry = PasswordEntry();
+        sodium_memzero(titleBuf, sizeof(titleBuf));
+        sodium_memzero(userBuf, sizeof(userBuf));
+        sodium_memzero(passBuf, sizeof(passBuf));
+        sodium_memzero(urlBuf, sizeof(urlBuf));
+        sodium_memzero(notesBuf, sizeof(notesBuf));
+    };
     static char filter[128] = "";
+    static int sortOrder = (int)EntryView::SortOrder::Title;
+    static int show = (int)EntryView::Show::All;
     
     // --- NEW: Generator state ---
     static bool showPasswordGenerator = false;
@@ -111,57 +239,144 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
     static bool gen_use_lower = true;
     static bool gen_use_numbers = true;
     static bool gen_use_symbols = true;
+    static int gen_mode = 0; // 0: characters, 1: passphrase
+    static char gen_custom_charset[128] = "";
+    static int gen_words = 6;
+    static char gen_separator[8] = "-";
+
+    // Entry id -> times seen, from the last breach audit
+    static std::unordered_map<uint64_t, uint64_t> breachedEntries;
 
     ImGui::Begin("My Vault");
 
     if (ImGui::Button("Lock Vault")) {
-        vault.clear();
-        for (int i = 0; i < 128; ++i) passwordBuffer[i] = 0;
-        currentState = AppState::Locked;
-        loginError = "";
-        ImGui::End();
-        return;
+        // Get pending edits onto disk before the key goes away
+        if (!autoSaver.flush(vault, vaultFilepath)) {
+            loginError = "Failed to save vault! Not locking, to keep your changes.";
+        } else {
+            vault.clear(); // Also wipes the session key
+            auditJob.cancel();
+            passwordJob.cancel();
+            breachedEntries.clear();
+            shownSecrets.reset();
+            wipeEditForm();
+            for (int i = 0; i < 128; ++i) passwordBuffer[i] = 0;
+            currentState = AppState::Locked;
+            loginError = "";
+            ImGui::End();
+            return;
+        }
     }
     ImGui::SameLine();
     if (ImGui::Button("Save Vault")) {
-        if (!vault.save(vaultFilepath, passwordBuffer)) {
-            loginError = "Failed to save vault!";
-        } else {
-            loginError = "Vault saved successfully.";
-        }
+        // Written by the autosave worker, so the UI doesn't stall on I/O
+        autoSaver.requestSave();
+    }
+    ImGui::SameLine();
+    bool autosaveEnabled = autoSaver.enabled();
+    if (ImGui::Checkbox("Autosave", &autosaveEnabled)) {
+        autoSaver.setEnabled(autosaveEnabled);
     }
     ImGui::SameLine();
+    // Ctrl+Z / Ctrl+Y too, unless a text field has the keyboard (it has its own undo)
+    const ImGuiIO& io = ImGui::GetIO();
+    bool undoKey = io.KeyCtrl && !io.WantTextInput && ImGui::IsKeyPressed(ImGuiKey_Z, false);
+    bool redoKey = io.KeyCtrl && !io.WantTextInput && ImGui::IsKeyPressed(ImGuiKey_Y, false);
+    ImGui::BeginDisabled(!vault.canUndo());
+    std::string undoButton = vault.canUndo() ? "Undo " + vault.undoLabel() + "###Undo" : "Undo###Undo";
+    if (ImGui::Button(undoButton.c_str()) || (undoKey && vault.canUndo())) {
+        vault.undo(); // The autosave picks the change up like any other
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!vault.canRedo());
+    std::string redoButton = vault.canRedo() ? "Redo " + vault.redoLabel() + "###Redo" : "Redo###Redo";
+    if (ImGui::Button(redoButton.c_str()) || (redoKey && vault.canRedo())) {
+        vault.redo();
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
     if (ImGui::Button("Add New Entry")) {
-        currentEntry = PasswordEntry();
-        currentEntry.id = GetCurrentTimeMillis();
+        wipeEditForm();
+        currentEntry.id = vault.newEntryId();
         showAddEditPopup = true;
         ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_Appearing);
         ImGui::OpenPopup("Add/Edit Entry");
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Import...")) {
+        ImGui::OpenPopup("Import Entries");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Master Password...")) {
+        ImGui::OpenPopup("Master Password");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Breach Audit...")) {
+        ImGui::OpenPopup("Breach Audit");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Diagnostics")) {
+        showDiagnostics = true;
+    }
 
     if (!loginError.empty()) {
         ImGui::Text("%s", loginError.c_str());
     }
 
+    // --- Save status ---
+    if (!autoSaver.lastError().empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", autoSaver.lastError().c_str());
+        ImGui::SameLine();
+    }
+    if (autoSaver.saveInFlight()) {
+        ImGui::Text("Saving... (%zu pending)", autoSaver.queueDepth());
+    } else if (autoSaver.queueDepth() > 0) {
+        ImGui::Text("%zu unsaved change(s)", autoSaver.queueDepth());
+    } else if (autoSaver.savesCompleted() > 0) {
+        ImGui::Text("All changes saved (last save %.1f ms)", autoSaver.lastSaveMs());
+    }
+
     ImGui::Separator();
     ImGui::InputText("Filter", filter, IM_ARRAYSIZE(filter));
+    ImGui::SameLine();
+    static const char* sortOrders[] = { "Title", "Recently modified" };
+    ImGui::SetNextItemWidth(150);
+    ImGui::Combo("Sort", &sortOrder, sortOrders, IM_ARRAYSIZE(sortOrders));
+    ImGui::SameLine();
+    static const char* showOptions[] = { "All", "Reused", "Weak", "Reused or weak" };
+    ImGui::SetNextItemWidth(150);
+    ImGui::Combo("Show", &show, showOptions, IM_ARRAYSIZE(showOptions));
+
+    // Counters kept by the vault as entries change; nothing is recomputed here
+    const PasswordAnalyzer& analysis = vault.analysis();
+    if (analysis.reusedCount() > 0 || analysis.weakCount() > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "%zu entries share a password; %zu have a weak one.",
+            analysis.reusedCount(), analysis.weakCount());
+    }
     ImGui::Separator();
 
     // --- Left Pane (Entry List) ---
+    // The filtered, sorted rows are cached and only recomputed when the filter,
+    // the sort order or the entries change; only the visible rows are drawn.
+    static EntryView entryView;
+    entryView.update(vault, filter, (EntryView::SortOrder)sortOrder, (EntryView::Show)show);
+
     ImGui::BeginChild("EntryList", ImVec2(200, 0), true);
-    int entry_n = 0;
-    for (const auto& entry : vault.getEntries()) {
-        std::string filterLower = filter;
-        std::transform(filterLower.begin(), filterLower.end(), filterLower.begin(), ::tolower);
-        std::string titleLower = entry.title;
-        std::transform(titleLower.begin(), titleLower.end(), titleLower.begin(), ::tolower);
-        
-        if (filter[0] == '\0' || titleLower.find(filterLower) != std::string::npos) {
-            if (ImGui::Selectable(entry.title.c_str(), selectedEntry == entry_n)) {
-                selectedEntry = entry_n;
+    ImGuiListClipper clipper;
+    clipper.Begin((int)entryView.size());
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            EntryHandle handle = entryView.rows()[row];
+            EntryRef entry = vault.getEntry(handle);
+            if (!entry) continue;
+
+            ImGui::PushID((int)handle.slot); // Titles needn't be unique
+            if (ImGui::Selectable(entry.title().data(), selectedEntry == handle)) {
+                selectedEntry = handle;
             }
+            ImGui::PopID();
         }
-        entry_n++;
     }
     ImGui::EndChild();
 
@@ -169,44 +384,116 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
 
     // --- Right Pane (Entry Details) ---
     ImGui::BeginChild("EntryDetails", ImVec2(0, 0), true);
-    if (selectedEntry != -1 && selectedEntry < vault.getEntries().size()) {
-        const auto& entry = vault.getEntries()[selectedEntry];
-        
-        ImGui::Text("Title: %s", entry.title.c_str());
+    if (EntryRef entry = vault.getEntry(selectedEntry)) {
+        // The views are NUL-terminated, so data() works as a C string
+        if (!shownSecrets || !(shownEntry == selectedEntry) || shownRevision != vault.revision()) {
+            shownSecrets = entry.secrets();
+            shownEntry = selectedEntry;
+            shownRevision = vault.revision();
+        }
+        static const EntrySecrets noSecrets;
+        const EntrySecrets& secrets = shownSecrets ? *shownSecrets : noSecrets;
+
+        ImGui::Text("Title: %s", entry.title().data());
+        auto breached = breachedEntries.find(entry.id());
+        if (breached != breachedEntries.end()) {
+            if (breached->second > 0) {
+                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "This password appears in a breach (%llu times). Change it.", (unsigned long long)breached->second);
+            } else {
+                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "This password appears in a breach. Change it.");
+            }
+        }
         ImGui::Separator();
         
         ImGui::Text("Username:");
-        ImGui::InputText("##Username", (char*)entry.username.c_str(), entry.username.size(), ImGuiInputTextFlags_ReadOnly);
-        ImGui::SameLine(); if (ImGui::Button("Copy##user")) ImGui::SetClipboardText(entry.username.c_str());
+        ImGui::InputText("##Username", (char*)entry.username().data(), entry.username().size(), ImGuiInputTextFlags_ReadOnly);
+        ImGui::SameLine(); if (ImGui::Button("Copy##user")) ImGui::SetClipboardText(entry.username().data());
         
         ImGui::Text("Password:");
-        ImGui::InputText("##Password", (char*)entry.password.c_str(), entry.password.size(), ImGuiInputTextFlags_Password | ImGuiInputTextFlags_ReadOnly);
-        ImGui::SameLine(); if (ImGui::Button("Copy##pass")) ImGui::SetClipboardText(entry.password.c_str());
+        ImGui::InputText("##Password", (char*)secrets.password.c_str(), secrets.password.size(), ImGuiInputTextFlags_Password | ImGuiInputTextFlags_ReadOnly);
+        ImGui::SameLine(); if (ImGui::Button("Copy##pass")) ImGui::SetClipboardText(secrets.password.c_str());
+        if (entry.passwordSummary().hasPassword) {
+            ImGui::Text("Strength: %s", PasswordAnalyzer::label(analysis.strength(entry.id())));
+            size_t sharing = analysis.reuseCount(entry.id());
+            if (sharing > 1) {
+                ImGui::SameLine();
+                ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Also used by %zu other entries", sharing - 1);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::BeginTooltip();
+                    for (uint64_t id : analysis.sharingWith(entry.id())) {
+                        EntryRef other = vault.getEntry(vault.findEntry(id));
+                        if (other && id != entry.id()) ImGui::TextUnformatted(other.title().data());
+                    }
+                    ImGui::EndTooltip();
+                }
+            }
+        }
 
-        ImGui::Text("URL: %s", entry.url.c_str());
-        ImGui::Text("Notes:\n%s", entry.notes.c_str());
+        ImGui::Text("URL: %s", entry.url().data());
+        ImGui::Text("Notes:\n%s", secrets.notes.c_str());
+
+        // --- Attachments ---
+        // Contents stay encrypted on disk; they're only decrypted on export.
+        static char attachmentPath[512] = "";
+        static std::string attachmentStatus;
+        ImGui::Separator();
+        ImGui::Text("Attachments:");
+        ImGui::InputText("Path##attachment", attachmentPath, IM_ARRAYSIZE(attachmentPath));
+        ImGui::SameLine();
+        if (ImGui::Button("Attach File") && attachmentPath[0] != '\0') {
+            attachmentStatus = vault.attachFile(vaultFilepath, entry.id(), attachmentPath)
+                ? "Attached." : "Failed to attach file.";
+        }
+
+        // Act after the loop; attaching or removing changes entry.attachments()
+        const Attachment* toExport = nullptr;
+        std::string toRemove;
+        for (const auto& attachment : entry.attachments()) {
+            ImGui::PushID(attachment.id.c_str());
+            ImGui::Text("%s (%s)", attachment.name.c_str(), FormatBytes(attachment.size).c_str());
+            ImGui::SameLine();
+            if (ImGui::Button("Export")) toExport = &attachment;
+            ImGui::SameLine();
+            if (ImGui::Button("Remove")) toRemove = attachment.id;
+            ImGui::PopID();
+        }
+        if (toExport) {
+            // Export to the path box: a directory gets the original file name
+            std::filesystem::path dest = attachmentPath[0] != '\0' ? attachmentPath : ".";
+            std::error_code ec;
+            if (std::filesystem::is_directory(dest, ec)) dest /= toExport->name;
+            attachmentStatus = vault.exportAttachment(vaultFilepath, *toExport, dest.string())
+                ? "Exported to " + dest.string() : "Failed to export attachment.";
+        }
+        if (!toRemove.empty()) {
+            vault.removeAttachment(entry.id(), toRemove);
+        }
+        if (!attachmentStatus.empty()) {
+            ImGui::Text("%s", attachmentStatus.c_str());
+        }
 
         ImGui::Separator();
         if (ImGui::Button("Edit")) {
-            currentEntry = entry;
+            wipeEditForm();
+            currentEntry = entry.toEntry();
             showAddEditPopup = true;
             ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_Appearing);
             ImGui::OpenPopup("Add/Edit Entry");
         }
         ImGui::SameLine();
         if (ImGui::Button("Delete")) {
-            vault.deleteEntry(entry.id);
-            selectedEntry = -1;
+            vault.deleteEntry(entry.id());
+            selectedEntry = EntryHandle();
         }
     } else {
+        shownSecrets.reset();
         ImGui::Text("Select an entry to view details.");
     }
     ImGui::EndChild();
 
     // --- Add/Edit Popup Modal ---
     if (ImGui::BeginPopupModal("Add/Edit Entry", &showAddEditPopup)) {
-        static char titleBuf[128], userBuf[128], passBuf[128], urlBuf[256], notesBuf[512];
-        
+        editFormOpen = true;
         if (showAddEditPopup) {
             strncpy(titleBuf, currentEntry.title.c_str(), sizeof(titleBuf) - 1);
             strncpy(userBuf, currentEntry.username.c_str(), sizeof(userBuf) - 1);
@@ -227,6 +514,9 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
             ImGui::OpenPopup("Password Generator");
         }
         // --- End NEW ---
+        if (passBuf[0] != '\0') {
+            ImGui::TextDisabled("Strength: %s", PasswordAnalyzer::label(PasswordAnalyzer::rate(passBuf)));
+        }
 
         ImGui::InputText("URL", urlBuf, IM_ARRAYSIZE(urlBuf));
         ImGui::InputTextMultiline("Notes", notesBuf, IM_ARRAYSIZE(notesBuf));
@@ -238,16 +528,15 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
             currentEntry.url = urlBuf;
             currentEntry.notes = notesBuf;
 
-            PasswordEntry* existing = vault.getEntryForEdit(currentEntry.id);
-            if (existing) {
-                *existing = currentEntry;
-            } else {
-                vault.addEntry(currentEntry);
-            }
+            vault.addEntry(currentEntry); // Replaces the entry if it already exists
+            wipeEditForm();
+            editFormOpen = false;
             ImGui::CloseCurrentPopup();
         }
         ImGui::SameLine();
         if (ImGui::Button("Cancel")) {
+            wipeEditForm();
+            editFormOpen = false;
             ImGui::CloseCurrentPopup();
         }
 
@@ -255,20 +544,47 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
         if (ImGui::BeginPopupModal("Password Generator", &showPasswordGenerator)) {
             ImGui::Text("Password Options");
             ImGui::Separator();
-            ImGui::SliderInt("Length", &gen_length, 8, 128);
-            ImGui::Checkbox("Uppercase (A-Z)", &gen_use_upper);
-            ImGui::Checkbox("Lowercase (a-z)", &gen_use_lower);
-            ImGui::Checkbox("Numbers (0-9)", &gen_use_numbers);
-            ImGui::Checkbox("Symbols (!@#...)", &gen_use_symbols);
+            ImGui::RadioButton("Characters", &gen_mode, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("Passphrase", &gen_mode, 1);
+
+            // The entropy shown is what the settings give, whatever comes out
+            double entropy = 0.0;
+            std::string charset;
+            if (gen_mode == 0) {
+                ImGui::SliderInt("Length", &gen_length, 8, 128);
+                ImGui::Checkbox("Uppercase (A-Z)", &gen_use_upper);
+                ImGui::Checkbox("Lowercase (a-z)", &gen_use_lower);
+                ImGui::Checkbox("Numbers (0-9)", &gen_use_numbers);
+                ImGui::Checkbox("Symbols (!@#...)", &gen_use_symbols);
+                ImGui::InputText("Custom characters", gen_custom_charset, IM_ARRAYSIZE(gen_custom_charset));
+                ImGui::TextDisabled("Custom characters replace the classes above.");
+
+                unsigned classes = PasswordGenerator::classMask(gen_use_upper, gen_use_lower, gen_use_numbers, gen_use_symbols);
+                charset = gen_custom_charset[0] != '\0' ? std::string(gen_custom_charset) : std::string(PasswordGenerator::charset(classes));
+                std::sort(charset.begin(), charset.end());
+                charset.erase(std::unique(charset.begin(), charset.end()), charset.end());
+                entropy = PasswordGenerator::entropyBits(charset.size(), gen_length);
+            } else {
+                ImGui::SliderInt("Words", &gen_words, 3, 12);
+                ImGui::InputText("Separator", gen_separator, IM_ARRAYSIZE(gen_separator));
+                entropy = PasswordGenerator::entropyBits(PasswordGenerator::defaultWordlist().size(), gen_words);
+            }
+            ImGui::Text("Entropy: %.0f bits", entropy);
             ImGui::Separator();
 
             if (ImGui::Button("Generate & Use")) {
-                std::string new_pass = GeneratePassword(gen_length, gen_use_upper, gen_use_lower, gen_use_numbers, gen_use_symbols);
-                // Copy the new password into the Add/Edit buffer
-                strncpy(passBuf, new_pass.c_str(), sizeof(passBuf) - 1);
-                passBuf[sizeof(passBuf) - 1] = 0; // Ensure null termination
-                showPasswordGenerator = false;
-                ImGui::CloseCurrentPopup();
+                auto batch = gen_mode == 0
+                    ? PasswordGenerator::generateBatch(charset, gen_length, 1)
+                    : PasswordGenerator::generatePassphrases(PasswordGenerator::defaultWordlist(), gen_words, gen_separator, 1);
+                if (batch) {
+                    // Copy the new password into the Add/Edit buffer
+                    strncpy(passBuf, batch->passwords.front().c_str(), sizeof(passBuf) - 1);
+                    passBuf[sizeof(passBuf) - 1] = 0; // Ensure null termination
+                    Crypto::wipe(batch->passwords.front());
+                    showPasswordGenerator = false;
+                    ImGui::CloseCurrentPopup();
+                }
             }
             ImGui::SameLine();
             if (ImGui::Button("Cancel")) {
@@ -279,6 +595,189 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
         }
         // --- End NEW ---
 
+        ImGui::EndPopup();
+    } else if (editFormOpen) {
+        // Closed some other way: the title bar's close button or Escape
+        wipeEditForm();
+        editFormOpen = false;
+    }
+
+    // --- Import Popup Modal ---
+    static std::string importStatus;
+    if (ImGui::BeginPopupModal("Import Entries")) {
+        static char importPath[512] = "";
+        ImGui::Text("CSV or JSON export from a browser or another password manager:");
+        ImGui::InputText("File", importPath, IM_ARRAYSIZE(importPath));
+
+        if (ImGui::Button("Import")) {
+            // Parsed on every core, then added in one go
+            auto result = Importer::parseFile(importPath, ThreadPool::shared());
+            if (!result) {
+                importStatus = "Import failed; the file isn't a CSV or JSON export we recognize.";
+            } else {
+                size_t skipped = result->skippedRows;
+                size_t count = vault.importEntries(std::move(result->entries));
+                importStatus = "Imported " + std::to_string(count) + " entries" +
+                    (skipped > 0 ? " (" + std::to_string(skipped) + " empty rows skipped)." : ".");
+                ImGui::CloseCurrentPopup();
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            ImGui::CloseCurrentPopup();
+        }
+        if (!importStatus.empty()) {
+            ImGui::Text("%s", importStatus.c_str());
+        }
+        ImGui::EndPopup();
+    }
+
+    // --- Master Password Popup Modal ---
+    // Both only rewrite the keyslots in the vault's header (see Vault.h), so
+    // they take about one unlock's time however big the vault is. A password
+    // change derives two keys, so those run in the background and only the
+    // new slot is stored here, once the job is done.
+    static std::string keyslotStatus;
+    static std::string recoveryKey; // Shown until the popup closes, then wiped
+    static char currentBuf[128], newBuf[128], confirmBuf[128];
+    auto wipeBuffers = [] {
+        for (char* buffer : { currentBuf, newBuf, confirmBuf }) {
+            for (int i = 0; i < 128; ++i) buffer[i] = 0;
+        }
+    };
+    if (passwordJob.status() == PasswordChangeJob::Status::Succeeded) {
+        Crypto::Keyslot slot = passwordJob.takeSlot();
+        // The header is rewritten in place; nothing may be writing the file
+        if (autoSaver.flush(vault, vaultFilepath) && vault.replacePasswordSlot(vaultFilepath, slot)) {
+            keyslotStatus = "Master password changed.";
+            wipeBuffers();
+        } else {
+            keyslotStatus = "The vault couldn't be written; password not changed.";
+        }
+    }
+    else if (passwordJob.status() == PasswordChangeJob::Status::Failed) {
+        keyslotStatus = passwordJob.error();
+        passwordJob.reset();
+    }
+    if (ImGui::BeginPopupModal("Master Password")) {
+        bool changing = passwordJob.status() == PasswordChangeJob::Status::Running;
+        ImGui::BeginDisabled(changing);
+        ImGui::Text("Change master password:");
+        ImGui::InputText("Current password", currentBuf, IM_ARRAYSIZE(currentBuf), ImGuiInputTextFlags_Password);
+        ImGui::InputText("New password", newBuf, IM_ARRAYSIZE(newBuf), ImGuiInputTextFlags_Password);
+        ImGui::InputText("Confirm new password", confirmBuf, IM_ARRAYSIZE(confirmBuf), ImGuiInputTextFlags_Password);
+        if (ImGui::Button("Change Password")) {
+            if (newBuf[0] == '\0') {
+                keyslotStatus = "The new password can't be empty.";
+            } else if (strcmp(newBuf, confirmBuf) != 0) {
+                keyslotStatus = "The new passwords don't match.";
+            } else {
+                keyslotStatus.clear();
+                passwordJob.start(vault, currentBuf, newBuf);
+            }
+        }
+        ImGui::EndDisabled();
+        if (changing) {
+            ImGui::Text("Deriving keys... (%.1f s)", passwordJob.elapsedSeconds());
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel##password")) {
+                passwordJob.cancel();
+                keyslotStatus = "Password change cancelled.";
+            }
+        }
+
+        ImGui::Separator();
+        ImGui::BeginDisabled(changing);
+        ImGui::Text("Recovery key: %s", vault.hasRecoveryKey() ? "set" : "none");
+        if (ImGui::Button(vault.hasRecoveryKey() ? "Replace Recovery Key" : "Create Recovery Key")) {
+            Crypto::wipe(recoveryKey);
+            std::optional<std::string> created;
+            if (autoSaver.flush(vault, vaultFilepath)) {
+                created = vault.createRecoveryKey(vaultFilepath);
+            }
+            if (created) {
+                recoveryKey = std::move(*created);
+                keyslotStatus = "Write this key down and keep it safe. It unlocks the vault in place of the password and won't be shown again.";
+            } else {
+                keyslotStatus = "Failed to create a recovery key.";
+            }
+        }
+        if (vault.hasRecoveryKey()) {
+            ImGui::SameLine();
+            if (ImGui::Button("Remove Recovery Key")) {
+                Crypto::wipe(recoveryKey);
+                bool removed = autoSaver.flush(vault, vaultFilepath) && vault.removeRecoveryKey(vaultFilepath);
+                keyslotStatus = removed ? "Recovery key removed." : "Failed to remove the recovery key.";
+            }
+        }
+        ImGui::EndDisabled();
+        if (!recoveryKey.empty()) {
+            ImGui::InputText("##RecoveryKey", &recoveryKey[0], recoveryKey.size() + 1, ImGuiInputTextFlags_ReadOnly);
+            ImGui::SameLine();
+            if (ImGui::Button("Copy##recovery")) ImGui::SetClipboardText(recoveryKey.c_str());
+        }
+
+        if (!keyslotStatus.empty()) {
+            ImGui::TextWrapped("%s", keyslotStatus.c_str());
+        }
+        ImGui::Separator();
+        if (ImGui::Button("Close")) {
+            wipeBuffers();
+            Crypto::wipe(recoveryKey);
+            keyslotStatus.clear();
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+
+    // --- Breach Audit Popup Modal ---
+    // Offline: the corpus is a local download, memory-mapped (see BreachAudit.h).
+    // The audit runs in the background over a snapshot of the entries; its
+    // result is collected here even if the modal was closed meanwhile.
+    static std::string auditStatus;
+    if (auditJob.status() == BreachAuditJob::Status::Succeeded) {
+        BreachAudit::Report report = auditJob.takeReport();
+        breachedEntries.clear();
+        for (const auto& finding : report.findings) {
+            breachedEntries[finding.entryId] = finding.count;
+        }
+        auditStatus = "Checked " + std::to_string(report.checked) + " passwords: " +
+            std::to_string(report.findings.size()) + " found in the breach list.";
+    }
+    else if (auditJob.status() == BreachAuditJob::Status::Failed) {
+        auditStatus = auditJob.error();
+        auditJob.reset();
+    }
+    if (ImGui::BeginPopupModal("Breach Audit")) {
+        static char corpusPath[512] = "";
+        static char bloomPath[512] = "";
+        bool auditing = auditJob.status() == BreachAuditJob::Status::Running;
+        ImGui::Text("Sorted SHA-1 breach list (e.g. Pwned Passwords, ordered by hash):");
+        ImGui::InputText("Corpus", corpusPath, IM_ARRAYSIZE(corpusPath));
+        ImGui::InputText("Bloom filter (optional)", bloomPath, IM_ARRAYSIZE(bloomPath));
+
+        if (auditing) {
+            ImGui::ProgressBar(auditJob.progress());
+            if (ImGui::Button("Cancel")) {
+                auditJob.cancel();
+                auditStatus = "Audit cancelled.";
+            }
+        } else if (ImGui::Button("Check Passwords")) {
+            auditStatus.clear();
+            auditJob.start(corpusPath, bloomPath, vault.entries());
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Results")) {
+            breachedEntries.clear();
+            auditStatus.clear();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Close")) {
+            ImGui::CloseCurrentPopup();
+        }
+        if (!auditStatus.empty()) {
+            ImGui::TextWrapped("%s", auditStatus.c_str());
+        }
         ImGui::EndPopup();
     }
 
@@ -286,7 +785,7 @@ void RenderMainVault(AppState& currentState, Vault& vault, char* passwordBuffer,
 }
 
 // --- Main Function ---
-int main(int, char**) {
+int main(int argc, char** argv) {
     // --- 0. Initialize Libsodium ---
     if (!Crypto::init()) {
         std::cerr << "Failed to initialize crypto library!" << std::endl;
@@ -294,6 +793,23 @@ int main(int, char**) {
     }
     std::cout << "Crypto library initialized successfully." << std::endl;
 
+    // --diagnostics records phase timings from the start (so the first unlock
+    // is covered); --diagnostics-log FILE also writes them as JSON lines;
+    // --frame-stats shows the frame rate and CPU overlay
+    bool showFrameStats = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--diagnostics") {
+            Diagnostics::setEnabled(true);
+        } else if (arg == "--frame-stats") {
+            showFrameStats = true;
+        } else if (arg == "--diagnostics-log" && i + 1 < argc) {
+            if (!Diagnostics::openLog(argv[++i])) {
+                std::cerr << "Failed to open diagnostics log " << argv[i] << std::endl;
+            }
+        }
+    }
+
     // --- 1. Setup GLFW (Windowing) ---
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit()) return 1;
@@ -325,27 +841,77 @@ int main(int, char**) {
     // --- 4. Application State Variables ---
     AppState currentState = AppState::Locked;
     Vault vault;
+    UnlockJob unlockJob;
+    BreachAuditJob auditJob;
+    PasswordChangeJob passwordJob;
+    AutoSaver autoSaver;
     std::string vaultFilepath = "my_vault.db";
     char passwordBuffer[128] = { 0 };
     std::string loginError = "";
+    bool showDiagnostics = false;
+
+    // Frames are drawn on input, on timers and when a background job ends
+    // (see FrameScheduler); the jobs wake the loop with an empty event
+    FrameScheduler scheduler;
+    unlockJob.setNotifier([] { glfwPostEmptyEvent(); });
+    auditJob.setNotifier([] { glfwPostEmptyEvent(); });
+    passwordJob.setNotifier([] { glfwPostEmptyEvent(); });
+    autoSaver.setNotifier([] { glfwPostEmptyEvent(); });
     
     // --- Main loop ---
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        // Sleep until there's an event or the next frame is due
+        if (std::optional<double> wait = scheduler.waitSeconds()) {
+            if (*wait > 0.0) glfwWaitEventsTimeout(*wait);
+            else glfwPollEvents();
+        } else {
+            glfwWaitEvents();
+        }
+        scheduler.beginFrame();
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        // Input that arrives during the settle frames starts them over
+        ImGuiIO& frameIo = ImGui::GetIO();
+        if (frameIo.MouseDelta.x != 0.0f || frameIo.MouseDelta.y != 0.0f || frameIo.MouseWheel != 0.0f ||
+            ImGui::IsAnyMouseDown() || frameIo.InputQueueCharacters.Size > 0 || AnyKeyActive()) {
+            scheduler.requestFrame();
+        }
+
         // --- 5. Render UI based on state ---
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         CenterWindow(window, display_w, display_h);
 
         if (currentState == AppState::Locked) {
-            RenderLoginScreen(currentState, vault, passwordBuffer, vaultFilepath, loginError);
+            RenderLoginScreen(currentState, vault, unlockJob, passwordBuffer, vaultFilepath, loginError, showDiagnostics);
         } else {
-            RenderMainVault(currentState, vault, passwordBuffer, vaultFilepath, loginError);
+            RenderMainVault(currentState, vault, autoSaver, auditJob, passwordJob, passwordBuffer, vaultFilepath, loginError, showDiagnostics);
+            autoSaver.poll(vault, vaultFilepath);
+        }
+        RenderDiagnostics(showDiagnostics, showFrameStats);
+        RenderFrameStats(scheduler, showFrameStats);
+
+        // Timers for the next frame, re-armed every frame
+        if (unlockJob.status() == UnlockJob::Status::Running) {
+            scheduler.requestFrameIn(std::chrono::milliseconds(100)); // The phase and elapsed time
+        }
+        if (auditJob.status() == BreachAuditJob::Status::Running) {
+            scheduler.requestFrameIn(std::chrono::milliseconds(100)); // The audit's progress bar
+        }
+        if (passwordJob.status() == PasswordChangeJob::Status::Running) {
+            scheduler.requestFrameIn(std::chrono::milliseconds(100)); // The password change's elapsed time
+        }
+        if (currentState == AppState::Unlocked) {
+            if (auto due = autoSaver.nextPollDue()) scheduler.requestFrameAt(*due);
+        }
+        if (frameIo.WantTextInput) {
+            scheduler.requestFrameIn(std::chrono::milliseconds(400)); // The text cursor blinks
+        }
+        if (showFrameStats) {
+            scheduler.requestFrameIn(std::chrono::seconds(1));
         }
 
         // --- 6. Rendering ---
@@ -354,11 +920,15 @@ int main(int, char**) {
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        scheduler.endFrame();
 
         glfwSwapBuffers(window);
     }
 
     // --- 7. Cleanup ---
+    if (currentState == AppState::Unlocked) {
+        autoSaver.flush(vault, vaultFilepath); // Don't lose edits made just before closing
+    }
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();